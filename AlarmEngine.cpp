@@ -0,0 +1,107 @@
+#include "AlarmEngine.h"
+#include "EventStore.h"
+#include "MetricsHttpServer.h"
+#include <QDir>
+#include <QUrl>
+#include <QHostAddress>
+#include <QDateTime>
+#include <QDebug>
+
+AlarmEngine::AlarmEngine(const QString& imageDir, EventStore* store, QObject *parent)
+    : QObject(parent)
+    , m_imageDir(imageDir)
+    , m_store(store)
+    , m_alarmCount(0)
+    , m_detectionCount(0)
+{
+}
+
+QString AlarmEngine::saveAlarm(const QImage& image, const QString& stream, const QString& info, qint64 captureMs)
+{
+    if (image.isNull()) {
+        return QString();
+    }
+
+    // 确保报警图片目录存在
+    QDir dir(m_imageDir);
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    // 生成报警图片文件名，包含画面的采集时刻
+    if (captureMs <= 0) {
+        captureMs = QDateTime::currentMSecsSinceEpoch();
+    }
+    QString timestamp = QDateTime::fromMSecsSinceEpoch(captureMs).toString("yyyyMMdd_HHmmss_zzz");
+    QString fileName = dir.filePath(QString("ALARM_%1.jpg").arg(timestamp));
+    if (!image.save(fileName)) {
+        qWarning() << "报警图片保存失败:" << fileName;
+        return QString();
+    }
+    ++m_alarmCount;
+
+    // 报警事件入库，关联报警图片
+    if (m_store) {
+        EventRecord event;
+        event.timestamp = captureMs;
+        event.stream = stream;
+        event.type = "alarm";
+        event.message = info;
+        event.imagePath = fileName;
+        m_store->record(event);
+    }
+    return fileName;
+}
+
+void AlarmEngine::recordDetections(const QString& stream, const QVector<DetectionObject>& objects)
+{
+    m_detectionCount += objects.size();
+    if (!m_store || objects.isEmpty()) {
+        return;
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<EventRecord> events;
+    events.reserve(objects.size());
+    for (const DetectionObject& obj : objects) {
+        EventRecord event;
+        event.timestamp = now;
+        event.stream = stream;
+        event.type = "detection";
+        event.classId = obj.classId;
+        event.className = obj.className;
+        event.confidence = obj.confidence;
+        event.x = obj.x;
+        event.y = obj.y;
+        event.width = obj.width;
+        event.height = obj.height;
+        events.append(event);
+    }
+    m_store->record(events);
+}
+
+void AlarmEngine::collectMetrics(MetricsText& out) const
+{
+    out.counter("rtsp_alarms_total", "Alarm images saved after a detection.", m_alarmCount);
+    out.counter("rtsp_detections_total", "Detection objects received from the TCP clients.", m_detectionCount);
+}
+
+int AlarmEngine::matchStreamHost(const QString& host, const QStringList& urls)
+{
+    // IP地址按数值比较（IPv4映射的IPv6地址与IPv4相同），地址中是域名时按名称比较
+    QHostAddress peer(host);
+    for (int i = 0; i < urls.size(); ++i) {
+        QString urlHost = QUrl(urls[i]).host();
+        if (urlHost.isEmpty()) {
+            continue;
+        }
+        QHostAddress streamHost(urlHost);
+        bool matched = streamHost.isNull()
+            ? urlHost.compare(host, Qt::CaseInsensitive) == 0
+            : streamHost.isEqual(peer, QHostAddress::TolerantConversion);
+        if (matched) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,49 @@
+#ifndef ALARMENGINE_H
+#define ALARMENGINE_H
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "common.h"
+
+class EventStore;
+class MetricsText;
+
+/**
+ * @brief 报警处理：保存报警图片，把报警和检测目标写入事件数据库
+ *
+ * 不依赖界面，界面程序和无界面服务共用；事件数据库由调用者打开并传入（可以为空）。
+ */
+class AlarmEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    AlarmEngine(const QString& imageDir, EventStore* store, QObject *parent = nullptr);
+
+    QString imageDir() const { return m_imageDir; }
+
+    // 保存报警图片并记录报警事件，返回图片路径，失败返回空；
+    // captureMs为画面的采集时刻（FrameTiming::captureMs），图片名和事件时间都用它，0表示当前时间
+    QString saveAlarm(const QImage& image, const QString& stream, const QString& info, qint64 captureMs = 0);
+    // 每个检测目标记录为一条事件，同一帧的目标共用一个时间戳
+    void recordDetections(const QString& stream, const QVector<DetectionObject>& objects);
+
+    // 检测数据不带通道号：按上报设备的IP找到主机相同的视频流地址，返回其在urls中的下标，没有时返回-1。
+    // 界面程序和无界面服务用它确定检测/报警事件归属的视频流，没有匹配时以设备IP作为视频流标识
+    static int matchStreamHost(const QString& host, const QStringList& urls);
+
+    qint64 alarmCount() const { return m_alarmCount; }
+    qint64 detectionCount() const { return m_detectionCount; }
+    void collectMetrics(MetricsText& out) const;
+
+private:
+    QString m_imageDir;         // 报警图片目录
+    EventStore* m_store;
+    qint64 m_alarmCount;        // 累计报警次数
+    qint64 m_detectionCount;    // 累计检测目标数
+};
+
+#endif // ALARMENGINE_H
@@ -0,0 +1,46 @@
+#ifndef CAMERAPROFILE_H
+#define CAMERAPROFILE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+/**
+ * @brief 摄像头码流配置：同一台摄像头的子码流（低分辨率）和主码流（高分辨率）地址
+ *
+ * 网格中格子较小时解码子码流，1x1/2x2布局或放大画面时切换到主码流；录像始终使用主码流。
+ * 只配置了一个地址的摄像头两种情况都使用该地址。
+ */
+struct CameraProfile {
+    QString subUrl;            // 子码流地址（网格小画面）
+    QString mainUrl;           // 主码流地址，为空表示只有一路码流
+
+    CameraProfile() {}
+    explicit CameraProfile(const QString& url, const QString& main = QString())
+        : subUrl(url), mainUrl(main == url ? QString() : main) {}
+
+    bool hasMainStream() const { return !mainUrl.isEmpty(); }
+
+    // 按画面大小选择码流地址
+    QString urlFor(bool largeView) const {
+        if (subUrl.isEmpty() || (largeView && hasMainStream())) {
+            return mainUrl;
+        }
+        return subUrl;
+    }
+
+    // 录像和单路画面使用的地址
+    QString recordUrl() const { return urlFor(true); }
+
+    bool matches(const QString& url) const { return !url.isEmpty() && (url == subUrl || url == mainUrl); }
+
+    static QList<CameraProfile> fromUrls(const QStringList& urls) {
+        QList<CameraProfile> profiles;
+        for (const QString& url : urls) {
+            profiles.append(CameraProfile(url));
+        }
+        return profiles;
+    }
+};
+
+#endif // CAMERAPROFILE_H
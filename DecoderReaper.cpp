@@ -0,0 +1,123 @@
+#include "DecoderReaper.h"
+#include "MultiStreamDecoder.h"
+#include <QCoreApplication>
+#include <QDebug>
+
+DecoderReaper* DecoderReaper::instance()
+{
+    // 实例本身从不析构：会话缓存和播放窗口在退出过程中仍可能交来解码器，
+    // 不能依赖应用对象析构子对象的顺序。退出时由 StreamSessionCache::closeAll() 调用 shutdown() 等待全部回收
+    static DecoderReaper* reaper = [] {
+        DecoderReaper* created = new DecoderReaper();
+        if (QCoreApplication* app = QCoreApplication::instance()) {
+            created->moveToThread(app->thread());   // deleteJoined() 总在界面线程执行
+        }
+        return created;
+    }();
+    return reaper;
+}
+
+DecoderReaper::DecoderReaper(QObject *parent)
+    : QThread(parent)
+    , m_stop(false)
+{
+}
+
+DecoderReaper::~DecoderReaper()
+{
+    shutdown();
+}
+
+void DecoderReaper::retire(MultiStreamDecoder* decoder)
+{
+    if (!decoder) {
+        return;
+    }
+    decoder->stopDecoding();
+
+    QMutexLocker locker(&m_mutex);
+    m_pending.enqueue(decoder);
+    m_wait.wakeOne();
+    if (!isRunning() && !m_stop) {
+        start(QThread::LowPriority);
+    }
+}
+
+int DecoderReaper::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending.size() + m_joined.size();
+}
+
+void DecoderReaper::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_wait.wakeAll();
+    }
+    if (isRunning()) {
+        wait(); // 回收线程处理完队列后退出
+    }
+
+    // 线程未启动时队列中可能仍有解码器，直接在这里等待
+    QQueue<MultiStreamDecoder*> remaining;
+    {
+        QMutexLocker locker(&m_mutex);
+        remaining.swap(m_pending);
+    }
+    for (MultiStreamDecoder* decoder : remaining) {
+        decoder->wait();
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_joined += remaining;
+    }
+    deleteJoined();
+
+    QMutexLocker locker(&m_mutex);
+    m_stop = false; // 允许之后继续使用
+}
+
+void DecoderReaper::run()
+{
+    forever {
+        MultiStreamDecoder* decoder = nullptr;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_pending.isEmpty() && !m_stop) {
+                m_wait.wait(&m_mutex);
+            }
+            if (m_pending.isEmpty()) {
+                return; // 已请求退出且队列为空
+            }
+            decoder = m_pending.dequeue();
+        }
+
+        // 阻塞等待只发生在回收线程中
+        decoder->wait();
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_joined.append(decoder);
+        }
+        QMetaObject::invokeMethod(this, "deleteJoined", Qt::QueuedConnection);
+    }
+}
+
+void DecoderReaper::deleteJoined()
+{
+    QList<MultiStreamDecoder*> joined;
+    {
+        QMutexLocker locker(&m_mutex);
+        joined.swap(m_joined);
+    }
+    for (MultiStreamDecoder* decoder : joined) {
+        QString url = decoder->getUrl();
+        delete decoder;
+        emit decoderReaped(url);
+    }
+    if (!joined.isEmpty()) {
+        qDebug() << "Reaped decoders:" << joined.size();
+    }
+}
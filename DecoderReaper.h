@@ -0,0 +1,51 @@
+#ifndef DECODERREAPER_H
+#define DECODERREAPER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+
+class MultiStreamDecoder;
+
+/**
+ * @brief 解码线程回收器
+ *
+ * retire() 只发出停止请求并把解码器放进队列，立即返回；回收线程逐个等待解码线程退出，
+ * 再通知界面线程释放对象（此时线程已结束，析构不会阻塞）。一次移除或替换几十路视频流时，
+ * 界面线程不需要等待任何RTSP连接关闭。
+ * 程序退出时 shutdown() 等待全部解码线程退出：停止请求已同时发出，总等待时间约等于最慢的一路。
+ */
+class DecoderReaper : public QThread
+{
+    Q_OBJECT
+
+public:
+    static DecoderReaper* instance();           // 进程内唯一的回收器
+    ~DecoderReaper();
+
+    void retire(MultiStreamDecoder* decoder);   // 请求停止并排队回收（任意线程调用，不阻塞）
+    int pendingCount() const;                   // 尚未释放的解码器数量
+    void shutdown();                            // 等待全部解码线程退出并释放
+
+signals:
+    void decoderReaped(const QString& url);     // 解码器已释放
+
+protected:
+    void run() override;                        // 回收线程主函数
+
+private slots:
+    void deleteJoined();                        // 在界面线程中释放已结束的解码器
+
+private:
+    explicit DecoderReaper(QObject *parent = nullptr);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wait;
+    QQueue<MultiStreamDecoder*> m_pending;      // 等待线程退出的解码器
+    QList<MultiStreamDecoder*> m_joined;        // 线程已退出、等待释放的解码器
+    bool m_stop;
+};
+
+#endif // DECODERREAPER_H
@@ -0,0 +1,183 @@
+#include "EventLogModel.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+EventLogModel::EventLogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_capacity(qMax(1, capacity))
+    , m_head(0)
+    , m_count(0)
+    , m_totalCount(0)
+    , m_spillDirty(false)
+{
+    m_ring.resize(m_capacity);
+
+    // 日志文件按秒刷新，避免每条消息都触发一次磁盘写入
+    m_flushTimer.setInterval(1000);
+    connect(&m_flushTimer, &QTimer::timeout, this, &EventLogModel::flushSpillFile);
+}
+
+EventLogModel::~EventLogModel()
+{
+    if (m_spillFile.isOpen()) {
+        m_spillFile.flush();
+        m_spillFile.close();
+    }
+}
+
+bool EventLogModel::setSpillFile(const QString& filePath)
+{
+    if (m_spillFile.isOpen()) {
+        m_spillFile.flush();
+        m_spillFile.close();
+    }
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    m_spillFile.setFileName(filePath);
+    if (!m_spillFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "Cannot open event log file:" << filePath << m_spillFile.errorString();
+        m_flushTimer.stop();
+        return false;
+    }
+
+    m_flushTimer.start();
+    return true;
+}
+
+QString EventLogModel::spillFilePath() const
+{
+    return m_spillFile.fileName();
+}
+
+void EventLogModel::append(const QString& type, const QString& message)
+{
+    EventLogEntry entry;
+    entry.time = QDateTime::currentDateTime();
+    entry.type = type;
+    entry.message = message;
+
+    // 完整历史写入日志文件
+    if (m_spillFile.isOpen()) {
+        QString line = QString("%1\t%2\t%3\n")
+                           .arg(entry.time.toString("yyyy-MM-dd hh:mm:ss.zzz"))
+                           .arg(typePrefix(type))
+                           .arg(escapeField(message));
+        m_spillFile.write(line.toUtf8());
+        m_spillDirty = true;
+    }
+
+    // 缓冲区已满，先淘汰最旧的一条
+    if (m_count == m_capacity) {
+        beginRemoveRows(QModelIndex(), 0, 0);
+        m_head = (m_head + 1) % m_capacity;
+        --m_count;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_count, m_count);
+    m_ring[(m_head + m_count) % m_capacity] = entry;
+    ++m_count;
+    endInsertRows();
+
+    ++m_totalCount;
+}
+
+void EventLogModel::clear()
+{
+    beginResetModel();
+    for (EventLogEntry& entry : m_ring) {
+        entry = EventLogEntry();
+    }
+    m_head = 0;
+    m_count = 0;
+    endResetModel();
+}
+
+int EventLogModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_count;
+}
+
+QVariant EventLogModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_count) {
+        return QVariant();
+    }
+
+    const EventLogEntry& entry = entryAt(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("[%1] %2 %3")
+            .arg(entry.time.toString("yyyy-MM-dd hh:mm:ss"))
+            .arg(typePrefix(entry.type))
+            .arg(entry.message);
+    case Qt::ToolTipRole:
+        return entry.message;
+    case Qt::ForegroundRole:
+        return typeColor(entry.type);
+    default:
+        return QVariant();
+    }
+}
+
+void EventLogModel::flushSpillFile()
+{
+    if (m_spillDirty && m_spillFile.isOpen()) {
+        m_spillFile.flush();
+        m_spillDirty = false;
+    }
+}
+
+const EventLogEntry& EventLogModel::entryAt(int row) const
+{
+    return m_ring[(m_head + row) % m_capacity];
+}
+
+QString EventLogModel::escapeField(const QString& text)
+{
+    // 检测结果摘要、错误信息可能带有换行，转义后保持一行一条
+    QString escaped;
+    escaped.reserve(text.size());
+    for (const QChar ch : text) {
+        switch (ch.unicode()) {
+        case '\\': escaped += QLatin1String("\\\\"); break;
+        case '\t': escaped += QLatin1String("\\t"); break;
+        case '\n': escaped += QLatin1String("\\n"); break;
+        case '\r': escaped += QLatin1String("\\r"); break;
+        default: escaped += ch; break;
+        }
+    }
+    return escaped;
+}
+
+QString EventLogModel::typePrefix(const QString& type)
+{
+    if (type == "error") {
+        return "[错误]";
+    } else if (type == "warning") {
+        return "[警告]";
+    } else if (type == "success") {
+        return "[成功]";
+    } else if (type == "info") {
+        return "[信息]";
+    }
+    return "[消息]";
+}
+
+QColor EventLogModel::typeColor(const QString& type)
+{
+    if (type == "error") {
+        return QColor("#cc0000");
+    } else if (type == "warning") {
+        return QColor("#ff8800");
+    } else if (type == "success") {
+        return QColor("#008000");
+    } else if (type == "info") {
+        return QColor("#0066cc");
+    }
+    return QColor("#333333");
+}
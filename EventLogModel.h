@@ -0,0 +1,71 @@
+#ifndef EVENTLOGMODEL_H
+#define EVENTLOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QVector>
+#include <QString>
+#include <QFile>
+#include <QTimer>
+#include <QColor>
+
+/**
+ * @brief 单条事件消息
+ */
+struct EventLogEntry {
+    QDateTime time;     // 事件时间
+    QString type;       // 消息类型（error/warning/success/info/alarm...）
+    QString message;    // 消息内容
+};
+
+/**
+ * @brief 事件消息模型，固定容量的环形缓冲区
+ *
+ * 界面只保留最近 capacity 条消息，超出部分从头部淘汰；
+ * 所有消息同时追加写入日志文件，完整历史可在文件中查阅。
+ * 日志文件每行一条消息（时间\t类型\t内容），内容中的 \\、\t、\n、\r 转义为两个字符。
+ */
+class EventLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit EventLogModel(int capacity = 2000, QObject *parent = nullptr);
+    ~EventLogModel();
+
+    // 日志文件管理
+    bool setSpillFile(const QString& filePath);     // 设置历史日志文件（追加写入）
+    QString spillFilePath() const;                  // 获取历史日志文件路径
+
+    // 消息管理
+    void append(const QString& type, const QString& message); // 追加一条消息
+    void clear();                                   // 清空界面中的消息（日志文件不受影响）
+
+    int capacity() const { return m_capacity; }     // 环形缓冲区容量
+    qint64 totalCount() const { return m_totalCount; } // 累计消息数量
+
+    // QAbstractListModel 接口
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private slots:
+    void flushSpillFile();                          // 定时刷新日志文件缓冲
+
+private:
+    const EventLogEntry& entryAt(int row) const;    // 按行号取环形缓冲区中的消息
+    static QString typePrefix(const QString& type); // 消息类型前缀
+    static QString escapeField(const QString& text); // 转义日志文件中的反斜杠、制表符和换行
+    static QColor typeColor(const QString& type);   // 消息类型颜色
+
+    QVector<EventLogEntry> m_ring;  // 环形缓冲区
+    int m_capacity;                 // 缓冲区容量
+    int m_head;                     // 最旧消息所在位置
+    int m_count;                    // 当前消息数量
+    qint64 m_totalCount;            // 累计消息数量
+
+    QFile m_spillFile;              // 历史日志文件
+    QTimer m_flushTimer;            // 日志刷新定时器
+    bool m_spillDirty;              // 是否有未刷新的日志
+};
+
+#endif // EVENTLOGMODEL_H
@@ -0,0 +1,329 @@
+#include "EventStore.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+EventStore::EventStore(QObject *parent)
+    : QThread(parent)
+    , m_stop(false)
+{
+    // 连接名带上对象地址，允许同时存在多个实例
+    QString suffix = QString::number(reinterpret_cast<quintptr>(this), 16);
+    m_writeConnName = "EventStoreWrite_" + suffix;
+    m_readConnName = "EventStoreRead_" + suffix;
+}
+
+EventStore::~EventStore()
+{
+    close();
+}
+
+bool EventStore::open(const QString& dbPath)
+{
+    if (isRunning()) {
+        return true;
+    }
+
+    m_dbPath = dbPath;
+    if (m_dbPath.isEmpty()) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        m_dbPath = dataDir + "/events.db";
+    }
+    QDir().mkpath(QFileInfo(m_dbPath).absolutePath());
+
+    // 表结构在调用者线程中通过读连接创建，保证open()返回后即可查询
+    QSqlDatabase db = readConnection();
+    if (!db.isOpen()) {
+        return false;
+    }
+    if (!createSchema(db)) {
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = false;
+    }
+    start(QThread::LowPriority);
+    return true;
+}
+
+void EventStore::close()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_wait.wakeAll();
+    }
+    wait(); // 等待写入线程把队列写完
+
+    if (QSqlDatabase::contains(m_readConnName)) {
+        {
+            QSqlDatabase db = QSqlDatabase::database(m_readConnName, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(m_readConnName);
+    }
+}
+
+void EventStore::record(const EventRecord& event)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.append(event);
+    // 队列由空变为非空或达到批次大小时才唤醒，其余事件等待合并写入
+    if (m_pending.size() == 1 || m_pending.size() >= kBatchSize) {
+        m_wait.wakeOne();
+    }
+}
+
+void EventStore::record(const QVector<EventRecord>& events)
+{
+    if (events.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    bool wasEmpty = m_pending.isEmpty();
+    m_pending += events;
+    if (wasEmpty || m_pending.size() >= kBatchSize) {
+        m_wait.wakeOne();
+    }
+}
+
+void EventStore::run()
+{
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_writeConnName);
+        db.setDatabaseName(m_dbPath);
+        if (!db.open()) {
+            emit storeError(QString("无法打开事件数据库：%1").arg(db.lastError().text()));
+        } else {
+            QSqlQuery pragma(db);
+            pragma.exec("PRAGMA journal_mode=WAL");
+            pragma.exec("PRAGMA synchronous=NORMAL");  // WAL模式下NORMAL已足够安全
+            pragma.exec("PRAGMA busy_timeout=3000");
+
+            forever {
+                QVector<EventRecord> batch;
+                {
+                    QMutexLocker locker(&m_mutex);
+                    if (m_pending.isEmpty() && !m_stop) {
+                        m_wait.wait(&m_mutex);
+                    }
+                    // 短暂等待，让突发的检测事件合并到同一个事务中
+                    if (!m_stop && m_pending.size() < kBatchSize) {
+                        m_wait.wait(&m_mutex, kFlushIntervalMs);
+                    }
+                    if (m_pending.isEmpty()) {
+                        if (m_stop) {
+                            break;
+                        }
+                        continue;
+                    }
+                    batch.swap(m_pending);
+                }
+
+                // 超大批次拆分成多个事务，避免长时间持有写锁
+                for (int i = 0; i < batch.size(); i += kBatchSize) {
+                    writeBatch(db, batch.mid(i, kBatchSize));
+                }
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(m_writeConnName);
+}
+
+bool EventStore::createSchema(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+
+    // WAL模式是数据库文件级别的设置，读写连接共享
+    query.exec("PRAGMA journal_mode=WAL");
+
+    QString createTableSql = R"(
+        CREATE TABLE IF NOT EXISTS events (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,  -- 主键，自动递增
+            ts INTEGER NOT NULL,                   -- 事件时间，毫秒时间戳
+            stream TEXT NOT NULL DEFAULT '',       -- 视频流标识
+            type TEXT NOT NULL,                    -- 事件类型：alarm/detection
+            class_id INTEGER DEFAULT -1,           -- 目标类别ID
+            class_name TEXT DEFAULT '',            -- 目标类别名称
+            confidence REAL DEFAULT 0,             -- 置信度
+            x INTEGER DEFAULT 0,                   -- 目标框
+            y INTEGER DEFAULT 0,
+            w INTEGER DEFAULT 0,
+            h INTEGER DEFAULT 0,
+            message TEXT DEFAULT '',               -- 事件描述
+            image_path TEXT DEFAULT ''             -- 报警图片路径
+        )
+    )";
+    if (!query.exec(createTableSql)) {
+        emit storeError(QString("创建事件表失败：%1").arg(query.lastError().text()));
+        return false;
+    }
+
+    // 按时间、视频流、类别建立索引，覆盖"某路某类目标某时间段"的查询
+    const char* indexSql[] = {
+        "CREATE INDEX IF NOT EXISTS idx_events_ts ON events(ts)",
+        "CREATE INDEX IF NOT EXISTS idx_events_stream_ts ON events(stream, ts)",
+        "CREATE INDEX IF NOT EXISTS idx_events_class_ts ON events(class_name, ts)"
+    };
+    for (const char* sql : indexSql) {
+        if (!query.exec(sql)) {
+            emit storeError(QString("创建事件索引失败：%1").arg(query.lastError().text()));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EventStore::writeBatch(QSqlDatabase& db, const QVector<EventRecord>& batch)
+{
+    if (!db.transaction()) {
+        emit storeError(QString("开启事务失败：%1").arg(db.lastError().text()));
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO events (ts, stream, type, class_id, class_name, confidence, "
+                  "x, y, w, h, message, image_path) "
+                  "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+    for (const EventRecord& event : batch) {
+        query.addBindValue(event.timestamp);
+        query.addBindValue(event.stream);
+        query.addBindValue(event.type);
+        query.addBindValue(event.classId);
+        query.addBindValue(event.className);
+        query.addBindValue(event.confidence);
+        query.addBindValue(event.x);
+        query.addBindValue(event.y);
+        query.addBindValue(event.width);
+        query.addBindValue(event.height);
+        query.addBindValue(event.message);
+        query.addBindValue(event.imagePath);
+        if (!query.exec()) {
+            QString error = query.lastError().text();
+            db.rollback();
+            emit storeError(QString("写入事件失败：%1").arg(error));
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        QString error = db.lastError().text();
+        db.rollback();
+        emit storeError(QString("提交事件失败：%1").arg(error));
+        return false;
+    }
+    return true;
+}
+
+QSqlDatabase EventStore::readConnection()
+{
+    if (QSqlDatabase::contains(m_readConnName)) {
+        return QSqlDatabase::database(m_readConnName);
+    }
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_readConnName);
+    db.setDatabaseName(m_dbPath);
+    if (!db.open()) {
+        emit storeError(QString("无法打开事件数据库：%1").arg(db.lastError().text()));
+    }
+    return db;
+}
+
+QString EventStore::buildWhere(const EventQuery& condition, QVariantList& values)
+{
+    QStringList clauses;
+    if (condition.fromMs > 0) {
+        clauses << "ts >= ?";
+        values << condition.fromMs;
+    }
+    if (condition.toMs > 0) {
+        clauses << "ts <= ?";
+        values << condition.toMs;
+    }
+    if (!condition.stream.isEmpty()) {
+        clauses << "stream = ?";
+        values << condition.stream;
+    }
+    if (!condition.type.isEmpty()) {
+        clauses << "type = ?";
+        values << condition.type;
+    }
+    if (!condition.className.isEmpty()) {
+        clauses << "class_name = ?";
+        values << condition.className;
+    }
+    return clauses.isEmpty() ? QString() : " WHERE " + clauses.join(" AND ");
+}
+
+// 查询事件，按时间倒序返回（只能在调用open()的线程中使用）
+QVector<EventRecord> EventStore::query(const EventQuery& condition)
+{
+    QVector<EventRecord> result;
+    QSqlDatabase db = readConnection();
+    if (!db.isOpen()) {
+        return result;
+    }
+
+    QVariantList values;
+    QString sql = "SELECT ts, stream, type, class_id, class_name, confidence, "
+                  "x, y, w, h, message, image_path FROM events"
+                  + buildWhere(condition, values)
+                  + " ORDER BY ts DESC LIMIT ?";
+    values << qMax(1, condition.limit);
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant& value : values) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        qWarning() << "Event query failed:" << query.lastError().text();
+        return result;
+    }
+
+    while (query.next()) {
+        EventRecord event;
+        event.timestamp = query.value(0).toLongLong();
+        event.stream = query.value(1).toString();
+        event.type = query.value(2).toString();
+        event.classId = query.value(3).toInt();
+        event.className = query.value(4).toString();
+        event.confidence = query.value(5).toFloat();
+        event.x = query.value(6).toInt();
+        event.y = query.value(7).toInt();
+        event.width = query.value(8).toInt();
+        event.height = query.value(9).toInt();
+        event.message = query.value(10).toString();
+        event.imagePath = query.value(11).toString();
+        result.append(event);
+    }
+    return result;
+}
+
+qint64 EventStore::count(const EventQuery& condition)
+{
+    QSqlDatabase db = readConnection();
+    if (!db.isOpen()) {
+        return 0;
+    }
+
+    QVariantList values;
+    QSqlQuery query(db);
+    query.prepare("SELECT COUNT(*) FROM events" + buildWhere(condition, values));
+    for (const QVariant& value : values) {
+        query.addBindValue(value);
+    }
+    if (!query.exec() || !query.next()) {
+        qWarning() << "Event count failed:" << query.lastError().text();
+        return 0;
+    }
+    return query.value(0).toLongLong();
+}
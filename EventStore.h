@@ -0,0 +1,100 @@
+#ifndef EVENTSTORE_H
+#define EVENTSTORE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QString>
+#include <QDateTime>
+#include <QVariant>
+#include <QSqlDatabase>
+
+/**
+ * @brief 单条事件记录（报警 / 检测）
+ */
+struct EventRecord {
+    qint64 timestamp;    // 事件时间（毫秒时间戳）
+    QString stream;      // 视频流标识（RTSP地址）
+    QString type;        // 事件类型（alarm/detection）
+    int classId;         // 目标类别ID，无目标时为-1
+    QString className;   // 目标类别名称
+    float confidence;    // 置信度
+    int x;               // 目标框左上角x坐标
+    int y;               // 目标框左上角y坐标
+    int width;           // 目标框宽度
+    int height;          // 目标框高度
+    QString message;     // 事件描述
+    QString imagePath;   // 关联的报警图片路径
+
+    EventRecord()
+        : timestamp(QDateTime::currentMSecsSinceEpoch()), classId(-1), confidence(0)
+        , x(0), y(0), width(0), height(0) {}
+};
+
+/**
+ * @brief 事件查询条件，空字段表示不过滤
+ */
+struct EventQuery {
+    qint64 fromMs;       // 起始时间（含），0表示不限
+    qint64 toMs;         // 结束时间（含），0表示不限
+    QString stream;      // 视频流标识
+    QString type;        // 事件类型
+    QString className;   // 目标类别名称
+    int limit;           // 最大返回条数
+
+    EventQuery() : fromMs(0), toMs(0), limit(1000) {}
+};
+
+/**
+ * @brief 事件数据库，报警和检测事件持久化到SQLite
+ *
+ * 写入在后台线程中进行：record() 只把事件放进队列，
+ * 后台线程按批次在一个事务中插入，数据库使用WAL模式，
+ * 查询走独立的只读连接，不会被写入阻塞。
+ */
+class EventStore : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit EventStore(QObject *parent = nullptr);
+    ~EventStore();
+
+    bool open(const QString& dbPath = QString());   // 打开数据库并启动写入线程，默认路径为应用数据目录下的events.db
+    void close();                                   // 写完队列中剩余事件后关闭
+    QString databasePath() const { return m_dbPath; }
+
+    // 写入接口（线程安全，不阻塞调用者）
+    void record(const EventRecord& event);
+    void record(const QVector<EventRecord>& events);
+
+    // 查询接口（在调用者线程中执行）
+    QVector<EventRecord> query(const EventQuery& condition);
+    qint64 count(const EventQuery& condition);
+
+signals:
+    void storeError(const QString& error);          // 数据库错误信号
+
+protected:
+    void run() override;                            // 写入线程主函数
+
+private:
+    bool createSchema(QSqlDatabase& db);            // 创建表和索引
+    bool writeBatch(QSqlDatabase& db, const QVector<EventRecord>& batch); // 在一个事务中写入一批事件
+    QSqlDatabase readConnection();                  // 获取只读查询连接
+    static QString buildWhere(const EventQuery& condition, QVariantList& values); // 拼接查询条件
+
+    QString m_dbPath;                   // 数据库文件路径
+    QString m_writeConnName;            // 写连接名称
+    QString m_readConnName;             // 读连接名称
+    QVector<EventRecord> m_pending;     // 待写入事件队列
+    bool m_stop;                        // 停止标志
+    QMutex m_mutex;                     // 保护队列和停止标志
+    QWaitCondition m_wait;              // 队列非空时唤醒写入线程
+
+    static const int kBatchSize = 500;       // 单个事务最多写入的事件数
+    static const int kFlushIntervalMs = 500; // 队列未满时的最长等待时间
+};
+
+#endif // EVENTSTORE_H
@@ -0,0 +1,270 @@
+#include "FrameBufferPool.h"
+#include "MetricsHttpServer.h"
+#include <QPainter>
+#include <algorithm>
+
+namespace {
+
+const qint64 MinClassBytes = 4096;                  // 最小级别 4KB
+const qint64 MaxClassBytes = 256LL * 1024 * 1024;   // 超过 256MB 的请求不缓存
+const int StepsPerOctave = 4;
+const size_t Alignment = 64;
+const size_t HeaderBytes = 64;                      // 缓冲前的头部，保持数据区64字节对齐
+
+struct BufferHeader {
+    qint64 bytes;
+    int classIndex;
+};
+
+inline BufferHeader* headerOf(void* data)
+{
+    return reinterpret_cast<BufferHeader*>(static_cast<char*>(data) - HeaderBytes);
+}
+
+} // namespace
+
+FrameBufferPool* FrameBufferPool::instance()
+{
+    // 图像可能在任意线程、甚至静态析构阶段才释放，缓冲池本身从不析构
+    static FrameBufferPool* pool = new FrameBufferPool();
+    return pool;
+}
+
+FrameBufferPool::FrameBufferPool()
+    : m_maxCachedBytes(256LL * 1024 * 1024)
+    , m_bytesInUse(0)
+    , m_bytesCached(0)
+    , m_highWaterBytes(0)
+{
+    bool ok = false;
+    qint64 limitMb = qgetenv("RTSP_FRAME_POOL_MB").toLongLong(&ok);
+    if (ok && limitMb >= 0) {
+        m_maxCachedBytes = limitMb * 1024 * 1024;
+    }
+
+    // 4KB, 5KB, 6KB, 7KB, 8KB, 10KB, 12KB, 14KB, 16KB ... 256MB
+    SizeClass first;
+    first.bytes = MinClassBytes;
+    m_classes.append(first);
+    for (qint64 base = MinClassBytes; base < MaxClassBytes; base *= 2) {
+        for (int step = 1; step <= StepsPerOctave; ++step) {
+            SizeClass sizeClass;
+            sizeClass.bytes = base + step * base / StepsPerOctave;
+            m_classes.append(sizeClass);
+        }
+    }
+}
+
+int FrameBufferPool::classIndex(qint64 bytes) const
+{
+    if (bytes > MaxClassBytes) {
+        return -1;
+    }
+    auto it = std::lower_bound(m_classes.constBegin(), m_classes.constEnd(), bytes,
+                               [](const SizeClass& sizeClass, qint64 value) { return sizeClass.bytes < value; });
+    return it == m_classes.constEnd() ? -1 : static_cast<int>(it - m_classes.constBegin());
+}
+
+void* FrameBufferPool::acquire(qint64 bytes)
+{
+    if (bytes <= 0) {
+        return nullptr;
+    }
+    const int index = classIndex(bytes);    // m_classes 构造后不再改变，无需加锁
+    const qint64 allocBytes = index >= 0 ? m_classes[index].bytes : bytes;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_bytesInUse += allocBytes;
+        m_highWaterBytes = qMax(m_highWaterBytes, m_bytesInUse);
+        if (index >= 0) {
+            SizeClass& sizeClass = m_classes[index];
+            sizeClass.highWater = qMax(sizeClass.highWater, ++sizeClass.inUse);
+            if (!sizeClass.freeList.isEmpty()) {
+                ++sizeClass.hits;
+                m_bytesCached -= allocBytes;
+                return sizeClass.freeList.takeLast();
+            }
+            ++sizeClass.misses;
+        }
+    }
+
+    // 在锁外分配，避免大块分配阻塞其他线程归还缓冲
+    void* base = qMallocAligned(static_cast<size_t>(allocBytes) + HeaderBytes, Alignment);
+    if (!base) {
+        QMutexLocker locker(&m_mutex);
+        m_bytesInUse -= allocBytes;
+        if (index >= 0) {
+            --m_classes[index].inUse;
+        }
+        return nullptr;
+    }
+    void* data = static_cast<char*>(base) + HeaderBytes;
+    BufferHeader* header = headerOf(data);
+    header->bytes = allocBytes;
+    header->classIndex = index;
+    return data;
+}
+
+void FrameBufferPool::release(void* data)
+{
+    if (!data) {
+        return;
+    }
+    BufferHeader* header = headerOf(data);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_bytesInUse -= header->bytes;
+        if (header->classIndex >= 0) {
+            SizeClass& sizeClass = m_classes[header->classIndex];
+            --sizeClass.inUse;
+            if (m_bytesCached + header->bytes <= m_maxCachedBytes) {
+                sizeClass.freeList.append(data);
+                m_bytesCached += header->bytes;
+                return;
+            }
+        }
+    }
+    qFreeAligned(header);
+}
+
+void FrameBufferPool::releaseImage(void* data)
+{
+    instance()->release(data);
+}
+
+QImage FrameBufferPool::acquireImage(const QSize& size, QImage::Format format)
+{
+    if (size.isEmpty() || format == QImage::Format_Invalid) {
+        return QImage();
+    }
+    const int bitsPerPixel = QImage::toPixelFormat(format).bitsPerPixel();
+    const int bytesPerLine = ((size.width() * bitsPerPixel + 7) / 8 + 31) & ~31;
+    void* data = acquire(static_cast<qint64>(bytesPerLine) * size.height());
+    if (!data) {
+        return QImage();
+    }
+    return QImage(static_cast<uchar*>(data), size.width(), size.height(), bytesPerLine, format,
+                  &FrameBufferPool::releaseImage, data);
+}
+
+QImage FrameBufferPool::scaledImage(const QImage& source, const QSize& size)
+{
+    if (source.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+    if (source.size() == size) {
+        return source;
+    }
+    QImage image = acquireImage(size, source.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                               : QImage::Format_RGB32);
+    if (image.isNull()) {
+        return source.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    QPainter painter(&image);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(QRect(QPoint(0, 0), size), source);
+    painter.end();
+    return image;
+}
+
+void FrameBufferPool::setMaxCachedBytes(qint64 bytes)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_maxCachedBytes = qMax<qint64>(0, bytes);
+        if (m_bytesCached <= m_maxCachedBytes) {
+            return;
+        }
+    }
+    trim();
+}
+
+qint64 FrameBufferPool::maxCachedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxCachedBytes;
+}
+
+void FrameBufferPool::trim()
+{
+    QVector<void*> buffers;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (SizeClass& sizeClass : m_classes) {
+            buffers += sizeClass.freeList;
+            sizeClass.freeList.clear();
+        }
+        m_bytesCached = 0;
+    }
+    for (void* data : buffers) {
+        qFreeAligned(headerOf(data));
+    }
+}
+
+qint64 FrameBufferPool::bytesInUse() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytesInUse;
+}
+
+qint64 FrameBufferPool::bytesCached() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytesCached;
+}
+
+qint64 FrameBufferPool::highWaterBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_highWaterBytes;
+}
+
+QVector<FrameBufferPool::ClassStats> FrameBufferPool::stats() const
+{
+    QVector<ClassStats> result;
+    QMutexLocker locker(&m_mutex);
+    for (const SizeClass& sizeClass : m_classes) {
+        if (sizeClass.hits == 0 && sizeClass.misses == 0) {
+            continue;
+        }
+        ClassStats stats;
+        stats.bytes = sizeClass.bytes;
+        stats.inUse = sizeClass.inUse;
+        stats.free = sizeClass.freeList.size();
+        stats.highWater = sizeClass.highWater;
+        stats.hits = sizeClass.hits;
+        stats.misses = sizeClass.misses;
+        result.append(stats);
+    }
+    return result;
+}
+
+void FrameBufferPool::collectMetrics(MetricsText& out) const
+{
+    out.gauge("rtsp_frame_pool_bytes", "Frame buffer bytes handed out by the pool.", bytesInUse(),
+              MetricsText::label("state", "in_use"));
+    out.gauge("rtsp_frame_pool_bytes", "Frame buffer bytes handed out by the pool.", bytesCached(),
+              MetricsText::label("state", "cached"));
+    out.gauge("rtsp_frame_pool_high_water_bytes", "Highest number of frame buffer bytes in use at once.",
+              highWaterBytes());
+
+    quint64 hits = 0;
+    quint64 misses = 0;
+    for (const ClassStats& stats : this->stats()) {
+        QString size = MetricsText::label("size", QString::number(stats.bytes));
+        out.gauge("rtsp_frame_pool_buffers", "Frame buffers per size class.", stats.inUse,
+                  size + "," + MetricsText::label("state", "in_use"));
+        out.gauge("rtsp_frame_pool_buffers", "Frame buffers per size class.", stats.free,
+                  size + "," + MetricsText::label("state", "free"));
+        out.gauge("rtsp_frame_pool_class_high_water", "Highest number of buffers of a size class in use at once.",
+                  stats.highWater, size);
+        hits += stats.hits;
+        misses += stats.misses;
+    }
+    out.counter("rtsp_frame_pool_acquires_total", "Frame buffer requests served by the pool.", hits,
+                MetricsText::label("result", "hit"));
+    out.counter("rtsp_frame_pool_acquires_total", "Frame buffer requests served by the pool.", misses,
+                MetricsText::label("result", "miss"));
+}
@@ -0,0 +1,76 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+#include <QSize>
+
+class MetricsText;
+
+/**
+ * @brief 进程内共享的帧缓冲池（按大小分级）
+ *
+ * 几十路视频每秒要分配上千个大块图像缓冲，长时间运行后 glibc 堆碎片会让常驻内存持续增长。
+ * 这里按大小分级（每个2的幂区间分4级，相邻级别相差不超过25%）缓存释放的缓冲，下次同级请求直接复用。
+ * acquireImage() 返回的 QImage 最后一个副本析构时（任意线程）缓冲自动归还。
+ * 缓存的空闲缓冲总量超过上限（环境变量 RTSP_FRAME_POOL_MB，默认256MB）时直接释放。
+ * 每一级记录使用中/空闲数量、使用中的历史最高值和命中/未命中次数，通过指标接口输出。
+ */
+class FrameBufferPool
+{
+public:
+    struct ClassStats {
+        qint64 bytes;                           // 该级缓冲大小
+        int inUse;                              // 使用中的缓冲数
+        int free;                               // 空闲（可复用）的缓冲数
+        int highWater;                          // 使用中数量的历史最高值
+        quint64 hits;                           // 复用空闲缓冲的次数
+        quint64 misses;                         // 新分配的次数
+    };
+
+    static FrameBufferPool* instance();         // 进程内唯一的缓冲池（不析构，保证退出时仍可归还）
+
+    // 从池中取一幅图像，行宽按32字节对齐；内容未初始化
+    QImage acquireImage(const QSize& size, QImage::Format format);
+    // 平滑缩放到池中的图像（双线性，适合缩放比例不超过2倍的场合）
+    QImage scaledImage(const QImage& source, const QSize& size);
+
+    void* acquire(qint64 bytes);                // 至少 bytes 字节，64字节对齐
+    void release(void* data);
+
+    void setMaxCachedBytes(qint64 bytes);
+    qint64 maxCachedBytes() const;
+    void trim();                                // 释放全部空闲缓冲
+
+    qint64 bytesInUse() const;
+    qint64 bytesCached() const;
+    qint64 highWaterBytes() const;              // 使用中字节数的历史最高值
+    QVector<ClassStats> stats() const;          // 只包含用到过的级别
+    void collectMetrics(MetricsText& out) const;
+
+private:
+    FrameBufferPool();
+    Q_DISABLE_COPY(FrameBufferPool)
+
+    struct SizeClass {
+        qint64 bytes = 0;
+        QVector<void*> freeList;
+        int inUse = 0;
+        int highWater = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+    };
+
+    int classIndex(qint64 bytes) const;         // 超出最大级别时返回-1（不缓存）
+    static void releaseImage(void* data);       // QImage 的 cleanupFunction
+
+    mutable QMutex m_mutex;
+    QVector<SizeClass> m_classes;
+    qint64 m_maxCachedBytes;
+    qint64 m_bytesInUse;
+    qint64 m_bytesCached;
+    qint64 m_highWaterBytes;
+};
+
+#endif // FRAMEBUFFERPOOL_H
@@ -0,0 +1,263 @@
+#include "FrameMemoryBudget.h"
+#include "MetricsHttpServer.h"
+#include "StreamMetrics.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+const qint64 AccountIntervalUs = 500000;            // 每帧只记录，约每半秒统计一次
+
+} // namespace
+
+FrameMemoryBudget::Slot::Slot(FrameMemoryBudget* budget, const void* owner, int index)
+    : m_budget(budget)
+    , m_owner(owner)
+    , m_index(index)
+    , m_key(0)
+    , m_bytes(0)
+    , m_updatedUs(0)
+    , m_visible(0)
+{
+}
+
+void FrameMemoryBudget::Slot::track(const QImage& frame, bool visible)
+{
+    // 各字段分别写入，统计时可能看到新旧混合的值，下一次统计即恢复一致
+    m_bytes.storeRelease(frame.isNull() ? 0 : frame.sizeInBytes());
+    m_key.storeRelease(frame.isNull() ? 0 : frame.cacheKey() >> 32);
+    m_visible.storeRelease(visible ? 1 : 0);
+    m_updatedUs.storeRelease(StreamMetrics::nowUs());
+    m_budget->requestAccounting();
+}
+
+void FrameMemoryBudget::Slot::setVisible(bool visible)
+{
+    m_visible.storeRelease(visible ? 1 : 0);
+}
+
+FrameMemoryBudget* FrameMemoryBudget::instance()
+{
+    // 解码器可能在应用对象析构后才释放，实例本身从不析构
+    static FrameMemoryBudget* budget = new FrameMemoryBudget();
+    return budget;
+}
+
+FrameMemoryBudget::FrameMemoryBudget()
+    : m_budgetBytes(512LL * 1024 * 1024)
+    , m_evictions(0)
+    , m_overBudgetWarned(false)
+    , m_enforcePending(0)
+    , m_lastAccountUs(0)
+    , m_evictThread(nullptr)
+{
+    bool ok = false;
+    qint64 budgetMb = qgetenv("RTSP_FRAME_BUDGET_MB").toLongLong(&ok);
+    if (ok && budgetMb > 0) {
+        m_budgetBytes = budgetMb * 1024 * 1024;
+    }
+}
+
+void FrameMemoryBudget::addOwner(const void* owner, const QString& kind, const Evictor& evict)
+{
+    QMutexLocker locker(&m_mutex);
+    Owner& entry = m_owners[owner];
+    entry.kind = kind;
+    entry.evict = evict;
+}
+
+void FrameMemoryBudget::removeOwner(const void* owner)
+{
+    QMutexLocker locker(&m_mutex);
+    // 回收回调在锁外执行：持有方在其他线程析构时等回调结束再返回；
+    // 回调中（同一线程）移除持有方时不能等待，enforce() 调用前会重新确认持有方仍然存在
+    while (m_evicting.contains(owner) && QThread::currentThreadId() != m_evictThread) {
+        m_evictDone.wait(&m_mutex);
+    }
+    m_owners.remove(owner);
+    for (auto it = m_slots.begin(); it != m_slots.end();) {
+        if (it.key().first == owner) {
+            delete it.value();
+            it = m_slots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+FrameMemoryBudget::Slot* FrameMemoryBudget::slot(const void* owner, int index)
+{
+    QMutexLocker locker(&m_mutex);
+    Slot*& entry = m_slots[qMakePair(owner, index)];
+    if (!entry) {
+        entry = new Slot(this, owner, index);
+    }
+    return entry;
+}
+
+void FrameMemoryBudget::untrack(const void* owner, int index)
+{
+    QMutexLocker locker(&m_mutex);
+    delete m_slots.take(qMakePair(owner, index));
+}
+
+void FrameMemoryBudget::requestAccounting()
+{
+    if (StreamMetrics::nowUs() - m_lastAccountUs.loadAcquire() >= AccountIntervalUs) {
+        scheduleEnforce();
+    }
+}
+
+qint64 FrameMemoryBudget::account(QHash<qint64, int>* refs) const
+{
+    QHash<qint64, int> localRefs;
+    QHash<qint64, int>& counts = refs ? *refs : localRefs;
+    qint64 used = 0;
+    for (const Slot* slot : m_slots) {
+        const qint64 key = slot->m_key.loadAcquire();
+        if (key == 0) {
+            continue;
+        }
+        if (counts[key]++ == 0) {
+            used += slot->m_bytes.loadAcquire();
+        }
+    }
+    return used;
+}
+
+void FrameMemoryBudget::scheduleEnforce()
+{
+    QCoreApplication* app = QCoreApplication::instance();
+    if (!app || !m_enforcePending.testAndSetOrdered(0, 1)) {
+        return;
+    }
+    QMetaObject::invokeMethod(app, [this]() {
+        m_enforcePending.storeRelease(0);
+        enforce();
+    }, Qt::QueuedConnection);
+}
+
+void FrameMemoryBudget::enforce()
+{
+    m_lastAccountUs.storeRelease(StreamMetrics::nowUs());
+
+    QList<QPair<const void*, int>> victims;
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<qint64, int> refs;
+        qint64 used = account(&refs);
+        if (used <= m_budgetBytes) {
+            m_overBudgetWarned = false;
+            return;
+        }
+
+        // 只回收不可见、且持有方提供了回收回调的帧，最久未更新的先回收；
+        // 缓冲仍被其他位置引用时丢弃这一份释放不了内存，跳过
+        QList<Slot*> candidates;
+        for (Slot* slot : m_slots) {
+            const qint64 key = slot->m_key.loadAcquire();
+            if (key != 0 && refs.value(key) == 1 && !slot->m_visible.loadAcquire()
+                && m_owners.value(slot->m_owner).evict) {
+                candidates.append(slot);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Slot* a, const Slot* b) {
+            return a->m_updatedUs.loadAcquire() < b->m_updatedUs.loadAcquire();
+        });
+
+        const qint64 target = m_budgetBytes / 10 * 9;
+        for (Slot* slot : candidates) {
+            if (used <= target) {
+                break;
+            }
+            const qint64 key = slot->m_key.loadAcquire();
+            const qint64 bytes = slot->m_bytes.loadAcquire();
+            victims.append(qMakePair(slot->m_owner, slot->m_index));
+            ++m_evicting[slot->m_owner];
+            slot->m_key.storeRelease(0);
+            slot->m_bytes.storeRelease(0);
+            used -= bytes;
+            ++m_evictions;
+        }
+        if (used > m_budgetBytes && !m_overBudgetWarned) {
+            m_overBudgetWarned = true;
+            qWarning() << "缓存帧占用" << used / (1024 * 1024) << "MB，超过预算"
+                       << m_budgetBytes / (1024 * 1024) << "MB（其余为正在显示的画面）";
+        }
+    }
+
+    // 回调在锁外执行，持有方可以在回调中再调用 untrack()。
+    // 标记为回收中的持有方在其他线程中不会被移除；同一线程的前一个回调可能已移除它，调用前重新确认
+    for (const auto& victim : victims) {
+        Evictor evict;
+        {
+            QMutexLocker locker(&m_mutex);
+            m_evictThread = QThread::currentThreadId();
+            evict = m_owners.value(victim.first).evict;
+        }
+        if (evict) {
+            evict(victim.second);
+        }
+        QMutexLocker locker(&m_mutex);
+        if (--m_evicting[victim.first] <= 0) {
+            m_evicting.remove(victim.first);
+        }
+        m_evictThread = nullptr;
+        m_evictDone.wakeAll();
+    }
+}
+
+void FrameMemoryBudget::setBudgetBytes(qint64 bytes)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_budgetBytes = qMax<qint64>(1, bytes);
+    }
+    scheduleEnforce();
+}
+
+qint64 FrameMemoryBudget::budgetBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budgetBytes;
+}
+
+qint64 FrameMemoryBudget::usedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return account();
+}
+
+quint64 FrameMemoryBudget::evictionCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_evictions;
+}
+
+void FrameMemoryBudget::collectMetrics(MetricsText& out) const
+{
+    QMutexLocker locker(&m_mutex);
+    out.gauge("rtsp_frame_cache_bytes", "Bytes of cached frames across all holders (shared buffers counted once).",
+              account());
+    out.gauge("rtsp_frame_cache_budget_bytes", "Memory budget for cached frames.", m_budgetBytes);
+    out.counter("rtsp_frame_cache_evictions_total", "Cached frames dropped to stay within the budget.", m_evictions);
+
+    // 按持有方类型汇总（同一缓冲被多种持有方共享时在各自类型中都会计入）
+    QHash<QString, qint64> kindBytes;
+    QHash<QString, int> kindFrames;
+    for (const Slot* slot : m_slots) {
+        if (slot->m_key.loadAcquire() == 0) {
+            continue;
+        }
+        QString kind = m_owners.value(slot->m_owner).kind;
+        kindBytes[kind] += slot->m_bytes.loadAcquire();
+        ++kindFrames[kind];
+    }
+    for (auto it = kindBytes.constBegin(); it != kindBytes.constEnd(); ++it) {
+        QString labels = MetricsText::label("kind", it.key());
+        out.gauge("rtsp_frame_cache_kind_bytes", "Bytes of cached frames per holder kind.", it.value(), labels);
+        out.gauge("rtsp_frame_cache_frames", "Cached frames per holder kind.", kindFrames.value(it.key()), labels);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef FRAMEMEMORYBUDGET_H
+#define FRAMEMEMORYBUDGET_H
+
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QString>
+#include <functional>
+
+class MetricsText;
+
+/**
+ * @brief 全部视频流缓存帧的内存预算
+ *
+ * 网格、解码器、界面控制器都会各自保留最后一帧，几十路高分辨率视频加起来可达数GB。
+ * 各持有方为每个缓存位置取得一个 Slot，通过 Slot::track() 报告缓存的帧；同一缓冲被多处共享
+ * （QImage 隐式共享）时只计算一次。总量超过预算（环境变量 RTSP_FRAME_BUDGET_MB，默认512MB）时，
+ * 在界面线程中按最久未更新的顺序回调持有方丢弃不可见的缓存帧，直到降到预算的90%；
+ * 可见的帧（正在显示、抓拍/报警要用的）只统计不回收；仍被其他位置共享的缓冲丢弃一份也不释放内存，同样跳过。
+ *
+ * Slot::track() 在每帧的路径上调用，只写原子变量、不加锁；按缓冲去重求和和回收由界面线程
+ * 每隔约半秒批量完成，统计值相应滞后。回收回调总在界面线程中、锁外执行；
+ * 其他线程中的 removeOwner() 会等该持有方进行中的回调结束，之后不会再回调。
+ */
+class FrameMemoryBudget
+{
+public:
+    using Evictor = std::function<void(int slot)>;  // 持有方丢弃 slot 位置的缓存帧（界面线程中调用）
+
+    // 一个缓存位置：持有方保存指针，在 untrack()/removeOwner() 之前一直有效
+    class Slot
+    {
+    public:
+        void track(const QImage& frame, bool visible); // 任意线程调用，不加锁；空图像表示已清空
+        void setVisible(bool visible);
+
+    private:
+        friend class FrameMemoryBudget;
+        Slot(FrameMemoryBudget* budget, const void* owner, int index);
+        Q_DISABLE_COPY(Slot)
+
+        FrameMemoryBudget* m_budget;
+        const void* m_owner;
+        int m_index;
+        QAtomicInteger<qint64> m_key;               // 图像数据的序号（QImage::cacheKey 高32位），0表示没有缓存帧
+        QAtomicInteger<qint64> m_bytes;
+        QAtomicInteger<qint64> m_updatedUs;         // 最近一次更新的时间（单调时钟）
+        QAtomicInt m_visible;
+    };
+
+    static FrameMemoryBudget* instance();           // 进程内唯一的实例（不析构）
+
+    void addOwner(const void* owner, const QString& kind, const Evictor& evict = Evictor());
+    void removeOwner(const void* owner);            // 同时释放该持有方的全部 Slot，并等待进行中的回收回调结束
+    Slot* slot(const void* owner, int index);       // 取得缓存位置，没有时创建（加锁查找，持有方应保存返回的指针）
+    void untrack(const void* owner, int index);     // 释放缓存位置
+
+    void setBudgetBytes(qint64 bytes);
+    qint64 budgetBytes() const;
+    qint64 usedBytes() const;                       // 去重后的缓存帧总字节数
+    quint64 evictionCount() const;
+    void collectMetrics(MetricsText& out) const;
+
+private:
+    FrameMemoryBudget();
+    Q_DISABLE_COPY(FrameMemoryBudget)
+
+    struct Owner {
+        QString kind;
+        Evictor evict;
+    };
+    typedef QPair<const void*, int> SlotKey;
+
+    void requestAccounting();                       // Slot::track() 调用：距上次统计超过间隔时排队统计
+    qint64 account(QHash<qint64, int>* refs = nullptr) const; // 去重求和，调用方持有 m_mutex
+    void scheduleEnforce();                         // 排队到界面线程统计和回收
+    void enforce();
+
+    mutable QMutex m_mutex;
+    QHash<const void*, Owner> m_owners;
+    QHash<SlotKey, Slot*> m_slots;
+    qint64 m_budgetBytes;
+    quint64 m_evictions;
+    bool m_overBudgetWarned;                        // 超出预算的警告只在进入该状态时输出一次
+    QAtomicInt m_enforcePending;
+    QAtomicInteger<qint64> m_lastAccountUs;         // 上一次批量统计的时间
+    QHash<const void*, int> m_evicting;             // 正在锁外执行回收回调的持有方（回调数）
+    QWaitCondition m_evictDone;
+    Qt::HANDLE m_evictThread;                       // 执行回收回调的线程
+};
+
+#endif // FRAMEMEMORYBUDGET_H
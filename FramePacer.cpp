@@ -0,0 +1,140 @@
+#include "FramePacer.h"
+#include "StreamMetrics.h"
+#include <algorithm>
+
+namespace {
+
+const int TransitWindow = 64;                       // 基准取最近64帧（25fps约2.5秒）中最快到达的一帧
+const qint64 DiscontinuityUs = 1000000;             // 传输时间变化超过1秒视为时间戳跳变
+
+} // namespace
+
+FramePacer::FramePacer()
+    : m_maxDelayUs(defaultMaxDelayMs() * 1000LL)
+    , m_transits(TransitWindow, 0)
+    , m_transitPos(0)
+    , m_transitCount(0)
+    , m_lastTransitUs(0)
+    , m_jitterUs(0.0)
+    , m_delayUs(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&m_timer, &QTimer::timeout, [this]() {
+        releaseDue();
+    });
+}
+
+int FramePacer::defaultMaxDelayMs()
+{
+    bool ok = false;
+    int ms = qgetenv("RTSP_JITTER_BUFFER_MS").toInt(&ok);
+    return ok && ms >= 0 ? ms : 150;
+}
+
+void FramePacer::setOutput(const Output& output)
+{
+    m_output = output;
+}
+
+void FramePacer::setMaxDelayMs(int ms)
+{
+    m_maxDelayUs = qMax(0, ms) * 1000LL;
+    if (m_maxDelayUs == 0) {
+        flush();
+    }
+}
+
+void FramePacer::push(const QImage& frame, const FrameTiming& timing)
+{
+    if (!m_output) {
+        return;
+    }
+    if (m_maxDelayUs <= 0 || !timing.hasPts()) {
+        flush();
+        m_output(frame, timing);
+        return;
+    }
+
+    const qint64 transitUs = timing.arrivalUs - timing.ptsUs;
+    if (m_transitCount > 0 && qAbs(transitUs - m_lastTransitUs) > DiscontinuityUs) {
+        // 重连、定位或时间戳回绕：之前的估计不再适用
+        flush();
+        resetEstimate();
+    }
+    if (m_transitCount > 0) {
+        m_jitterUs += (qAbs(transitUs - m_lastTransitUs) - m_jitterUs) / 16.0;
+    }
+    m_lastTransitUs = transitUs;
+
+    // 基准随窗口滑动，摄像机与本机时钟的缓慢漂移不会累积成延迟
+    m_transits[m_transitPos] = transitUs;
+    m_transitPos = (m_transitPos + 1) % TransitWindow;
+    m_transitCount = qMin(m_transitCount + 1, TransitWindow);
+    const qint64 baseUs = *std::min_element(m_transits.constBegin(), m_transits.constBegin() + m_transitCount);
+
+    m_delayUs = qMin<qint64>(m_maxDelayUs, static_cast<qint64>(m_jitterUs * 3));
+    const qint64 dueUs = timing.ptsUs + baseUs + m_delayUs;
+    if (m_queue.isEmpty() && dueUs <= StreamMetrics::nowUs()) {
+        m_output(frame, timing);
+        return;
+    }
+
+    Pending pending;
+    pending.frame = frame;
+    pending.timing = timing;
+    pending.dueUs = dueUs;
+    m_queue.enqueue(pending);
+    while (m_queue.size() > MaxQueuedFrames) {
+        Pending early = m_queue.dequeue();
+        m_output(early.frame, early.timing);
+    }
+    schedule();
+}
+
+void FramePacer::flush()
+{
+    m_timer.stop();
+    // 先取出再输出，输出回调中可以再调用 reset()
+    while (!m_queue.isEmpty()) {
+        Pending pending = m_queue.dequeue();
+        m_output(pending.frame, pending.timing);
+    }
+}
+
+void FramePacer::reset()
+{
+    m_timer.stop();
+    m_queue.clear();
+    resetEstimate();
+}
+
+void FramePacer::releaseDue()
+{
+    // 定时器精度约1毫秒，提前1毫秒内到期的帧一并输出
+    const qint64 nowUs = StreamMetrics::nowUs() + 1000;
+    while (!m_queue.isEmpty() && m_queue.head().dueUs <= nowUs) {
+        Pending pending = m_queue.dequeue();
+        m_output(pending.frame, pending.timing);
+    }
+    schedule();
+}
+
+void FramePacer::schedule()
+{
+    if (m_queue.isEmpty()) {
+        m_timer.stop();
+        return;
+    }
+    const qint64 waitUs = m_queue.head().dueUs - StreamMetrics::nowUs();
+    m_timer.start(static_cast<int>(qBound<qint64>(0, (waitUs + 999) / 1000, m_maxDelayUs / 1000 + 1)));
+}
+
+void FramePacer::resetEstimate()
+{
+    m_transitPos = 0;
+    m_transitCount = 0;
+    m_lastTransitUs = 0;
+    m_jitterUs = 0.0;
+    m_delayUs = 0;
+}
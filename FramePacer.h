@@ -0,0 +1,69 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <QImage>
+#include <QQueue>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+
+#include "FrameTiming.h"
+
+/**
+ * @brief 自适应抖动缓冲：按帧时间戳均匀地输出画面
+ *
+ * 网络抖动会让帧成批到达，收到就显示时画面忽快忽慢。这里记录每帧"到达时间 - 时间戳"（传输时间），
+ * 以最近一段时间内最快到达的帧为基准，按 RFC 3550 的方法平滑估计抖动，缓冲约3倍抖动的时长
+ * （不超过上限，环境变量 RTSP_JITTER_BUFFER_MS，默认150ms，0表示不缓冲），到期后按顺序输出。
+ * 网络平稳时抖动接近0，帧收到即输出，不增加延迟。时间戳跳变（重连、定位）时先输出缓存帧再重新估计。
+ *
+ * 只缓冲、不丢帧：缓存超过 MaxQueuedFrames 帧时提前输出最早的帧。只在创建它的线程（界面线程）中使用。
+ */
+class FramePacer
+{
+public:
+    using Output = std::function<void(const QImage& frame, const FrameTiming& timing)>;
+
+    static const int MaxQueuedFrames = 8;
+
+    FramePacer();
+
+    void setOutput(const Output& output);
+    void setMaxDelayMs(int ms);                     // 缓冲时长上限，0表示收到即输出
+    int maxDelayMs() const { return static_cast<int>(m_maxDelayUs / 1000); }
+    static int defaultMaxDelayMs();                 // 环境变量 RTSP_JITTER_BUFFER_MS，默认150
+
+    void push(const QImage& frame, const FrameTiming& timing); // 新帧入队，到期后输出
+    void flush();                                   // 立即按顺序输出全部缓存帧
+    void reset();                                   // 丢弃缓存帧并重新估计（切换或停止视频流时）
+
+    double jitterMs() const { return m_jitterUs / 1000.0; }
+    int delayMs() const { return static_cast<int>(m_delayUs / 1000); } // 当前缓冲时长
+    int queuedFrames() const { return m_queue.size(); }
+
+private:
+    Q_DISABLE_COPY(FramePacer)
+
+    struct Pending {
+        QImage frame;
+        FrameTiming timing;
+        qint64 dueUs;
+    };
+
+    void releaseDue();                              // 输出到期的帧并安排下一次定时
+    void schedule();
+    void resetEstimate();
+
+    Output m_output;
+    QTimer m_timer;
+    QQueue<Pending> m_queue;
+    qint64 m_maxDelayUs;
+    QVector<qint64> m_transits;                     // 最近若干帧的传输时间（环形缓冲）
+    int m_transitPos;
+    int m_transitCount;
+    qint64 m_lastTransitUs;
+    double m_jitterUs;
+    qint64 m_delayUs;
+};
+
+#endif // FRAMEPACER_H
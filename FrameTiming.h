@@ -0,0 +1,25 @@
+#ifndef FRAMETIMING_H
+#define FRAMETIMING_H
+
+#include <QtGlobal>
+#include <QMetaType>
+
+/**
+ * @brief 解码帧的时间信息，随帧一起从解码线程传到显示、录像和报警
+ *
+ * QImage 本身不带时间戳。解码器为每一帧填写流时间戳、采集时刻和解码序号：
+ * 显示端按时间戳均匀输出（FramePacer），录像按时间戳补帧/丢帧，报警图片按采集时刻命名。
+ */
+struct FrameTiming {
+    qint64 ptsUs = -1;              // 帧时间戳（微秒，相对流起点），流中没有时间戳时为-1
+    qint64 captureMs = 0;           // 采集时刻（墙钟毫秒）：收到RTCP发送端报告后按摄像机的NTP时间换算，否则为收包时刻
+    qint64 arrivalUs = 0;           // 对应视频包的到达时间（StreamMetrics::nowUs 单调时钟）
+    quint64 sequence = 0;           // 解码序号，从1开始；跳过和丢弃的帧也占序号，序号不连续说明中间有帧未输出
+    bool senderClock = false;       // captureMs 来自RTCP发送端报告
+
+    bool hasPts() const { return ptsUs >= 0; }
+};
+
+Q_DECLARE_METATYPE(FrameTiming)
+
+#endif // FRAMETIMING_H
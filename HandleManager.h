@@ -4,123 +4,229 @@
 #include <QObject>
 #include <QVector>
 #include <QQueue>
+#include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 #include <QSharedPointer>
 
 /**
- * @brief 带版本号的句柄管理器，用于管理多路视频流资源
+ * @brief 视频流句柄：高 32 位是代数（generation），低 32 位是槽位索引
+ *
+ * 代数从 1 开始且最高位不用，合法句柄总是正数，-1 仍表示无效句柄。
+ */
+using StreamHandle = qint64;
+
+/**
+ * @brief 带代数校验的句柄管理器（slot map），用于管理多路视频流资源
+ *
+ * - 查询（getResource/size）不加锁、不等待：槽位按固定大小分段分配，段一旦分配在管理器析构前
+ *   既不移动也不释放，读线程只做原子读，读完资源指针后再核对代数，句柄已释放或槽位已复用时返回空。
+ * - 创建/释放/替换由互斥锁串行化，槽位通过 FIFO 回收队列延迟复用，代数在释放时递增。
+ * - 有效句柄另外记录在紧凑的活动列表中，getAllHandles 只遍历有效句柄，size 为 O(1)。
+ *
+ * 返回的裸指针与之前一样只在句柄释放前有效；资源本身由共享指针（可带自定义释放器）持有。
+ *
  * @tparam T 资源类型，必须继承自QObject
  */
 template <typename T>
 class HandleManager {
 public:
-    using Handle = int;  // 使用 int 类型作为句柄
+    using Handle = StreamHandle;
 
     static_assert(std::is_base_of<QObject, T>::value, "T must inherit from QObject");
 
+    static const quint32 SegmentSize = 1024;         // 每段槽位数
+    static const quint32 MaxSegments = 4096;         // 最多段数，共 4M 个槽位
+
     HandleManager() = default;
+    HandleManager(const HandleManager&) = delete;
+    HandleManager& operator=(const HandleManager&) = delete;
+
+    ~HandleManager() {
+        QMutexLocker locker(&mutex_);
+        for (quint32 i = 0; i < MaxSegments; ++i) {
+            delete segments_[i].loadAcquire();
+        }
+    }
 
     // 创建句柄，关联资源
     Handle createHandle(T* resource) {
+        return createHandle(QSharedPointer<T>(resource));
+    }
+
+    // 创建句柄，关联共享资源（可带自定义释放器，资源不一定由句柄独占），槽位用尽时返回 -1
+    Handle createHandle(QSharedPointer<T> resource) {
         QMutexLocker locker(&mutex_);
 
         quint32 index;
-        quint32 version;
-
         if (!freeList_.isEmpty()) {
-            index = freeList_.dequeue();              // 从回收列表中取出索引
-            version = entries_[index].version + 1;   // 更新版本号
+            index = freeList_.dequeue();             // 从回收列表中取出索引
         } else {
-            index = static_cast<quint32>(entries_.size());
-            version = 1;                             // 初始版本号为 1
-            entries_.append(HandleEntry());         // 初始化新的条目
+            index = slotCount_;
+            if (index >= SegmentSize * MaxSegments) {
+                return -1;
+            }
+            quint32 segment = index / SegmentSize;
+            if (!segments_[segment].loadAcquire()) {
+                segments_[segment].storeRelease(new Segment());
+            }
+            ++slotCount_;
         }
 
-        entries_[index].resource = QSharedPointer<T>(resource);
-        entries_[index].version = version;
+        Slot& slot = slotAt(index);
+        slot.owner = resource;
+        slot.livePos = live_.size();
+        live_.append(index);
+        slot.resource.storeRelease(resource.data());  // 代数在释放时已递增，发布资源即可
+        count_.fetchAndAddRelease(1);
 
-        return encodeHandle(index, version);         // 返回编码后的句柄
+        return encodeHandle(index, slot.generation.loadAcquire());
     }
 
     // 释放句柄
     void releaseHandle(Handle handle) {
-        QMutexLocker locker(&mutex_);
+        QSharedPointer<T> released;
+        {
+            QMutexLocker locker(&mutex_);
 
-        quint32 index, version;
-        decodeHandle(handle, index, version);
+            Slot* slot = liveSlot(handle);
+            if (!slot) {
+                return; // 非法或已释放的句柄，忽略
+            }
 
-        if (index >= static_cast<quint32>(entries_.size()) || entries_[index].version != version) {
-            return; // 非法或已释放的句柄，忽略
+            quint32 index = decodeIndex(handle);
+            slot->generation.storeRelease(nextGeneration(slot->generation.loadAcquire())); // 旧句柄立即失效
+            slot->resource.storeRelease(nullptr);
+            released.swap(slot->owner);
+
+            // 从活动列表中移除（与末尾交换）
+            int pos = slot->livePos;
+            quint32 last = live_.last();
+            live_[pos] = last;
+            slotAt(last).livePos = pos;
+            live_.removeLast();
+            slot->livePos = -1;
+
+            freeList_.enqueue(index);                 // 将索引加入回收列表
+            count_.fetchAndSubRelease(1);
         }
-
-        auto& entry = entries_[index];
-        entry.resource.clear();          // 清空资源
-        freeList_.enqueue(index);        // 将索引加入回收列表
+        // 资源在锁外释放，释放器可能回调其它模块
     }
 
-    // 根据句柄获取资源
-    T* getResource(Handle handle) const {
-        QMutexLocker locker(&mutex_);
+    // 替换句柄关联的资源，句柄值保持不变（旧资源随共享指针释放）
+    bool replaceResource(Handle handle, QSharedPointer<T> resource) {
+        QSharedPointer<T> replaced;
+        {
+            QMutexLocker locker(&mutex_);
 
-        quint32 index, version;
-        decodeHandle(handle, index, version);
+            Slot* slot = liveSlot(handle);
+            if (!slot) {
+                return false;
+            }
+
+            replaced.swap(slot->owner);
+            slot->owner = resource;
+            slot->resource.storeRelease(resource.data());
+        }
+        return true;
+    }
 
-        if (index >= static_cast<quint32>(entries_.size()) || entries_[index].version != version) {
-            return nullptr; // 非法或已释放的句柄
+    // 根据句柄获取资源（无锁）
+    T* getResource(Handle handle) const {
+        if (handle <= 0) {
+            return nullptr;
+        }
+        quint32 index = decodeIndex(handle);
+        const Segment* segment = index / SegmentSize < MaxSegments
+            ? segments_[index / SegmentSize].loadAcquire() : nullptr;
+        if (!segment) {
+            return nullptr; // 非法句柄
         }
 
-        return entries_[index].resource.data();
+        const Slot& slot = segment->slots[index % SegmentSize];
+        T* resource = slot.resource.loadAcquire();
+        if (slot.generation.loadAcquire() != decodeGeneration(handle)) {
+            return nullptr; // 已释放的句柄
+        }
+        return resource;
     }
 
     // 获取所有有效的句柄
     QList<Handle> getAllHandles() const {
         QMutexLocker locker(&mutex_);
         QList<Handle> handles;
-        
-        for (int i = 0; i < entries_.size(); ++i) {
-            if (entries_[i].resource) {
-                handles.append(encodeHandle(i, entries_[i].version));
-            }
+        handles.reserve(live_.size());
+        for (quint32 index : live_) {
+            handles.append(encodeHandle(index, slotAt(index).generation.loadAcquire()));
         }
         return handles;
     }
 
-    // 获取资源数量
+    // 获取资源数量（无锁）
     int size() const {
-        QMutexLocker locker(&mutex_);
-        int count = 0;
-        for (const auto& entry : entries_) {
-            if (entry.resource) {
-                count++;
-            }
-        }
-        return count;
+        return count_.loadAcquire();
     }
 
 private:
-    struct HandleEntry {
-        QSharedPointer<T> resource;  // 使用 QSharedPointer 管理资源
-        quint32 version = 0;         // 版本号
+    struct Slot {
+        QAtomicPointer<T> resource;               // 对读线程发布的资源指针
+        QAtomicInteger<quint32> generation;       // 当前（或下一个）句柄的代数
+        QSharedPointer<T> owner;                  // 持有资源，仅在锁内访问
+        int livePos = -1;                         // 在活动列表中的位置，-1表示空闲
 
-        HandleEntry() : resource(nullptr), version(0) {} // 默认构造函数
-        HandleEntry(QSharedPointer<T> res, quint32 ver) : resource(std::move(res)), version(ver) {}
+        Slot() : resource(nullptr), generation(1) {}
     };
 
-    QVector<HandleEntry> entries_;   // 句柄表
+    struct Segment {
+        Slot slots[SegmentSize];
+    };
+
+    QAtomicPointer<Segment> segments_[MaxSegments];  // 段表，段只增不减
+    quint32 slotCount_ = 0;          // 已分配过的槽位数
+    QVector<quint32> live_;          // 有效句柄的槽位索引
     QQueue<quint32> freeList_;       // 自由链表（回收队列）
-    mutable QMutex mutex_;           // 线程安全锁
+    QAtomicInt count_;               // 有效句柄数量
+    mutable QMutex mutex_;           // 写操作锁
+
+    Slot& slotAt(quint32 index) const {
+        return segments_[index / SegmentSize].loadAcquire()->slots[index % SegmentSize];
+    }
+
+    // 锁内调用：句柄有效时返回槽位
+    Slot* liveSlot(Handle handle) const {
+        if (handle <= 0) {
+            return nullptr;
+        }
+        quint32 index = decodeIndex(handle);
+        if (index >= slotCount_) {
+            return nullptr;
+        }
+        Slot& slot = slotAt(index);
+        if (slot.livePos < 0 || slot.generation.loadAcquire() != decodeGeneration(handle)) {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+    // 代数只用低 31 位，回绕时跳过 0
+    static quint32 nextGeneration(quint32 generation) {
+        return generation >= 0x7FFFFFFFu ? 1u : generation + 1u;
+    }
+
+    // 编码句柄，将索引和代数合成为一个 64 位整数
+    static Handle encodeHandle(quint32 index, quint32 generation) {
+        return static_cast<Handle>((static_cast<quint64>(generation) << 32) | index); // 高 32 位是代数，低 32 位是索引
+    }
 
-    // 编码句柄，将索引和版本号合成为一个整数
-    Handle encodeHandle(quint32 index, quint32 version) const {
-        return (version << 16) | (index & 0xFFFF); // 高 16 位是版本号，低 16 位是索引
+    static quint32 decodeIndex(Handle handle) {
+        return static_cast<quint32>(static_cast<quint64>(handle) & 0xFFFFFFFFu);
     }
 
-    // 解码句柄，拆分为索引和版本号
-    void decodeHandle(Handle handle, quint32& index, quint32& version) const {
-        version = static_cast<quint32>(handle >> 16);
-        index = static_cast<quint32>(handle & 0xFFFF);
+    static quint32 decodeGeneration(Handle handle) {
+        return static_cast<quint32>(static_cast<quint64>(handle) >> 32);
     }
 };
 
-#endif // HANDLEMANAGER_H
\ No newline at end of file
+#endif // HANDLEMANAGER_H
@@ -0,0 +1,309 @@
+#include "MediaIndex.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QRegularExpression>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+MediaIndex::MediaIndex(QObject *parent)
+    : QObject(parent)
+{
+    // 连接名带上对象地址，允许多个相册窗口同时打开
+    m_connName = "MediaIndex_" + QString::number(reinterpret_cast<quintptr>(this), 16);
+
+    // 录制或批量报警时目录会连续变化，延迟合并后再同步
+    m_reconcileTimer.setSingleShot(true);
+    m_reconcileTimer.setInterval(300);
+    connect(&m_reconcileTimer, &QTimer::timeout, this, &MediaIndex::onReconcileTimeout);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &MediaIndex::onDirectoryChanged);
+}
+
+MediaIndex::~MediaIndex()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connName);
+}
+
+bool MediaIndex::open(const QString& dbPath)
+{
+    QString path = dbPath;
+    if (path.isEmpty()) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataDir);
+        path = dataDir + "/media.db";
+    }
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", m_connName);
+    m_database.setDatabaseName(path);
+    if (!m_database.open()) {
+        qWarning() << "Cannot open media index:" << m_database.lastError().text();
+        return false;
+    }
+
+    QSqlQuery pragma(m_database);
+    pragma.exec("PRAGMA journal_mode=WAL");
+    pragma.exec("PRAGMA synchronous=NORMAL");
+
+    return createTables();
+}
+
+bool MediaIndex::createTables()
+{
+    QSqlQuery query(m_database);
+
+    QString createMediaSql = R"(
+        CREATE TABLE IF NOT EXISTS media (
+            album INTEGER NOT NULL,        -- 相册编号
+            name TEXT NOT NULL,            -- 文件名
+            path TEXT NOT NULL,            -- 文件绝对路径
+            ts INTEGER NOT NULL,           -- 拍摄时间，毫秒时间戳
+            size INTEGER DEFAULT 0,        -- 文件大小
+            PRIMARY KEY (album, name)
+        )
+    )";
+    QString createAlbumSql = R"(
+        CREATE TABLE IF NOT EXISTS albums (
+            album INTEGER PRIMARY KEY,     -- 相册编号
+            dir TEXT NOT NULL,             -- 相册目录
+            dir_mtime INTEGER DEFAULT 0    -- 上次同步时的目录修改时间
+        )
+    )";
+
+    if (!query.exec(createMediaSql) || !query.exec(createAlbumSql)
+        || !query.exec("CREATE INDEX IF NOT EXISTS idx_media_album_ts ON media(album, ts, name)")) {
+        qWarning() << "Cannot create media index tables:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void MediaIndex::setAlbumDirectory(int album, const QString& dirPath, const QStringList& nameFilters)
+{
+    AlbumInfo info;
+    info.dirPath = QDir(dirPath).absolutePath();
+    info.nameFilters = nameFilters;
+    m_albums.insert(album, info);
+
+    if (!m_watcher.directories().contains(info.dirPath)) {
+        m_watcher.addPath(info.dirPath);
+    }
+
+    // 相册目录变更（例如源码目录被移动）时旧索引作废，重新全量建立
+    bool force = false;
+    QSqlQuery query(m_database);
+    query.prepare("SELECT dir FROM albums WHERE album = ?");
+    query.addBindValue(album);
+    if (query.exec() && query.next() && query.value(0).toString() != info.dirPath) {
+        QSqlQuery clear(m_database);
+        clear.prepare("DELETE FROM media WHERE album = ?");
+        clear.addBindValue(album);
+        clear.exec();
+        force = true;
+    }
+
+    reconcile(album, force);
+}
+
+bool MediaIndex::reconcile(int album, bool force)
+{
+    if (!m_albums.contains(album) || !m_database.isOpen()) {
+        return false;
+    }
+
+    const AlbumInfo info = m_albums.value(album);
+    QDir dir(info.dirPath);
+    if (!dir.exists()) {
+        return false;
+    }
+
+    // 目录修改时间未变，说明没有文件增删，直接使用已有索引
+    qint64 dirMtime = QFileInfo(info.dirPath).lastModified().toMSecsSinceEpoch();
+    if (!force && dirMtime == storedDirMtime(album)) {
+        return false;
+    }
+
+    // 只取文件名，不为每个文件构造QFileInfo
+    QSet<QString> onDisk;
+    const QStringList names = dir.entryList(info.nameFilters, QDir::Files | QDir::NoSymLinks);
+    onDisk.reserve(names.size());
+    for (const QString& name : names) {
+        onDisk.insert(name);
+    }
+
+    QSet<QString> indexed;
+    QSqlQuery select(m_database);
+    select.setForwardOnly(true);
+    select.prepare("SELECT name FROM media WHERE album = ?");
+    select.addBindValue(album);
+    if (!select.exec()) {
+        qWarning() << "Media index query failed:" << select.lastError().text();
+        return false;
+    }
+    while (select.next()) {
+        indexed.insert(select.value(0).toString());
+    }
+
+    QSet<QString> added = onDisk - indexed;
+    QSet<QString> removed = indexed - onDisk;
+
+    // 任何一步失败都整体回滚且不记录目录修改时间，下次打开相册时重新比对
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        if (!m_database.transaction()) {
+            qWarning() << "Cannot start media index transaction:" << m_database.lastError().text();
+            return false;
+        }
+
+        QSqlQuery remove(m_database);
+        remove.prepare("DELETE FROM media WHERE album = ? AND name = ?");
+        for (const QString& name : removed) {
+            remove.addBindValue(album);
+            remove.addBindValue(name);
+            if (!remove.exec()) {
+                qWarning() << "Media index delete failed:" << remove.lastError().text();
+                m_database.rollback();
+                return false;
+            }
+        }
+
+        QSqlQuery insert(m_database);
+        insert.prepare("INSERT OR REPLACE INTO media (album, name, path, ts, size) VALUES (?, ?, ?, ?, ?)");
+        for (const QString& name : added) {
+            QFileInfo fileInfo(dir.filePath(name));
+            qint64 timestamp = parseTimestamp(name);
+            if (timestamp == 0) {
+                // 文件名中没有时间，退回使用文件修改时间（只在入库时读取一次）
+                timestamp = fileInfo.lastModified().toMSecsSinceEpoch();
+            }
+            insert.addBindValue(album);
+            insert.addBindValue(name);
+            insert.addBindValue(fileInfo.absoluteFilePath());
+            insert.addBindValue(timestamp);
+            insert.addBindValue(fileInfo.size());
+            if (!insert.exec()) {
+                qWarning() << "Media index insert failed:" << insert.lastError().text();
+                m_database.rollback();
+                return false;
+            }
+        }
+
+        if (!m_database.commit()) {
+            qWarning() << "Cannot commit media index:" << m_database.lastError().text();
+            m_database.rollback();
+            return false;
+        }
+    }
+
+    storeDirMtime(album, dirMtime);
+    return !added.isEmpty() || !removed.isEmpty();
+}
+
+int MediaIndex::count(int album)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT COUNT(*) FROM media WHERE album = ?");
+    query.addBindValue(album);
+    if (!query.exec() || !query.next()) {
+        return 0;
+    }
+    return query.value(0).toInt();
+}
+
+QVector<MediaEntry> MediaIndex::page(int album, bool ascending, int offset, int limit)
+{
+    QVector<MediaEntry> result;
+
+    QString order = ascending ? "ASC" : "DESC";
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT path, ts, size FROM media WHERE album = ? "
+                          "ORDER BY ts %1, name %1 LIMIT ? OFFSET ?").arg(order));
+    query.addBindValue(album);
+    query.addBindValue(limit);
+    query.addBindValue(offset);
+    if (!query.exec()) {
+        qWarning() << "Media page query failed:" << query.lastError().text();
+        return result;
+    }
+
+    result.reserve(limit);
+    while (query.next()) {
+        MediaEntry entry;
+        entry.path = query.value(0).toString();
+        entry.timestamp = query.value(1).toLongLong();
+        entry.size = query.value(2).toLongLong();
+        result.append(entry);
+    }
+    return result;
+}
+
+bool MediaIndex::removeEntry(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM media WHERE path = ?");
+    query.addBindValue(path);
+    return query.exec();
+}
+
+qint64 MediaIndex::parseTimestamp(const QString& fileName)
+{
+    // 文件名格式：20240101_123456_789.jpg、ALARM_20240101_123456_789.jpg，毫秒部分可选
+    static const QRegularExpression timeRegex(R"((\d{8})_(\d{6})(?:_(\d{3}))?)");
+    QRegularExpressionMatch match = timeRegex.match(fileName);
+    if (!match.hasMatch()) {
+        return 0;
+    }
+
+    QDateTime time = QDateTime::fromString(match.captured(1) + match.captured(2), "yyyyMMddHHmmss");
+    if (!time.isValid()) {
+        return 0;
+    }
+    return time.toMSecsSinceEpoch() + match.captured(3).toInt();
+}
+
+void MediaIndex::onDirectoryChanged(const QString& dirPath)
+{
+    for (auto it = m_albums.constBegin(); it != m_albums.constEnd(); ++it) {
+        if (it.value().dirPath == dirPath) {
+            m_dirtyAlbums.insert(it.key());
+        }
+    }
+    m_reconcileTimer.start();
+}
+
+void MediaIndex::onReconcileTimeout()
+{
+    const QSet<int> albums = m_dirtyAlbums;
+    m_dirtyAlbums.clear();
+    for (int album : albums) {
+        if (reconcile(album)) {
+            emit albumChanged(album);
+        }
+    }
+}
+
+qint64 MediaIndex::storedDirMtime(int album)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT dir_mtime FROM albums WHERE album = ?");
+    query.addBindValue(album);
+    if (!query.exec() || !query.next()) {
+        return -1;
+    }
+    return query.value(0).toLongLong();
+}
+
+void MediaIndex::storeDirMtime(int album, qint64 mtime)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT OR REPLACE INTO albums (album, dir, dir_mtime) VALUES (?, ?, ?)");
+    query.addBindValue(album);
+    query.addBindValue(m_albums.value(album).dirPath);
+    query.addBindValue(mtime);
+    query.exec();
+}
@@ -0,0 +1,79 @@
+#ifndef MEDIAINDEX_H
+#define MEDIAINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QSqlDatabase>
+
+/**
+ * @brief 媒体索引中的单个文件
+ */
+struct MediaEntry {
+    QString path;        // 文件绝对路径
+    qint64 timestamp;    // 拍摄时间（毫秒时间戳，入库时从文件名解析）
+    qint64 size;         // 文件大小
+
+    MediaEntry() : timestamp(0), size(0) {}
+};
+
+/**
+ * @brief 相册媒体索引，保存在SQLite中
+ *
+ * 每个相册目录对应一个album编号。文件名中的时间在入库时解析一次，
+ * 之后按时间排序和分页都由数据库完成；目录通过QFileSystemWatcher
+ * 监听，变化后只对新增/删除的文件做增量更新。
+ */
+class MediaIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MediaIndex(QObject *parent = nullptr);
+    ~MediaIndex();
+
+    bool open(const QString& dbPath = QString());   // 打开索引数据库，默认路径为应用数据目录下的media.db
+
+    // 相册目录管理
+    void setAlbumDirectory(int album, const QString& dirPath, const QStringList& nameFilters); // 注册相册目录并同步索引
+    bool reconcile(int album, bool force = false);  // 与磁盘目录对比并增量更新，目录未修改时跳过
+
+    // 查询接口
+    int count(int album);                           // 相册文件总数
+    QVector<MediaEntry> page(int album, bool ascending, int offset, int limit); // 按时间分页查询
+
+    bool removeEntry(const QString& path);          // 删除单个文件的索引（文件已被删除时调用）
+
+    static qint64 parseTimestamp(const QString& fileName); // 从文件名解析时间，失败返回0
+
+signals:
+    void albumChanged(int album);                   // 相册内容发生变化
+
+private slots:
+    void onDirectoryChanged(const QString& dirPath); // 目录变化
+    void onReconcileTimeout();                      // 合并短时间内的多次变化后统一同步
+
+private:
+    bool createTables();                            // 创建索引表
+    qint64 storedDirMtime(int album);               // 上次同步时的目录修改时间
+    void storeDirMtime(int album, qint64 mtime);    // 记录目录修改时间
+
+    struct AlbumInfo {
+        QString dirPath;         // 相册目录
+        QStringList nameFilters; // 文件过滤器
+    };
+
+    QSqlDatabase m_database;                // 索引数据库
+    QString m_connName;                     // 数据库连接名称
+    QHash<int, AlbumInfo> m_albums;         // 已注册的相册
+    QFileSystemWatcher m_watcher;           // 目录监听
+    QSet<int> m_dirtyAlbums;                // 等待同步的相册
+    QTimer m_reconcileTimer;                // 同步延迟定时器
+};
+
+#endif // MEDIAINDEX_H
@@ -0,0 +1,98 @@
+#ifndef METRICSHTTPSERVER_H
+#define METRICSHTTPSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <functional>
+
+#include "StreamMetrics.h"
+
+class QTcpSocket;
+
+/**
+ * @brief Prometheus 文本格式（text exposition 0.0.4）的指标输出
+ *
+ * 同名指标的样本按指标族聚合输出，调用方可以按流交替写入不同指标。
+ */
+class MetricsText
+{
+public:
+    void counter(const QString& name, const QString& help, double value, const QString& labels = QString());
+    void gauge(const QString& name, const QString& help, double value, const QString& labels = QString());
+    void histogram(const QString& name, const QString& help, const LatencyHistogram::Snapshot& snapshot,
+                   const QString& labels = QString());  // 微秒直方图按秒输出
+
+    QString text() const;
+
+    static QString label(const QString& key, const QString& value);  // 生成 key="value"（已转义）
+    static QString urlLabel(const QString& url);                      // url="..."，去掉地址中的用户名和密码
+
+private:
+    struct Family {
+        QString name;
+        QString help;
+        QString type;
+        QStringList samples;
+    };
+
+    Family& family(const QString& name, const QString& help, const QString& type);
+    static QString sample(const QString& name, const QString& labels, double value);
+
+    QVector<Family> m_families;
+    QHash<QString, int> m_index;                // 指标名 -> m_families 下标
+};
+
+/**
+ * @brief 内置的指标HTTP服务，供监控系统无人值守地抓取
+ *
+ * GET /metrics 返回 Prometheus 文本格式。默认只监听 127.0.0.1:9464，
+ * 可以用环境变量 RTSP_METRICS_ADDR / RTSP_METRICS_PORT 修改，端口为 0 时不启动。
+ * 自带进程和视频流（会话缓存中的全部解码器）指标，其余模块通过 addCollector() 追加。
+ * 只在界面线程中使用，每次抓取时现场采集，不额外占用定时器。
+ * 不保存抓取之间的状态，多个监控系统同时抓取互不影响；帧率等速率由监控系统对计数器求 rate() 得到。
+ */
+class MetricsHttpServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Collector = std::function<void(MetricsText& out)>;
+
+    explicit MetricsHttpServer(QObject *parent = nullptr);
+    ~MetricsHttpServer();
+
+    bool start();                                           // 按环境变量配置启动
+    bool listen(const QHostAddress& address, quint16 port);
+    void stop();
+    bool isListening() const { return m_server->isListening(); }
+    QString listenAddress() const;                          // 如 127.0.0.1:9464
+    QString lastError() const { return m_lastError; }
+
+    void addCollector(const Collector& collector);
+    QString render();                                       // 生成一次完整的指标文本
+
+    static void collectStorageMetrics(MetricsText& out, const QString& path); // path所在磁盘的剩余/总空间
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+
+private:
+    void collectProcessMetrics(MetricsText& out);
+    void collectStreamMetrics(MetricsText& out);
+    void sendResponse(QTcpSocket* socket, int status, const QString& reason,
+                      const QByteArray& contentType, const QByteArray& body);
+
+    QTcpServer* m_server;
+    QList<Collector> m_collectors;
+    QElapsedTimer m_uptime;
+    QString m_lastError;
+};
+
+#endif // METRICSHTTPSERVER_H
@@ -1,16 +1,32 @@
 #include "MultiStreamController.h"
 #include <QDebug>
 #include <QMutexLocker>
+#include <QMultiMap>
+#include <QVector>
+#include <algorithm>
+#include "StreamSessionCache.h"
 
 MultiStreamController::MultiStreamController(QObject *parent)
     : QObject(parent)
     , m_streamManager(nullptr)
     , m_videoGrid(nullptr)
+    , m_promotedHandle(-1)
+    , m_promotedDecoder(nullptr)
+    , m_statsOverlayEnabled(false)
 {
+    m_statsTimer = new QTimer(this);
+    connect(m_statsTimer, &QTimer::timeout, this, &MultiStreamController::onStatsTimer);
+    m_statsTimer->start(1000);
 }
 
 MultiStreamController::~MultiStreamController()
 {
+    releasePromotion();
+    
+    // 排队中的帧不再写入网格
+    for (const StreamInfo& info : m_streamInfos) {
+        info.frameTarget->storeRelease(-1);
+    }
 }
 
 void MultiStreamController::setStreamManager(MultiStreamManager* manager)
@@ -22,8 +38,7 @@ void MultiStreamController::setStreamManager(MultiStreamManager* manager)
     m_streamManager = manager;
     
     if (m_streamManager) {
-        connect(m_streamManager, &MultiStreamManager::frameReady,
-                this, &MultiStreamController::onFrameReady);
+        m_streamManager->setFramePacing(true);  // 网格画面按帧时间戳均匀显示，吸收网络抖动
         connect(m_streamManager, &MultiStreamManager::streamConnected,
                 this, &MultiStreamController::onStreamConnected);
         connect(m_streamManager, &MultiStreamManager::streamDisconnected,
@@ -44,6 +59,10 @@ void MultiStreamController::setVideoGrid(VideoGridWidget* grid)
     if (m_videoGrid) {
         connect(m_videoGrid, &VideoGridWidget::videoClicked,
                 this, &MultiStreamController::onVideoClicked);
+        connect(m_videoGrid, &VideoGridWidget::videoDoubleClicked,
+                this, &MultiStreamController::onVideoDoubleClicked);
+        connect(m_videoGrid, &VideoGridWidget::promotionChanged,
+                this, &MultiStreamController::onPromotionChanged);
         connect(m_videoGrid, &VideoGridWidget::layoutChanged,
                 this, &MultiStreamController::onGridLayoutChanged);
         connect(m_videoGrid, &VideoGridWidget::pageChanged,
@@ -51,7 +70,12 @@ void MultiStreamController::setVideoGrid(VideoGridWidget* grid)
     }
 }
 
-int MultiStreamController::addStream(const QString& url)
+StreamHandle MultiStreamController::addStream(const QString& url)
+{
+    return addStream(CameraProfile(url));
+}
+
+StreamHandle MultiStreamController::addStream(const CameraProfile& profile)
 {
     if (!m_streamManager) {
         qWarning() << "Stream manager not set";
@@ -60,8 +84,10 @@ int MultiStreamController::addStream(const QString& url)
     
     QMutexLocker locker(&m_mutex);
     
-    // 创建流
-    int handle = m_streamManager->addStream(url);
+    // 创建流，小格子使用子码流，帧直接写入网格
+    QString url = profile.urlFor(isLargeLayout());
+    QSharedPointer<QAtomicInt> frameTarget(new QAtomicInt(-1));
+    StreamHandle handle = m_streamManager->addStream(url, gridFrameSink(frameTarget));
     if (handle < 0) {
         qWarning() << "Failed to add stream:" << url;
         return -1;
@@ -70,18 +96,18 @@ int MultiStreamController::addStream(const QString& url)
     // 获取显示索引
     int displayIndex = getNextDisplayIndex();
     
-    // 建立映射
-    m_handleToDisplayIndex[handle] = displayIndex;
-    m_displayIndexToHandle[displayIndex] = handle;
-    
     // 保存流信息
     StreamInfo info;
     info.handle = handle;
     info.url = url;
+    info.profile = profile;
     info.connected = false;
-    info.displayIndex = displayIndex;
+    info.frameTarget = frameTarget;
     m_streamInfos[handle] = info;
     
+    // 建立映射
+    setDisplayIndex(handle, displayIndex);
+    
     // 更新视频网格
     if (m_videoGrid) {
         m_videoGrid->setTotalStreamCount(m_streamInfos.size());
@@ -93,7 +119,7 @@ int MultiStreamController::addStream(const QString& url)
     return handle;
 }
 
-void MultiStreamController::removeStream(int handle)
+void MultiStreamController::removeStream(StreamHandle handle)
 {
     if (!m_streamManager) {
         return;
@@ -110,6 +136,7 @@ void MultiStreamController::removeStream(int handle)
     StreamInfo info = it.value();
     QString url = info.url;
     int displayIndex = info.displayIndex;
+    info.frameTarget->storeRelease(-1);
     
     // 移除流
     m_streamManager->removeStream(handle);
@@ -143,7 +170,10 @@ void MultiStreamController::removeAllStreams()
     QMutexLocker locker(&m_mutex);
     
     // 获取所有句柄
-    QList<int> handles = m_streamInfos.keys();
+    QList<StreamHandle> handles = m_streamInfos.keys();
+    for (const StreamInfo& info : m_streamInfos) {
+        info.frameTarget->storeRelease(-1);
+    }
     
     // 移除所有流
     m_streamManager->removeAllStreams();
@@ -160,27 +190,125 @@ void MultiStreamController::removeAllStreams()
     }
     
     // 发送移除信号
-    for (int handle : handles) {
+    for (StreamHandle handle : handles) {
         emit streamRemoved(handle, "");
     }
     
     qDebug() << "Removed all streams";
 }
 
-QList<int> MultiStreamController::getAllStreamHandles()
+QList<StreamHandle> MultiStreamController::applyStreams(const QStringList& urls)
+{
+    return applyStreams(CameraProfile::fromUrls(urls));
+}
+
+QList<StreamHandle> MultiStreamController::applyStreams(const QList<CameraProfile>& profiles)
+{
+    QList<StreamHandle> result;
+    if (!m_streamManager) {
+        qWarning() << "Stream manager not set";
+        return result;
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    
+    // 已打开的流按码流配置分组，同一摄像头在新列表中出现几次就复用几路
+    auto profileKey = [](const CameraProfile& profile) {
+        return profile.subUrl + QLatin1Char('\n') + profile.mainUrl;
+    };
+    QMultiMap<QString, StreamHandle> reusable;
+    for (auto it = m_streamInfos.begin(); it != m_streamInfos.end(); ++it) {
+        reusable.insert(profileKey(it.value().profile), it.key());
+    }
+    
+    QVector<StreamHandle> handles(profiles.size(), -1);
+    for (int i = 0; i < profiles.size(); ++i) {
+        auto it = reusable.find(profileKey(profiles[i]));
+        if (it != reusable.end()) {
+            handles[i] = it.value();
+            reusable.erase(it);
+        }
+    }
+    
+    // 新列表中用不到的流一次性移除
+    QList<StreamHandle> removedHandles = reusable.values();
+    QMap<StreamHandle, QString> removedUrls;
+    for (StreamHandle handle : removedHandles) {
+        StreamInfo info = m_streamInfos.take(handle);
+        info.frameTarget->storeRelease(-1);
+        removedUrls[handle] = info.url;
+    }
+    m_streamManager->removeStreams(removedHandles);
+    
+    // 缺少的流全部启动，各解码线程并行建立连接
+    QList<StreamHandle> addedHandles;
+    bool largeLayout = isLargeLayout();
+    for (int i = 0; i < profiles.size(); ++i) {
+        if (handles[i] != -1) {
+            continue;
+        }
+        QString url = profiles[i].urlFor(largeLayout);
+        QSharedPointer<QAtomicInt> frameTarget(new QAtomicInt(-1));
+        StreamHandle handle = m_streamManager->addStream(url, gridFrameSink(frameTarget));
+        if (handle < 0) {
+            qWarning() << "Failed to add stream:" << url;
+            continue;
+        }
+        StreamInfo info;
+        info.handle = handle;
+        info.url = url;
+        info.profile = profiles[i];
+        info.connected = false;
+        info.frameTarget = frameTarget;
+        m_streamInfos[handle] = info;
+        handles[i] = handle;
+        addedHandles.append(handle);
+    }
+    
+    // 显示顺序与列表顺序一致
+    m_handleToDisplayIndex.clear();
+    m_displayIndexToHandle.clear();
+    int displayIndex = 0;
+    for (StreamHandle handle : handles) {
+        result.append(handle);
+        if (handle < 0) {
+            continue;
+        }
+        setDisplayIndex(handle, displayIndex);
+        ++displayIndex;
+    }
+    
+    if (m_videoGrid) {
+        m_videoGrid->setTotalStreamCount(m_streamInfos.size());
+    }
+    refreshVideoGrid();
+    
+    for (StreamHandle handle : removedHandles) {
+        emit streamRemoved(handle, removedUrls.value(handle));
+    }
+    for (StreamHandle handle : addedHandles) {
+        emit streamAdded(handle, m_streamInfos.value(handle).url);
+    }
+    
+    qDebug() << "Applied streams:" << profiles.size() << "reused:" << (profiles.size() - addedHandles.size())
+             << "added:" << addedHandles.size() << "removed:" << removedHandles.size();
+    return result;
+}
+
+QList<StreamHandle> MultiStreamController::getAllStreamHandles()
 {
     QMutexLocker locker(&m_mutex);
     return m_streamInfos.keys();
 }
 
-void MultiStreamController::pauseStream(int handle)
+void MultiStreamController::pauseStream(StreamHandle handle)
 {
     if (m_streamManager) {
         m_streamManager->pauseStream(handle);
     }
 }
 
-void MultiStreamController::resumeStream(int handle)
+void MultiStreamController::resumeStream(StreamHandle handle)
 {
     if (m_streamManager) {
         m_streamManager->resumeStream(handle);
@@ -229,6 +357,35 @@ void MultiStreamController::selectVideo(int globalIndex)
     }
 }
 
+void MultiStreamController::promoteVideo(int globalIndex)
+{
+    if (!m_videoGrid) {
+        return;
+    }
+    
+    // 网格先放大显示缓存的最后一帧，通过promotionChanged回调切换解码输出
+    if (globalIndex == m_videoGrid->getPromotedIndex()) {
+        return;
+    }
+    m_videoGrid->demoteVideo();
+    m_videoGrid->promoteVideo(globalIndex);
+}
+
+void MultiStreamController::demoteVideo()
+{
+    if (m_videoGrid) {
+        m_videoGrid->demoteVideo();
+    }
+}
+
+int MultiStreamController::getPromotedVideoIndex() const
+{
+    if (m_videoGrid) {
+        return m_videoGrid->getPromotedIndex();
+    }
+    return -1;
+}
+
 int MultiStreamController::getStreamCount() const
 {
     QMutexLocker locker(&m_mutex);
@@ -265,27 +422,13 @@ QList<MultiStreamController::StreamInfo> MultiStreamController::getAllStreamInfo
     return m_streamInfos.values();
 }
 
-MultiStreamController::StreamInfo MultiStreamController::getStreamInfo(int handle) const
+MultiStreamController::StreamInfo MultiStreamController::getStreamInfo(StreamHandle handle) const
 {
     QMutexLocker locker(&m_mutex);
     return m_streamInfos.value(handle);
 }
 
-void MultiStreamController::onFrameReady(int handle, const QImage& frame)
-{
-    QMutexLocker locker(&m_mutex);
-    
-    // 查找显示索引
-    auto it = m_handleToDisplayIndex.find(handle);
-    if (it != m_handleToDisplayIndex.end()) {
-        int displayIndex = it.value();
-        if (m_videoGrid) {
-            m_videoGrid->setVideoFrame(displayIndex, frame);
-        }
-    }
-}
-
-void MultiStreamController::onStreamConnected(int handle, const QString& url)
+void MultiStreamController::onStreamConnected(StreamHandle handle, const QString& url)
 {
     QMutexLocker locker(&m_mutex);
     
@@ -298,7 +441,7 @@ void MultiStreamController::onStreamConnected(int handle, const QString& url)
     emit streamConnected(handle, url);
 }
 
-void MultiStreamController::onStreamDisconnected(int handle, const QString& url)
+void MultiStreamController::onStreamDisconnected(StreamHandle handle, const QString& url)
 {
     QMutexLocker locker(&m_mutex);
     
@@ -310,7 +453,7 @@ void MultiStreamController::onStreamDisconnected(int handle, const QString& url)
     emit streamDisconnected(handle, url);
 }
 
-void MultiStreamController::onStreamError(int handle, const QString& error)
+void MultiStreamController::onStreamError(StreamHandle handle, const QString& error)
 {
     QMutexLocker locker(&m_mutex);
     
@@ -328,8 +471,75 @@ void MultiStreamController::onVideoClicked(int globalIndex)
     selectVideo(globalIndex);
 }
 
+void MultiStreamController::onVideoDoubleClicked(int globalIndex)
+{
+    promoteVideo(globalIndex);
+}
+
+void MultiStreamController::onPromotionChanged(int globalIndex)
+{
+    releasePromotion();
+    if (globalIndex < 0 || !m_streamManager) {
+        return;
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    auto it = m_displayIndexToHandle.find(globalIndex);
+    if (it == m_displayIndexToHandle.end()) {
+        return;
+    }
+    m_promotedHandle = it.value();
+    const StreamInfo& info = m_streamInfos[m_promotedHandle];
+    
+    if (!info.profile.hasMainStream() || info.url == info.profile.mainUrl) {
+        // 没有主码流或已在使用主码流：当前会话切换到全分辨率、全帧率输出
+        m_streamManager->setStreamFocused(m_promotedHandle, true);
+        return;
+    }
+    QString mainUrl = info.profile.mainUrl;
+    
+    // 子码流画面：打开主码流会话（近期放大过时仍在缓存中），首帧到达前继续放大显示子码流画面
+    m_promotedDecoder = StreamSessionCache::instance()->acquire(mainUrl);
+    StreamSessionCache::instance()->setFocused(m_promotedDecoder, true);
+    connect(m_promotedDecoder, &MultiStreamDecoder::frameReady,
+            this, &MultiStreamController::onPromotedFrameReady);
+    QImage lastFrame = m_promotedDecoder->getCurrentFrame();
+    if (!lastFrame.isNull() && m_videoGrid) {
+        m_videoGrid->setPromotedFrame(lastFrame);
+    }
+    qDebug() << "Promote stream" << m_promotedHandle << "to main stream:" << mainUrl;
+}
+
+void MultiStreamController::onPromotedFrameReady(const QImage& frame)
+{
+    if (sender() == m_promotedDecoder && m_videoGrid) {
+        m_videoGrid->setPromotedFrame(frame);
+    }
+}
+
+void MultiStreamController::releasePromotion()
+{
+    if (m_promotedDecoder) {
+        // 主码流会话交还缓存，短时间内再次放大可直接复用
+        disconnect(m_promotedDecoder, nullptr, this, nullptr);
+        StreamSessionCache::instance()->setFocused(m_promotedDecoder, false);
+        StreamSessionCache::instance()->release(m_promotedDecoder);
+        m_promotedDecoder = nullptr;
+    }
+    if (m_promotedHandle >= 0) {
+        if (m_streamManager) {
+            m_streamManager->setStreamFocused(m_promotedHandle, false);
+        }
+        m_promotedHandle = -1;
+    }
+}
+
 void MultiStreamController::onGridLayoutChanged(GridLayout layout)
 {
+    {
+        QMutexLocker locker(&m_mutex);
+        updateStreamQuality();
+    }
     emit layoutChanged(layout);
 }
 
@@ -338,31 +548,155 @@ void MultiStreamController::onGridPageChanged(int page)
     emit pageChanged(page);
 }
 
+void MultiStreamController::setStatsOverlayEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_statsOverlayEnabled = enabled;
+    if (!enabled && m_videoGrid) {
+        m_videoGrid->clearVideoOverlays();
+    }
+}
+
+bool MultiStreamController::isStatsOverlayEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statsOverlayEnabled;
+}
+
+StreamMetrics::Report MultiStreamController::getStreamReport(StreamHandle handle) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_metricReports.value(handle);
+}
+
+QImage MultiStreamController::getCurrentFrame(StreamHandle handle, FrameTiming* timing)
+{
+    if (!m_streamManager) {
+        return QImage();
+    }
+    if (timing) {
+        *timing = m_streamManager->getCurrentFrameTiming(handle);
+    }
+    return m_streamManager->getCurrentFrame(handle);
+}
+
+void MultiStreamController::onStatsTimer()
+{
+    if (!m_streamManager) {
+        return;
+    }
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        
+        QMap<StreamHandle, MetricSample> samples;
+        QMap<StreamHandle, StreamMetrics::Report> reports;
+        if (m_statsOverlayEnabled && m_videoGrid) {
+            m_videoGrid->clearVideoOverlays(); // 已移除或已换位置的画面不保留旧统计
+        }
+        for (auto it = m_streamInfos.begin(); it != m_streamInfos.end(); ++it) {
+            StreamHandle handle = it.key();
+            StreamMetrics* metrics = m_streamManager->getStreamMetrics(handle);
+            if (!metrics) {
+                continue;
+            }
+            
+            MetricSample sample;
+            sample.source = metrics;
+            sample.snapshot = metrics->snapshot();
+            
+            // 计数来源没变时才能求差，刚添加或刚切换码流的流下一秒再出结果
+            auto previous = m_metricSamples.find(handle);
+            if (previous != m_metricSamples.end() && previous.value().source == metrics) {
+                reports[handle] = StreamMetrics::report(sample.snapshot, previous.value().snapshot);
+            }
+            samples[handle] = sample;
+            
+            if (m_statsOverlayEnabled && m_videoGrid) {
+                m_videoGrid->setVideoOverlay(it.value().displayIndex,
+                                             reports.contains(handle) ? reports[handle].overlayText() : QString("统计中..."));
+            }
+        }
+        m_metricSamples = samples;
+        m_metricReports = reports;
+    }
+    
+    emit statsUpdated();
+}
+
+bool MultiStreamController::isLargeLayout() const
+{
+    // 1x1和2x2布局的格子接近整屏，子码流分辨率不够
+    return m_videoGrid && static_cast<int>(m_videoGrid->getCurrentLayout()) <= static_cast<int>(GridLayout::Grid_2x2);
+}
+
+void MultiStreamController::updateStreamQuality()
+{
+    if (!m_streamManager) {
+        return;
+    }
+    
+    bool largeLayout = isLargeLayout();
+    int switchedCount = 0;
+    for (auto it = m_streamInfos.begin(); it != m_streamInfos.end(); ++it) {
+        StreamInfo& info = it.value();
+        QString url = info.profile.urlFor(largeLayout);
+        if (url != info.url && m_streamManager->switchStreamUrl(info.handle, url)) {
+            info.url = url;
+            ++switchedCount;
+        }
+    }
+    if (switchedCount > 0) {
+        qDebug() << "Switched" << switchedCount << "streams to" << (largeLayout ? "main stream" : "substream");
+    }
+}
+
 void MultiStreamController::updateDisplayMapping()
 {
     // 重新排列显示索引，使其连续
-    QMap<int, int> newHandleToDisplay;
-    QMap<int, int> newDisplayToHandle;
+    m_handleToDisplayIndex.clear();
+    m_displayIndexToHandle.clear();
     
-    QList<int> handles = m_streamInfos.keys();
-    std::sort(handles.begin(), handles.end());
+    // 按原显示顺序排列，保持方案中设定的画面位置
+    QList<StreamHandle> handles = m_streamInfos.keys();
+    std::sort(handles.begin(), handles.end(), [this](StreamHandle a, StreamHandle b) {
+        return m_streamInfos[a].displayIndex < m_streamInfos[b].displayIndex;
+    });
     
     for (int i = 0; i < handles.size(); ++i) {
-        int handle = handles[i];
-        newHandleToDisplay[handle] = i;
-        newDisplayToHandle[i] = handle;
-        
-        // 更新流信息中的显示索引
-        m_streamInfos[handle].displayIndex = i;
+        setDisplayIndex(handles[i], i);
     }
     
-    m_handleToDisplayIndex = newHandleToDisplay;
-    m_displayIndexToHandle = newDisplayToHandle;
-    
     // 刷新视频网格
     refreshVideoGrid();
 }
 
+void MultiStreamController::setDisplayIndex(StreamHandle handle, int displayIndex)
+{
+    m_handleToDisplayIndex[handle] = displayIndex;
+    m_displayIndexToHandle[displayIndex] = handle;
+    
+    // 更新流信息中的显示索引，画面接收者随之写入新位置
+    StreamInfo& info = m_streamInfos[handle];
+    info.displayIndex = displayIndex;
+    info.frameTarget->storeRelease(displayIndex);
+}
+
+MultiStreamManager::FrameSink MultiStreamController::gridFrameSink(const QSharedPointer<QAtomicInt>& target)
+{
+    // 帧路径不查映射也不加锁：显示位置变化时只改写共享的索引
+    return [this, target](StreamHandle handle, const QImage& frame, const FrameTiming& timing) {
+        int displayIndex = target->loadAcquire();
+        if (displayIndex >= 0 && m_videoGrid) {
+            qint64 startUs = StreamMetrics::nowUs();
+            m_videoGrid->setVideoFrame(displayIndex, frame);
+            if (StreamMetrics* metrics = m_streamManager->getStreamMetrics(handle)) {
+                metrics->recordRendered(StreamMetrics::nowUs() - startUs, timing.arrivalUs);
+            }
+        }
+    };
+}
+
 int MultiStreamController::getNextDisplayIndex()
 {
     // 返回下一个可用的显示索引
@@ -380,7 +714,7 @@ void MultiStreamController::refreshVideoGrid()
     
     // 重新设置所有帧
     for (auto it = m_handleToDisplayIndex.begin(); it != m_handleToDisplayIndex.end(); ++it) {
-        int handle = it.key();
+        StreamHandle handle = it.key();
         int displayIndex = it.value();
         
         QImage frame = m_streamManager->getCurrentFrame(handle);
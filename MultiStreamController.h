@@ -8,9 +8,14 @@
 #include <QImage>
 #include <QString>
 #include <QList>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QSharedPointer>
 
 #include "MultiStreamManager.h"
 #include "VideoGridWidget.h"
+#include "CameraProfile.h"
+#include "StreamMetrics.h"
 
 /**
  * @brief 多路视频流控制器，协调流管理器和显示组件
@@ -28,14 +33,17 @@ public:
     void setVideoGrid(VideoGridWidget* grid);
 
     // 流管理接口
-    int addStream(const QString& url);              // 添加视频流
-    void removeStream(int handle);                  // 移除视频流  
+    StreamHandle addStream(const QString& url);     // 添加视频流
+    StreamHandle addStream(const CameraProfile& profile); // 添加摄像头（按当前布局选择主/子码流）
+    void removeStream(StreamHandle handle);         // 移除视频流
     void removeAllStreams();                        // 移除所有流
-    QList<int> getAllStreamHandles();               // 获取所有流句柄
+    QList<StreamHandle> applyStreams(const QStringList& urls); // 按列表整体替换当前流（同URL复用），返回与列表一一对应的句柄
+    QList<StreamHandle> applyStreams(const QList<CameraProfile>& profiles); // 同上，按摄像头码流配置
+    QList<StreamHandle> getAllStreamHandles();      // 获取所有流句柄
 
     // 流控制接口
-    void pauseStream(int handle);                   // 暂停流
-    void resumeStream(int handle);                  // 恢复流
+    void pauseStream(StreamHandle handle);          // 暂停流
+    void resumeStream(StreamHandle handle);         // 恢复流
     void pauseAllStreams();                         // 暂停所有流
     void resumeAllStreams();                        // 恢复所有流
 
@@ -43,6 +51,11 @@ public:
     void setGridLayout(GridLayout layout);          // 设置网格布局
     void setCurrentPage(int page);                  // 设置当前页
     void selectVideo(int globalIndex);              // 选择视频
+    void promoteVideo(int globalIndex);             // 放大视频（切换到全分辨率/主码流）
+    void demoteVideo();                             // 恢复网格显示（切回格子画面/子码流）
+    int getPromotedVideoIndex() const;              // 获取放大的视频索引
+    void setStatsOverlayEnabled(bool enabled);      // 在各画面上叠加显示流水线统计
+    bool isStatsOverlayEnabled() const;
 
     // 获取状态信息
     int getStreamCount() const;                     // 获取流数量
@@ -52,48 +65,70 @@ public:
 
     // 流信息管理
     struct StreamInfo {
-        int handle;
-        QString url;
+        StreamHandle handle;
+        QString url;               // 当前解码的地址（子码流或主码流）
+        CameraProfile profile;     // 摄像头码流配置
         bool connected;
         QString lastError;
         int displayIndex;  // 在显示中的索引位置
+        QSharedPointer<QAtomicInt> frameTarget;    // 画面接收者使用的显示索引，-1表示已移除
     };
     
     QList<StreamInfo> getAllStreamInfo() const;     // 获取所有流信息
-    StreamInfo getStreamInfo(int handle) const;     // 获取指定流信息
+    StreamInfo getStreamInfo(StreamHandle handle) const; // 获取指定流信息
+    StreamMetrics::Report getStreamReport(StreamHandle handle) const; // 获取最近一秒的流水线统计
+    QImage getCurrentFrame(StreamHandle handle, FrameTiming* timing = nullptr); // 最近解码的一帧（报警图片用）
 
 signals:
-    void streamAdded(int handle, const QString& url);
-    void streamRemoved(int handle, const QString& url);
-    void streamConnected(int handle, const QString& url);
-    void streamDisconnected(int handle, const QString& url);
-    void streamError(int handle, const QString& error);
-    void videoSelected(int globalIndex, int handle);
+    void streamAdded(StreamHandle handle, const QString& url);
+    void streamRemoved(StreamHandle handle, const QString& url);
+    void streamConnected(StreamHandle handle, const QString& url);
+    void streamDisconnected(StreamHandle handle, const QString& url);
+    void streamError(StreamHandle handle, const QString& error);
+    void videoSelected(int globalIndex, StreamHandle handle);
     void layoutChanged(GridLayout layout);
     void pageChanged(int page);
+    void statsUpdated();                            // 流水线统计已刷新（每秒一次）
 
 private slots:
     // 流管理器信号处理
-    void onFrameReady(int handle, const QImage& frame);
-    void onStreamConnected(int handle, const QString& url);
-    void onStreamDisconnected(int handle, const QString& url);
-    void onStreamError(int handle, const QString& error);
+    void onStreamConnected(StreamHandle handle, const QString& url);
+    void onStreamDisconnected(StreamHandle handle, const QString& url);
+    void onStreamError(StreamHandle handle, const QString& error);
     
     // 视频网格信号处理
     void onVideoClicked(int globalIndex);
+    void onVideoDoubleClicked(int globalIndex);
+    void onPromotionChanged(int globalIndex);
+    void onPromotedFrameReady(const QImage& frame);
     void onGridLayoutChanged(GridLayout layout);
     void onGridPageChanged(int page);
+    void onStatsTimer();                            // 采样各路计数并刷新统计
 
 private:
     MultiStreamManager* m_streamManager;
     VideoGridWidget* m_videoGrid;
     
     // 流到显示索引的映射
-    QMap<int, int> m_handleToDisplayIndex;  // 句柄 -> 显示索引
-    QMap<int, int> m_displayIndexToHandle;  // 显示索引 -> 句柄
+    QMap<StreamHandle, int> m_handleToDisplayIndex;  // 句柄 -> 显示索引
+    QMap<int, StreamHandle> m_displayIndexToHandle;  // 显示索引 -> 句柄
     
     // 流信息
-    QMap<int, StreamInfo> m_streamInfos;
+    QMap<StreamHandle, StreamInfo> m_streamInfos;
+    
+    // 放大显示
+    StreamHandle m_promotedHandle;                  // 放大的句柄，-1表示未放大
+    MultiStreamDecoder* m_promotedDecoder;          // 放大时使用的主码流会话
+    
+    // 流水线统计
+    struct MetricSample {
+        StreamMetrics* source = nullptr;            // 切换主/子码流后计数来源会变化
+        StreamMetrics::Snapshot snapshot;
+    };
+    QTimer* m_statsTimer;
+    bool m_statsOverlayEnabled;
+    QMap<StreamHandle, MetricSample> m_metricSamples;        // 上一次采样
+    QMap<StreamHandle, StreamMetrics::Report> m_metricReports; // 最近一次统计结果
     
     mutable QMutex m_mutex;
     
@@ -101,6 +136,11 @@ private:
     void updateDisplayMapping();                    // 更新显示映射
     int getNextDisplayIndex();                      // 获取下一个可用的显示索引
     void refreshVideoGrid();                        // 刷新视频网格显示
+    void setDisplayIndex(StreamHandle handle, int displayIndex); // 更新句柄的显示位置（含画面接收者）
+    MultiStreamManager::FrameSink gridFrameSink(const QSharedPointer<QAtomicInt>& target); // 句柄的帧直接写入网格
+    void releasePromotion();                        // 释放放大时占用的焦点和主码流会话
+    bool isLargeLayout() const;                     // 当前布局的格子是否足够大（使用主码流）
+    void updateStreamQuality();                     // 按当前布局切换各路的主/子码流
 };
 
 #endif // MULTISTREAMCONTROLLER_H
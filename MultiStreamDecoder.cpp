@@ -1,17 +1,42 @@
 #include "MultiStreamDecoder.h"
+#include "FrameBufferPool.h"
+#include "FrameMemoryBudget.h"
 #include <QDebug>
+#include <QFileInfo>
+#include <QDateTime>
 
 MultiStreamDecoder::MultiStreamDecoder(const QString& url, QObject *parent)
     : QThread(parent)
     , m_url(url)
-    , m_connected(false)
-    , m_paused(false)
-    , m_stop(false)
+    , m_state(static_cast<int>(State::Created))
+    , m_pauseRequested(0)
+    , m_stopRequested(0)
+    , m_idleTeardownMs(30000)
+    , m_isFile(QFileInfo(url).isFile())
+    , m_seekRequestMs(-1)
+    , m_dropUntilMs(-1)
+    , m_showNextFrame(false)
+    , m_eof(false)
+    , m_clockBasePtsMs(-1)
+    , m_frameIntervalMs(0)
+    , m_budgetSlot(nullptr)
+    , m_frameSequence(0)
+    , m_lastPtsUs(-1)
+    , m_frameIntervalUs(0.0)
+    , m_frameRateMilli(0)
     , m_formatContext(nullptr)
     , m_codecContext(nullptr)
     , m_swsContext(nullptr)
     , m_videoStreamIndex(-1)
 {
+    qRegisterMetaType<FrameTiming>("FrameTiming");
+
+    // 最后一帧用于放大/重新订阅时先显示：有订阅者在接收画面时视为可见，暂停后内存紧张时可以丢弃
+    FrameMemoryBudget::instance()->addOwner(this, "decoder", [this](int) {
+        QMutexLocker locker(&m_frameMutex);
+        m_currentFrame = QImage();
+    });
+    m_budgetSlot = FrameMemoryBudget::instance()->slot(this, 0);
 }
 
 MultiStreamDecoder::~MultiStreamDecoder()
@@ -19,6 +44,7 @@ MultiStreamDecoder::~MultiStreamDecoder()
     stopDecoding();
     wait(); // 等待线程结束
     cleanupFFmpeg();
+    FrameMemoryBudget::instance()->removeOwner(this);
 }
 
 QImage MultiStreamDecoder::getCurrentFrame()
@@ -27,56 +53,218 @@ QImage MultiStreamDecoder::getCurrentFrame()
     return m_currentFrame;
 }
 
+FrameTiming MultiStreamDecoder::getCurrentFrameTiming()
+{
+    QMutexLocker locker(&m_frameMutex);
+    return m_currentTiming;
+}
+
+double MultiStreamDecoder::frameRate() const
+{
+    return m_frameRateMilli.loadAcquire() / 1000.0;
+}
+
+bool MultiStreamDecoder::isConnected() const
+{
+    State current = state();
+    return current == State::Running || current == State::Paused;
+}
+
 void MultiStreamDecoder::pauseDecoding()
 {
-    m_paused = true;
+    m_pauseRequested.storeRelease(1);
+    m_budgetSlot->setVisible(false);
 }
 
 void MultiStreamDecoder::resumeDecoding()
 {
-    m_paused = false;
+    m_pauseRequested.storeRelease(0);
+    m_budgetSlot->setVisible(true);
+    wakeDecoder();
 }
 
 void MultiStreamDecoder::stopDecoding()
 {
-    m_stop = true;
+    // 只发出请求，不等待线程结束；阻塞中的网络读取由中断回调打断
+    m_stopRequested.storeRelease(1);
+    wakeDecoder();
+}
+
+void MultiStreamDecoder::setIdleTeardownInterval(int ms)
+{
+    m_idleTeardownMs.storeRelease(ms);
+    wakeDecoder();
+}
+
+void MultiStreamDecoder::wakeDecoder()
+{
+    // 先加锁再唤醒：解码线程检查条件和进入等待之间不会漏掉唤醒
+    QMutexLocker locker(&m_waitMutex);
+    m_waitCondition.wakeAll();
+}
+
+void MultiStreamDecoder::setState(State state)
+{
+    if (m_state.fetchAndStoreOrdered(static_cast<int>(state)) != static_cast<int>(state)) {
+        emit stateChanged(state);
+    }
+}
+
+void MultiStreamDecoder::setOutputSize(const QSize& size)
+{
+    QMutexLocker locker(&m_frameMutex);
+    m_outputSize = size;
+}
+
+void MultiStreamDecoder::setMaxFrameRate(int fps)
+{
+    QMutexLocker locker(&m_frameMutex);
+    m_frameIntervalMs = fps > 0 ? 1000 / fps : 0;
+}
+
+void MultiStreamDecoder::seekTo(qint64 positionMs)
+{
+    if (!m_isFile) {
+        return;
+    }
+    // 只保留最新的定位请求，拖动进度条时中间位置直接跳过
+    {
+        QMutexLocker locker(&m_seekMutex);
+        m_seekRequestMs = qMax<qint64>(0, positionMs);
+    }
+    // 暂停或读完文件时解码线程在等待，唤醒后执行定位
+    wakeDecoder();
 }
 
 void MultiStreamDecoder::run()
 {
+    setState(State::Connecting);
     if (!initFFmpeg()) {
+        setState(State::Finished);
         emit errorOccurred("Failed to initialize FFmpeg for: " + m_url);
         return;
     }
 
-    m_connected = true;
+    setState(State::Running);
     emit connectionStatusChanged(true);
 
+    if (m_isFile && m_formatContext->duration > 0) {
+        emit durationChanged(m_formatContext->duration / 1000); // AV_TIME_BASE为微秒
+    }
+
     AVPacket packet;
     AVFrame* frame = av_frame_alloc();
+
+    // 转换并输出一帧，arrivalUs为对应视频包的到达时间
+    auto outputFrame = [this](AVFrame* decoded, qint64 arrivalUs) {
+        FrameTiming timing = makeFrameTiming(decoded, arrivalUs);
+        if (m_isFile) {
+            if (!handleFileFrame(decoded)) {
+                return;
+            }
+            timing.arrivalUs = StreamMetrics::nowUs(); // 文件按时间戳节奏输出，节奏等待不计入延迟
+            timing.captureMs = QDateTime::currentMSecsSinceEpoch();
+        } else {
+            // 网格中的小画面限制输出帧率：仍然解码每一帧（保持参考帧完整），只跳过格式转换和显示
+            int intervalMs = 0;
+            {
+                QMutexLocker locker(&m_frameMutex);
+                intervalMs = m_frameIntervalMs;
+            }
+            if (intervalMs > 0 && m_outputClock.isValid() && m_outputClock.elapsed() < intervalMs) {
+                m_metrics.recordSkipped();
+                return;
+            }
+            m_outputClock.start();
+        }
+        qint64 convertStartUs = StreamMetrics::nowUs();
+        QImage image = convertFrameToImage(decoded);
+        if (image.isNull()) {
+            m_metrics.recordDropped();
+        } else {
+            m_metrics.recordConverted(StreamMetrics::nowUs() - convertStartUs);
+            {
+                QMutexLocker locker(&m_frameMutex);
+                m_currentFrame = image;
+                m_currentTiming = timing;
+            }
+            m_budgetSlot->track(image, !m_pauseRequested.loadAcquire());
+            emit frameReady(image, timing);
+        }
+    };
     
-    while (!m_stop) {
-        if (m_paused) {
-            msleep(30);
+    while (!isStopRequested()) {
+        // 暂停超时断开后恢复播放：重新建立连接，失败时每秒重试
+        if (!m_formatContext) {
+            {
+                // 重连期间再次暂停：不再重试，等待恢复
+                QMutexLocker locker(&m_waitMutex);
+                while (m_pauseRequested.loadAcquire() && !isStopRequested()) {
+                    m_waitCondition.wait(&m_waitMutex);
+                }
+            }
+            if (isStopRequested()) {
+                break;
+            }
+            setState(State::Connecting);
+            m_metrics.recordReconnect();
+            if (!initFFmpeg()) {
+                cleanupFFmpeg();
+                QMutexLocker locker(&m_waitMutex);
+                if (!isStopRequested()) {
+                    m_waitCondition.wait(&m_waitMutex, 1000);
+                }
+                continue;
+            }
+            setState(State::Running);
+            emit connectionStatusChanged(true);
+        }
+
+        if (m_isFile) {
+            qint64 seekMs = -1;
+            {
+                QMutexLocker locker(&m_seekMutex);
+                seekMs = m_seekRequestMs;
+                m_seekRequestMs = -1;
+            }
+            if (seekMs >= 0) {
+                performSeek(seekMs);
+            }
+        }
+
+        if ((m_pauseRequested.loadAcquire() && !m_showNextFrame) || m_eof) {
+            m_clockBasePtsMs = -1; // 恢复播放后重新对齐播放时钟
+            if (!waitWhilePaused()) {
+                break;
+            }
             continue;
         }
 
+        qint64 demuxStartUs = StreamMetrics::nowUs();
         if (av_read_frame(m_formatContext, &packet) >= 0) {
             if (packet.stream_index == m_videoStreamIndex) {
+                qint64 arrivalUs = StreamMetrics::nowUs();
+                m_metrics.recordPacket(packet.size, arrivalUs - demuxStartUs);
+                qint64 decodeStartUs = arrivalUs;
                 if (avcodec_send_packet(m_codecContext, &packet) == 0) {
                     while (avcodec_receive_frame(m_codecContext, frame) == 0) {
-                        QImage image = convertFrameToImage(frame);
-                        if (!image.isNull()) {
-                            {
-                                QMutexLocker locker(&m_frameMutex);
-                                m_currentFrame = image;
-                            }
-                            emit frameReady(image);
-                        }
+                        qint64 decodedUs = StreamMetrics::nowUs();
+                        m_metrics.recordDecoded(decodedUs - decodeStartUs);
+                        outputFrame(frame, arrivalUs);
+                        decodeStartUs = StreamMetrics::nowUs();
                     }
                 }
             }
             av_packet_unref(&packet);
+        } else if (m_isFile) {
+            // 文件读完：送入空包取出解码器中缓存的剩余帧，之后等待定位或停止
+            avcodec_send_packet(m_codecContext, nullptr);
+            while (avcodec_receive_frame(m_codecContext, frame) == 0) {
+                m_metrics.recordDecoded(0);
+                outputFrame(frame, StreamMetrics::nowUs());
+            }
+            m_eof = true;
+            emit playbackFinished();
         } else {
             // 读取失败，可能是网络中断
             msleep(100);
@@ -85,14 +273,318 @@ void MultiStreamDecoder::run()
 
     av_frame_free(&frame);
     
-    m_connected = false;
-    emit connectionStatusChanged(false);
+    bool wasConnected = isConnected();
+    setState(State::Stopping);
+    if (wasConnected) {
+        emit connectionStatusChanged(false);
+    }
+    cleanupFFmpeg(); // 在解码线程内释放，回收时不再占用其他线程
+    setState(State::Finished);
+}
+
+bool MultiStreamDecoder::isIdle()
+{
+    if (isStopRequested() || !(m_pauseRequested.loadAcquire() || m_eof)) {
+        return false;
+    }
+    QMutexLocker locker(&m_seekMutex);
+    return m_seekRequestMs < 0;
+}
+
+bool MultiStreamDecoder::waitWhilePaused()
+{
+    // 实时流发送RTSP PAUSE，服务器停止推流，套接字中不再积压数据
+    bool readPaused = false;
+    if (!m_isFile) {
+        readPaused = av_read_pause(m_formatContext) >= 0;
+    }
+
+    if (m_pauseRequested.loadAcquire()) {
+        setState(State::Paused);
+    }
+
+    QMutexLocker locker(&m_waitMutex);
+    QElapsedTimer idleTimer;
+    idleTimer.start();
+    bool tornDown = false;
+    while (isIdle()) {
+        if (m_isFile || tornDown) {
+            m_waitCondition.wait(&m_waitMutex);
+            continue;
+        }
+
+        // 长时间暂停后断开连接：服务器在没有保活请求时也会超时关闭会话；
+        // 不支持PAUSE的协议（如HTTP）数据仍在推送，尽快断开
+        int teardownMs = m_idleTeardownMs.loadAcquire();
+        int idleMs = readPaused ? teardownMs : qMin(teardownMs, 2000);
+        qint64 remainingMs = idleMs - idleTimer.elapsed();
+        if (remainingMs > 0) {
+            m_waitCondition.wait(&m_waitMutex, static_cast<unsigned long>(remainingMs));
+            continue;
+        }
+
+        locker.unlock();
+        cleanupFFmpeg();
+        setState(State::Disconnected);
+        emit connectionStatusChanged(false);
+        qDebug() << "Idle stream disconnected:" << m_url;
+        tornDown = true;
+        locker.relock();
+    }
+    locker.unlock();
+
+    if (isStopRequested()) {
+        return false;
+    }
+    // 未断开时发送RTSP PLAY继续推流；已断开的会话由主循环重新连接（最后一帧仍保留在m_currentFrame）
+    if (readPaused && !tornDown) {
+        av_read_play(m_formatContext);
+    }
+    if (!tornDown) {
+        setState(State::Running);
+    }
+    return true;
+}
+
+qint64 MultiStreamDecoder::framePositionMs(AVFrame* frame) const
+{
+    int64_t pts = frame->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) {
+        pts = frame->pts;
+    }
+    if (pts == AV_NOPTS_VALUE) {
+        return 0;
+    }
+
+    AVStream* stream = m_formatContext->streams[m_videoStreamIndex];
+    if (stream->start_time != AV_NOPTS_VALUE) {
+        pts -= stream->start_time;
+    }
+    AVRational msBase = {1, 1000};
+    return av_rescale_q(pts, stream->time_base, msBase);
+}
+
+void MultiStreamDecoder::performSeek(qint64 positionMs)
+{
+    AVStream* stream = m_formatContext->streams[m_videoStreamIndex];
+    AVRational msBase = {1, 1000};
+    int64_t target = av_rescale_q(positionMs, msBase, stream->time_base);
+    if (stream->start_time != AV_NOPTS_VALUE) {
+        target += stream->start_time;
+    }
+
+    // AVSEEK_FLAG_BACKWARD：跳到目标之前最近的关键帧，MP4等容器直接查样本索引，不需要逐包扫描
+    if (av_seek_frame(m_formatContext, m_videoStreamIndex, target, AVSEEK_FLAG_BACKWARD) < 0) {
+        qDebug() << "Seek failed:" << m_url << positionMs;
+        return;
+    }
+    avcodec_flush_buffers(m_codecContext);
+
+    m_dropUntilMs = positionMs;     // 关键帧到目标之间的帧只解码不显示
+    m_eof = false;
+    m_clockBasePtsMs = -1;
+    m_showNextFrame = m_pauseRequested.loadAcquire() != 0; // 暂停时定位也要刷新画面
+}
+
+FrameTiming MultiStreamDecoder::makeFrameTiming(AVFrame* frame, qint64 arrivalUs)
+{
+    FrameTiming timing;
+    timing.sequence = ++m_frameSequence;
+    timing.arrivalUs = arrivalUs;
+    // 没有发送端时间时用收包时刻（单调时钟换算到墙钟）
+    timing.captureMs = QDateTime::currentMSecsSinceEpoch() - (StreamMetrics::nowUs() - arrivalUs) / 1000;
+
+    int64_t pts = frame->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) {
+        pts = frame->pts;
+    }
+    if (pts == AV_NOPTS_VALUE) {
+        return timing;
+    }
+    AVStream* stream = m_formatContext->streams[m_videoStreamIndex];
+    AVRational usBase = {1, AV_TIME_BASE};
+    const qint64 rawUs = av_rescale_q(pts, stream->time_base, usBase);
+    const qint64 startUs = stream->start_time != AV_NOPTS_VALUE
+                           ? av_rescale_q(stream->start_time, stream->time_base, usBase) : 0;
+    timing.ptsUs = qMax<qint64>(0, rawUs - startUs);
+
+    // 帧率按相邻帧的时间戳间隔平滑估计，跳变（定位、重连）的间隔不计入
+    if (m_lastPtsUs >= 0) {
+        const qint64 deltaUs = timing.ptsUs - m_lastPtsUs;
+        if (deltaUs > 0 && deltaUs < 1000000) {
+            m_frameIntervalUs = m_frameIntervalUs > 0 ? m_frameIntervalUs + (deltaUs - m_frameIntervalUs) / 16.0
+                                                      : static_cast<double>(deltaUs);
+            m_frameRateMilli.storeRelease(qRound(1e9 / m_frameIntervalUs));
+        }
+    }
+    m_lastPtsUs = timing.ptsUs;
+
+    // 实时流收到第一个RTCP发送端报告后，FFmpeg 把时间戳0对应的NTP时间写入 start_time_realtime，
+    // 帧的采集时刻 = 该时间 + 帧时间戳。摄像机时钟明显不准（换算结果晚于收包时刻或早10秒以上）时不采用
+    if (!m_isFile && m_formatContext->start_time_realtime != AV_NOPTS_VALUE
+        && m_formatContext->start_time_realtime > 0) {
+        const qint64 senderMs = (m_formatContext->start_time_realtime + rawUs) / 1000;
+        if (senderMs <= timing.captureMs + 1000 && senderMs >= timing.captureMs - 10000) {
+            timing.captureMs = senderMs;
+            timing.senderClock = true;
+        }
+    }
+    return timing;
+}
+
+bool MultiStreamDecoder::handleFileFrame(AVFrame* frame)
+{
+    qint64 positionMs = framePositionMs(frame);
+
+    if (m_dropUntilMs >= 0) {
+        if (positionMs < m_dropUntilMs) {
+            return false;
+        }
+        m_dropUntilMs = -1;
+        m_clockBasePtsMs = -1;
+    }
+
+    if (m_showNextFrame) {
+        // 暂停状态下的定位：输出目标帧后继续保持暂停
+        m_showNextFrame = false;
+    } else {
+        // 按帧时间戳控制输出节奏
+        if (m_clockBasePtsMs < 0) {
+            m_clockBasePtsMs = positionMs;
+            m_clock.start();
+        }
+        qint64 waitMs = (positionMs - m_clockBasePtsMs) - m_clock.elapsed();
+        if (waitMs > 1000 || waitMs < -1000) {
+            // 时间戳跳变，重新对齐时钟
+            m_clockBasePtsMs = positionMs;
+            m_clock.start();
+            waitMs = 0;
+        }
+        while (waitMs > 0 && !isStopRequested()) {
+            // 分段等待，便于及时响应定位和停止
+            msleep(qMin<qint64>(waitMs, 20));
+            {
+                QMutexLocker locker(&m_seekMutex);
+                if (m_seekRequestMs >= 0) {
+                    return false;
+                }
+            }
+            waitMs = (positionMs - m_clockBasePtsMs) - m_clock.elapsed();
+        }
+    }
+
+    emit positionChanged(positionMs);
+    return true;
+}
+
+QImage MultiStreamDecoder::extractPosterFrame(const QString& filePath, const QSize& maxSize)
+{
+    AVFormatContext* formatContext = nullptr;
+    if (avformat_open_input(&formatContext, filePath.toUtf8().data(), nullptr, nullptr) != 0) {
+        return QImage();
+    }
+
+    QImage result;
+    AVCodecContext* codecContext = nullptr;
+    AVFrame* frame = nullptr;
+    AVPacket packet;
+
+    do {
+        if (avformat_find_stream_info(formatContext, nullptr) < 0) {
+            break;
+        }
+
+        int streamIndex = av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (streamIndex < 0) {
+            break;
+        }
+
+        AVCodecParameters* codecpar = formatContext->streams[streamIndex]->codecpar;
+        const AVCodec* codec = avcodec_find_decoder(codecpar->codec_id);
+        if (!codec) {
+            break;
+        }
+        codecContext = avcodec_alloc_context3(codec);
+        if (avcodec_parameters_to_context(codecContext, codecpar) < 0
+            || avcodec_open2(codecContext, codec, nullptr) < 0) {
+            break;
+        }
+
+        // 开头常有黑帧：定位到时长10%处（最多5秒）之前最近的关键帧，只解码这一个GOP的开头
+        if (formatContext->duration > 0) {
+            int64_t target = qMin<int64_t>(formatContext->duration / 10, 5 * AV_TIME_BASE);
+            if (av_seek_frame(formatContext, -1, target, AVSEEK_FLAG_BACKWARD) >= 0) {
+                avcodec_flush_buffers(codecContext);
+            }
+        }
+
+        frame = av_frame_alloc();
+        bool gotFrame = false;
+        int packetCount = 0;
+        while (!gotFrame && packetCount++ < 500 && av_read_frame(formatContext, &packet) >= 0) {
+            if (packet.stream_index == streamIndex && avcodec_send_packet(codecContext, &packet) == 0) {
+                gotFrame = (avcodec_receive_frame(codecContext, frame) == 0);
+            }
+            av_packet_unref(&packet);
+        }
+        if (!gotFrame) {
+            // 文件很短时帧可能还在解码器缓存中
+            avcodec_send_packet(codecContext, nullptr);
+            gotFrame = (avcodec_receive_frame(codecContext, frame) == 0);
+        }
+        if (!gotFrame || frame->width <= 0 || frame->height <= 0) {
+            break;
+        }
+
+        // 直接缩放到目标尺寸，不生成全分辨率中间图
+        QSize outSize(frame->width, frame->height);
+        if (maxSize.isValid() && (outSize.width() > maxSize.width() || outSize.height() > maxSize.height())) {
+            outSize.scale(maxSize, Qt::KeepAspectRatio);
+        }
+        SwsContext* swsContext = sws_getContext(
+            frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+            outSize.width(), outSize.height(), AV_PIX_FMT_RGB32,
+            SWS_BILINEAR, nullptr, nullptr, nullptr
+        );
+        if (!swsContext) {
+            break;
+        }
+
+        QImage image = allocateFrameImage(outSize);
+        if (image.isNull()) {
+            sws_freeContext(swsContext);
+            break;
+        }
+        uint8_t* dest[4] = { image.bits(), nullptr, nullptr, nullptr };
+        int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+        sws_scale(swsContext,
+                  const_cast<const uint8_t**>(frame->data), frame->linesize,
+                  0, frame->height, dest, destLinesize);
+        sws_freeContext(swsContext);
+        result = image;
+    } while (false);
+
+    if (frame) {
+        av_frame_free(&frame);
+    }
+    if (codecContext) {
+        avcodec_free_context(&codecContext);
+    }
+    avformat_close_input(&formatContext);
+    return result;
+}
+
+int MultiStreamDecoder::interruptCallback(void* opaque)
+{
+    return static_cast<MultiStreamDecoder*>(opaque)->isStopRequested() ? 1 : 0;
 }
 
 bool MultiStreamDecoder::initFFmpeg()
 {
-    // 打开输入流
+    // 打开输入流，停止时中断阻塞的连接和读取
     m_formatContext = avformat_alloc_context();
+    m_formatContext->interrupt_callback.callback = &MultiStreamDecoder::interruptCallback;
+    m_formatContext->interrupt_callback.opaque = this;
     if (avformat_open_input(&m_formatContext, m_url.toUtf8().data(), nullptr, nullptr) != 0) {
         qDebug() << "Cannot open input stream:" << m_url;
         return false;
@@ -139,6 +631,12 @@ bool MultiStreamDecoder::initFFmpeg()
         return false;
     }
 
+    // 解码出帧之前先用流信息中的平均帧率，之后按帧时间戳修正
+    AVRational rate = m_formatContext->streams[m_videoStreamIndex]->avg_frame_rate;
+    if (m_frameRateMilli.loadAcquire() == 0 && rate.num > 0 && rate.den > 0) {
+        m_frameRateMilli.storeRelease(qRound(av_q2d(rate) * 1000));
+    }
+
     return true;
 }
 
@@ -160,29 +658,58 @@ void MultiStreamDecoder::cleanupFFmpeg()
     }
 }
 
+QImage MultiStreamDecoder::allocateFrameImage(const QSize& size)
+{
+    // AV_PIX_FMT_RGB32 与 QImage::Format_RGB32 都是按本机字节序存放的 0xffRRGGBB，
+    // 光栅绘制引擎可以直接拷贝，不必像 RGB888 那样每次绘制前都转换一遍。
+    // 缓冲取自帧缓冲池（行宽按32字节对齐，sws_scale 的SIMD写入路径更快），图像释放后归还复用
+    return FrameBufferPool::instance()->acquireImage(size, QImage::Format_RGB32);
+}
+
 QImage MultiStreamDecoder::convertFrameToImage(AVFrame* frame)
 {
     if (!frame || frame->width <= 0 || frame->height <= 0) {
         return QImage();
     }
 
-    // 初始化转换上下文
-    if (!m_swsContext) {
-        m_swsContext = sws_getContext(
-            frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
-            frame->width, frame->height, AV_PIX_FMT_RGB24,
-            SWS_BILINEAR, nullptr, nullptr, nullptr
-        );
+    // 网格中只需要格子大小的画面，缩放在sws_scale中一次完成；尺寸变化时重建转换上下文
+    QSize outSize(frame->width, frame->height);
+    {
+        QMutexLocker locker(&m_frameMutex);
+        if (m_outputSize.isValid()
+            && (outSize.width() > m_outputSize.width() || outSize.height() > m_outputSize.height())) {
+            outSize.scale(m_outputSize, Qt::KeepAspectRatio);
+        }
     }
 
+    // 格子画面（YUV420P 缩小2倍以上）：转换和整数倍缩小一次完成，剩余不足2倍的缩放在小图上做
+    int factor = TileScaler::isEnabled()
+        ? TileScaler::factorFor(frame->format, QSize(frame->width, frame->height), outSize) : 0;
+    if (factor > 0) {
+        QSize boxSize(frame->width / factor, frame->height / factor);
+        QImage image = allocateFrameImage(boxSize);
+        if (!image.isNull() && m_tileScaler.scale(frame, factor, image.bits(), image.bytesPerLine())) {
+            return FrameBufferPool::instance()->scaledImage(image, outSize);
+        }
+    }
+
+    m_swsContext = sws_getCachedContext(m_swsContext,
+        frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+        outSize.width(), outSize.height(), AV_PIX_FMT_RGB32,
+        SWS_BILINEAR, nullptr, nullptr, nullptr
+    );
+
     if (!m_swsContext) {
         return QImage();
     }
 
     // 分配RGB图像缓冲区
-    QImage image(frame->width, frame->height, QImage::Format_RGB888);
+    QImage image = allocateFrameImage(outSize);
+    if (image.isNull()) {
+        return QImage();
+    }
     uint8_t* dest[4] = { image.bits(), nullptr, nullptr, nullptr };
-    int destLinesize[4] = { 3 * frame->width, 0, 0, 0 };
+    int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
 
     // 转换像素格式
     sws_scale(m_swsContext, 
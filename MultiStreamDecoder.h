@@ -5,9 +5,18 @@
 #include <QThread>
 #include <QImage>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QSize>
 #include <QDebug>
 
+#include "StreamMetrics.h"
+#include "TileScaler.h"
+#include "FrameTiming.h"
+#include "FrameMemoryBudget.h"
+
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
@@ -17,57 +26,132 @@ extern "C" {
 
 /**
  * @brief 多路视频流解码器，用于解码单路RTSP视频流
+ *
+ * 传入本地文件路径时进入文件回放模式：按帧时间戳实时节奏输出，
+ * 支持定位（先跳到目标之前最近的关键帧，再解码丢弃到目标时间）。
+ *
+ * 生命周期：状态只由解码线程写入（原子变量），界面线程通过暂停/恢复/停止请求控制，
+ * 请求同样是原子变量，不需要加锁即可在任意线程调用。停止请求不等待线程结束，
+ * 线程的回收交给DecoderReaper。
  */
 class MultiStreamDecoder : public QThread
 {
     Q_OBJECT
 
 public:
+    // 解码器状态
+    enum class State {
+        Created,        // 已创建，线程未启动
+        Connecting,     // 正在打开输入流
+        Running,        // 正在解码
+        Paused,         // 已暂停（实时流已发送RTSP PAUSE）
+        Disconnected,   // 暂停超时已断开连接，恢复时重新连接
+        Stopping,       // 已请求停止，正在退出
+        Finished        // 线程已退出
+    };
+    Q_ENUM(State)
+
     explicit MultiStreamDecoder(const QString& url, QObject *parent = nullptr);
     ~MultiStreamDecoder();
 
     // 获取当前帧
     QImage getCurrentFrame();
+    FrameTiming getCurrentFrameTiming();         // 当前帧的时间信息
+    double frameRate() const;                    // 按帧时间戳估计的帧率，未知时返回0
     
     // 获取流信息
     QString getUrl() const { return m_url; }
-    bool isConnected() const { return m_connected; }
+    State state() const { return static_cast<State>(m_state.loadAcquire()); }
+    bool isConnected() const;
+    bool isStopRequested() const { return m_stopRequested.loadAcquire() != 0; }
+    bool isFileSource() const { return m_isFile; }
+    StreamMetrics* metrics() { return &m_metrics; }  // 流水线计数（收包、解码、转换、显示）
     
     // 控制解码
     void pauseDecoding();
     void resumeDecoding();
     void stopDecoding();
+    void seekTo(qint64 positionMs);              // 定位到指定时间（仅文件回放模式）
+    void setOutputSize(const QSize& size);       // 输出帧的最大尺寸（等比缩小），空尺寸表示原始分辨率
+    void setMaxFrameRate(int fps);               // 输出帧率上限（仅实时流），0表示不限制
+    void setIdleTeardownInterval(int ms);        // 实时流暂停超过该时间后断开连接，恢复时重新连接
+
+    // 提取视频封面帧：定位到开头附近的关键帧并解码一帧，按maxSize等比缩小
+    static QImage extractPosterFrame(const QString& filePath, const QSize& maxSize);
 
 signals:
-    void frameReady(const QImage& frame);
+    // 输出帧为QImage::Format_RGB32，绘制时无需再转换格式；timing为帧时间戳、采集时刻和解码序号
+    void frameReady(const QImage& frame, const FrameTiming& timing);
     void connectionStatusChanged(bool connected);
     void errorOccurred(const QString& error);
+    void durationChanged(qint64 durationMs);    // 文件时长（文件回放模式）
+    void positionChanged(qint64 positionMs);    // 当前播放位置（文件回放模式）
+    void playbackFinished();                    // 文件播放到末尾
+    void stateChanged(MultiStreamDecoder::State state); // 状态改变（从解码线程发出）
 
 protected:
     void run() override;
 
 private:
     QString m_url;
-    bool m_connected;
-    bool m_paused;
-    bool m_stop;
+    QAtomicInt m_state;            // 当前状态（State），只由解码线程写入
+    QAtomicInt m_pauseRequested;   // 暂停请求
+    QAtomicInt m_stopRequested;    // 停止请求
+    QAtomicInt m_idleTeardownMs;   // 暂停后断开连接的时间
+    QMutex m_waitMutex;            // 只用于配合m_waitCondition，不保护状态
+    QWaitCondition m_waitCondition; // 暂停/文件读完时解码线程在此等待，恢复、定位、停止时唤醒
+    bool m_isFile;                 // 是否为本地文件回放
+    
+    // 文件回放：定位与播放节奏
+    QMutex m_seekMutex;            // 保护定位请求
+    qint64 m_seekRequestMs;        // 待处理的定位请求，-1表示无
+    qint64 m_dropUntilMs;          // 定位后丢弃早于该时间的帧，-1表示不丢弃
+    bool m_showNextFrame;          // 暂停状态下定位后仍输出一帧
+    bool m_eof;                    // 已读到文件末尾
+    qint64 m_clockBasePtsMs;       // 播放时钟起点对应的帧时间
+    QElapsedTimer m_clock;         // 播放时钟
     
     QImage m_currentFrame;
+    FrameTiming m_currentTiming;   // 由m_frameMutex保护
     QMutex m_frameMutex;
+    QSize m_outputSize;            // 输出帧的最大尺寸，由m_frameMutex保护
+    int m_frameIntervalMs;         // 输出帧的最小间隔，由m_frameMutex保护
+    QElapsedTimer m_outputClock;   // 上一次输出帧的时间（解码线程内使用）
+    StreamMetrics m_metrics;       // 无锁计数，解码线程和界面线程都会写入
+    FrameMemoryBudget::Slot* m_budgetSlot; // 当前帧在内存预算中的位置（每帧更新不加锁）
+    quint64 m_frameSequence;       // 已解码的帧数（解码线程内使用）
+    qint64 m_lastPtsUs;            // 上一帧的时间戳，估计帧间隔用（解码线程内使用）
+    double m_frameIntervalUs;      // 平滑后的帧间隔，0表示未知（解码线程内使用）
+    QAtomicInt m_frameRateMilli;   // 帧率×1000，任意线程读取
     
     // FFmpeg 相关
     AVFormatContext* m_formatContext;
     AVCodecContext* m_codecContext;
     SwsContext* m_swsContext;
+    TileScaler m_tileScaler;       // 格子画面的转换+缩小（解码线程内使用）
     int m_videoStreamIndex;
     
     // 初始化FFmpeg
     bool initFFmpeg();
     void cleanupFFmpeg();
+    static int interruptCallback(void* opaque);  // 停止时中断阻塞中的网络读取
+    
+    // 暂停：阻塞等待恢复，实时流同时暂停/断开RTSP会话；返回false表示已请求停止
+    bool waitWhilePaused();
+    bool isIdle();                               // 是否应继续等待（暂停或文件已读完，且没有定位和停止请求）
+    void wakeDecoder();                          // 唤醒等待中的解码线程
+    void setState(State state);
     
     // 解码帧
     bool decodeFrame();
     QImage convertFrameToImage(AVFrame* frame);
+    static QImage allocateFrameImage(const QSize& size); // 从帧缓冲池取行宽按32字节对齐的RGB32图像
+    
+    // 文件回放
+    void performSeek(qint64 positionMs);         // 执行定位
+    bool handleFileFrame(AVFrame* frame);        // 处理解码出的文件帧，返回是否输出
+    qint64 framePositionMs(AVFrame* frame) const; // 帧时间（相对文件开头，毫秒）
+    FrameTiming makeFrameTiming(AVFrame* frame, qint64 arrivalUs); // 帧时间戳、采集时刻和序号，同时更新帧率估计
 };
 
 #endif // MULTISTREAMDECODER_H
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "MultiStreamManager.h"
 #include <QDebug>
 #include <QMutexLocker>
+#include "StreamSessionCache.h"
 
 MultiStreamManager::MultiStreamManager(QObject *parent)
     : QObject(parent)
+    , m_framePacing(false)
 {
+    qRegisterMetaType<StreamHandle>("StreamHandle");
 }
 
 MultiStreamManager::~MultiStreamManager()
@@ -12,122 +15,238 @@ MultiStreamManager::~MultiStreamManager()
     removeAllStreams();
 }
 
-int MultiStreamManager::addStream(const QString& url)
+StreamHandle MultiStreamManager::addStream(const QString& url, FrameSink sink)
 {
     QMutexLocker locker(&m_mutex);
     
-    // 创建解码器
-    MultiStreamDecoder* decoder = new MultiStreamDecoder(url);
+    // 从会话缓存获取解码器，同一地址已打开时直接复用，不再重新建立RTSP连接
+    MultiStreamDecoder* decoder = StreamSessionCache::instance()->acquire(url);
+    StreamHandle handle = m_handleManager.createHandle(sessionPointer(decoder));
+    if (handle < 0) {
+        qWarning() << "No free stream handle for:" << url;   // 共享指针已随之释放，会话引用归还缓存
+        return -1;
+    }
+    m_frameBindings[handle].sink = sink;
+    attachDecoder(decoder, handle);
+    
+    qDebug() << "Added stream:" << url << "handle:" << handle;
+    return handle;
+}
+
+bool MultiStreamManager::switchStreamUrl(StreamHandle handle, const QString& url)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    MultiStreamDecoder* oldDecoder = m_handleManager.getResource(handle);
+    if (!oldDecoder) {
+        qWarning() << "Invalid handle:" << handle;
+        return false;
+    }
+    if (oldDecoder->getUrl() == url) {
+        return true;
+    }
+    
+    // 先打开新会话并继承暂停/焦点状态，再交还旧会话；切换期间网格保留最后一帧
+    StreamSessionCache* cache = StreamSessionCache::instance();
+    bool paused = m_pausedHandles.contains(handle);
+    bool focused = m_focusedHandles.contains(handle);
+    MultiStreamDecoder* decoder = cache->acquire(url);
+    if (focused) {
+        cache->setFocused(decoder, true);
+        cache->setFocused(oldDecoder, false);
+    }
+    if (paused) {
+        cache->suspend(decoder);
+        cache->resume(oldDecoder);
+    }
     
-    // 创建句柄
-    int handle = m_handleManager.createHandle(decoder);
+    m_decoderToHandle.remove(oldDecoder, handle);
+    if (!m_decoderToHandle.contains(oldDecoder)) {
+        disconnect(oldDecoder, nullptr, this, nullptr);
+    }
+    m_handleManager.replaceResource(handle, sessionPointer(decoder));
+    attachDecoder(decoder, handle);
     
+    qDebug() << "Switched stream handle:" << handle << "to:" << url;
+    return true;
+}
+
+QSharedPointer<MultiStreamDecoder> MultiStreamManager::sessionPointer(MultiStreamDecoder* decoder)
+{
+    // 句柄释放时把引用交还给会话缓存
+    return QSharedPointer<MultiStreamDecoder>(decoder, [](MultiStreamDecoder* d) {
+        StreamSessionCache::instance()->release(d);
+    });
+}
+
+void MultiStreamManager::attachDecoder(MultiStreamDecoder* decoder, StreamHandle handle)
+{
     // 建立反向映射
-    m_decoderToHandle[decoder] = handle;
+    m_decoderToHandle.insert(decoder, handle);
     
-    // 连接信号
-    connect(decoder, &MultiStreamDecoder::frameReady,
-            this, &MultiStreamManager::onFrameReady);
+    // 帧信号按句柄连接，其余信号同一解码器只连接一次，由槽函数分发到所有句柄
+    connectFrameSink(decoder, handle);
     connect(decoder, &MultiStreamDecoder::connectionStatusChanged,
-            this, &MultiStreamManager::onConnectionStatusChanged);
+            this, &MultiStreamManager::onConnectionStatusChanged, Qt::UniqueConnection);
     connect(decoder, &MultiStreamDecoder::errorOccurred,
-            this, &MultiStreamManager::onErrorOccurred);
+            this, &MultiStreamManager::onErrorOccurred, Qt::UniqueConnection);
     
-    // 启动解码器
-    decoder->start();
+    // 复用已连接的会话时不会再收到连接信号，补发一次（排队发送，保证调用方已记录句柄）
+    if (decoder->isConnected()) {
+        QString url = decoder->getUrl();
+        QMetaObject::invokeMethod(this, [this, handle, url]() {
+            emit streamConnected(handle, url);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void MultiStreamManager::connectFrameSink(MultiStreamDecoder* decoder, StreamHandle handle)
+{
+    FrameBinding& binding = m_frameBindings[handle];
+    disconnect(binding.connection);
     
-    qDebug() << "Added stream:" << url << "handle:" << handle;
-    return handle;
+    // 解码线程发出的帧排队到界面线程，连接本身带着句柄，不需要再查是哪一路
+    FrameSink sink = binding.sink;
+    if (!sink) {
+        sink = [this](StreamHandle h, const QImage& frame, const FrameTiming& timing) {
+            emit frameReady(h, frame, timing);
+        };
+    }
+    if (!binding.pacer && m_framePacing) {
+        binding.pacer.reset(new FramePacer());
+    }
+    if (binding.pacer) {
+        // 切换地址时保留缓冲，时间戳跳变会让它自动重新估计
+        QSharedPointer<FramePacer> pacer = binding.pacer;
+        pacer->setOutput([handle, sink](const QImage& frame, const FrameTiming& timing) {
+            sink(handle, frame, timing);
+        });
+        binding.connection = connect(decoder, &MultiStreamDecoder::frameReady, this,
+                                     [pacer](const QImage& frame, const FrameTiming& timing) {
+            pacer->push(frame, timing);
+        });
+    } else {
+        binding.connection = connect(decoder, &MultiStreamDecoder::frameReady, this,
+                                     [handle, sink](const QImage& frame, const FrameTiming& timing) {
+            sink(handle, frame, timing);
+        });
+    }
 }
 
-void MultiStreamManager::removeStream(int handle)
+void MultiStreamManager::setFrameSink(StreamHandle handle, FrameSink sink)
 {
     QMutexLocker locker(&m_mutex);
     
     MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
     if (!decoder) {
-        qWarning() << "Invalid handle:" << handle;
         return;
     }
-    
-    QString url = decoder->getUrl();
-    
-    // 停止解码器
-    decoder->stopDecoding();
-    
-    // 断开信号连接
-    disconnect(decoder, nullptr, this, nullptr);
-    
-    // 移除反向映射
-    m_decoderToHandle.remove(decoder);
-    
-    // 释放句柄
-    m_handleManager.releaseHandle(handle);
-    
-    qDebug() << "Removed stream:" << url << "handle:" << handle;
+    m_frameBindings[handle].sink = sink;
+    connectFrameSink(decoder, handle);
 }
 
-void MultiStreamManager::removeAllStreams()
+void MultiStreamManager::setFramePacing(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_framePacing = enabled;
+}
+
+void MultiStreamManager::removeStream(StreamHandle handle)
+{
+    removeStreams(QList<StreamHandle>() << handle);
+}
+
+void MultiStreamManager::removeStreams(const QList<StreamHandle>& handles)
 {
     QMutexLocker locker(&m_mutex);
     
-    QList<int> handles = m_handleManager.getAllHandles();
-    for (int handle : handles) {
+    for (StreamHandle handle : handles) {
         MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
-        if (decoder) {
-            decoder->stopDecoding();
+        if (!decoder) {
+            qWarning() << "Invalid handle:" << handle;
+            continue;
+        }
+        
+        // 断开该句柄的帧输出，移除反向映射，解码器没有其他句柄使用时断开信号
+        disconnect(m_frameBindings.take(handle).connection);
+        m_decoderToHandle.remove(decoder, handle);
+        if (!m_decoderToHandle.contains(decoder)) {
             disconnect(decoder, nullptr, this, nullptr);
         }
+        if (m_pausedHandles.remove(handle)) {
+            StreamSessionCache::instance()->resume(decoder); // 释放前恢复计数，避免影响其他使用者
+        }
+        if (m_focusedHandles.remove(handle)) {
+            StreamSessionCache::instance()->setFocused(decoder, false);
+        }
+        
+        // 释放句柄，会话缓存在引用归零后延迟关闭连接，这里不等待解码线程
         m_handleManager.releaseHandle(handle);
+        qDebug() << "Removed stream handle:" << handle;
     }
-    
-    m_decoderToHandle.clear();
+}
+
+void MultiStreamManager::removeAllStreams()
+{
+    removeStreams(m_handleManager.getAllHandles());
     qDebug() << "Removed all streams";
 }
 
-void MultiStreamManager::pauseStream(int handle)
+void MultiStreamManager::pauseStream(StreamHandle handle)
 {
+    QMutexLocker locker(&m_mutex);
+    
+    // 共享会话只有在所有使用者都暂停后才真正暂停
     MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
-    if (decoder) {
-        decoder->pauseDecoding();
+    if (decoder && !m_pausedHandles.contains(handle)) {
+        m_pausedHandles.insert(handle);
+        StreamSessionCache::instance()->suspend(decoder);
     }
 }
 
-void MultiStreamManager::resumeStream(int handle)
+void MultiStreamManager::resumeStream(StreamHandle handle)
 {
+    QMutexLocker locker(&m_mutex);
+    
     MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
-    if (decoder) {
-        decoder->resumeDecoding();
+    if (decoder && m_pausedHandles.remove(handle)) {
+        StreamSessionCache::instance()->resume(decoder);
     }
 }
 
 void MultiStreamManager::pauseAllStreams()
 {
-    QMutexLocker locker(&m_mutex);
-    
-    QList<int> handles = m_handleManager.getAllHandles();
-    for (int handle : handles) {
-        MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
-        if (decoder) {
-            decoder->pauseDecoding();
-        }
+    const QList<StreamHandle> handles = m_handleManager.getAllHandles();
+    for (StreamHandle handle : handles) {
+        pauseStream(handle);
     }
 }
 
 void MultiStreamManager::resumeAllStreams()
+{
+    const QList<StreamHandle> handles = m_handleManager.getAllHandles();
+    for (StreamHandle handle : handles) {
+        resumeStream(handle);
+    }
+}
+
+void MultiStreamManager::setStreamFocused(StreamHandle handle, bool focused)
 {
     QMutexLocker locker(&m_mutex);
     
-    QList<int> handles = m_handleManager.getAllHandles();
-    for (int handle : handles) {
-        MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
-        if (decoder) {
-            decoder->resumeDecoding();
-        }
+    MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
+    if (!decoder) {
+        return;
+    }
+    if (focused && !m_focusedHandles.contains(handle)) {
+        m_focusedHandles.insert(handle);
+        StreamSessionCache::instance()->setFocused(decoder, true);
+    } else if (!focused && m_focusedHandles.remove(handle)) {
+        StreamSessionCache::instance()->setFocused(decoder, false);
     }
 }
 
-QImage MultiStreamManager::getCurrentFrame(int handle)
+QImage MultiStreamManager::getCurrentFrame(StreamHandle handle)
 {
     MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
     if (decoder) {
@@ -136,7 +255,13 @@ QImage MultiStreamManager::getCurrentFrame(int handle)
     return QImage();
 }
 
-QString MultiStreamManager::getStreamUrl(int handle)
+FrameTiming MultiStreamManager::getCurrentFrameTiming(StreamHandle handle)
+{
+    MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
+    return decoder ? decoder->getCurrentFrameTiming() : FrameTiming();
+}
+
+QString MultiStreamManager::getStreamUrl(StreamHandle handle)
 {
     MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
     if (decoder) {
@@ -145,7 +270,7 @@ QString MultiStreamManager::getStreamUrl(int handle)
     return QString();
 }
 
-bool MultiStreamManager::isStreamConnected(int handle)
+bool MultiStreamManager::isStreamConnected(StreamHandle handle)
 {
     MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
     if (decoder) {
@@ -154,31 +279,26 @@ bool MultiStreamManager::isStreamConnected(int handle)
     return false;
 }
 
-QList<int> MultiStreamManager::getAllStreamHandles()
+QList<StreamHandle> MultiStreamManager::getAllStreamHandles()
 {
     return m_handleManager.getAllHandles();
 }
 
-int MultiStreamManager::getStreamCount() const
+StreamMetrics* MultiStreamManager::getStreamMetrics(StreamHandle handle)
 {
-    return m_handleManager.size();
+    MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
+    return decoder ? decoder->metrics() : nullptr;
 }
 
-void MultiStreamManager::onFrameReady(const QImage& frame)
+double MultiStreamManager::getStreamFrameRate(StreamHandle handle)
 {
-    // 获取发送信号的解码器
-    MultiStreamDecoder* decoder = qobject_cast<MultiStreamDecoder*>(sender());
-    if (!decoder) {
-        return;
-    }
-    
-    // 查找对应的句柄
-    QMutexLocker locker(&m_mutex);
-    auto it = m_decoderToHandle.find(decoder);
-    if (it != m_decoderToHandle.end()) {
-        int handle = it.value();
-        emit frameReady(handle, frame);
-    }
+    MultiStreamDecoder* decoder = m_handleManager.getResource(handle);
+    return decoder ? decoder->frameRate() : 0.0;
+}
+
+int MultiStreamManager::getStreamCount() const
+{
+    return m_handleManager.size();
 }
 
 void MultiStreamManager::onConnectionStatusChanged(bool connected)
@@ -189,11 +309,9 @@ void MultiStreamManager::onConnectionStatusChanged(bool connected)
     }
     
     QMutexLocker locker(&m_mutex);
-    auto it = m_decoderToHandle.find(decoder);
-    if (it != m_decoderToHandle.end()) {
-        int handle = it.value();
-        QString url = decoder->getUrl();
-        
+    const QList<StreamHandle> handles = m_decoderToHandle.values(decoder);
+    QString url = decoder->getUrl();
+    for (StreamHandle handle : handles) {
         if (connected) {
             emit streamConnected(handle, url);
         } else {
@@ -210,9 +328,8 @@ void MultiStreamManager::onErrorOccurred(const QString& error)
     }
     
     QMutexLocker locker(&m_mutex);
-    auto it = m_decoderToHandle.find(decoder);
-    if (it != m_decoderToHandle.end()) {
-        int handle = it.value();
+    const QList<StreamHandle> handles = m_decoderToHandle.values(decoder);
+    for (StreamHandle handle : handles) {
         emit streamError(handle, error);
     }
-}
\ No newline at end of file
+}
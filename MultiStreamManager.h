@@ -7,53 +7,88 @@
 #include <QString>
 #include <QImage>
 #include <QMap>
+#include <QSet>
+#include <QSharedPointer>
+#include <functional>
 
 #include "MultiStreamDecoder.h"
 #include "HandleManager.h"
+#include "FramePacer.h"
 
 /**
  * @brief 多路视频流管理器，负责管理多个RTSP视频流
+ *
+ * 解码器来自StreamSessionCache，同一地址的多个句柄共享一个RTSP会话；
+ * 句柄只是会话的引用，移除句柄不会阻塞等待解码线程退出。
+ *
+ * 每个句柄单独连接解码器的帧信号，帧带着句柄直接交给该句柄的画面接收者（FrameSink），
+ * 帧路径上不查反向映射、不加锁；没有设置接收者的句柄通过frameReady信号输出。
+ * 打开显示节奏控制后，每个句柄的帧先经过抖动缓冲（FramePacer），按帧时间戳均匀地交给接收者。
  */
 class MultiStreamManager : public QObject
 {
     Q_OBJECT
 
 public:
+    using FrameSink = std::function<void(StreamHandle handle, const QImage& frame, const FrameTiming& timing)>; // 在界面线程调用
+
     explicit MultiStreamManager(QObject *parent = nullptr);
     ~MultiStreamManager();
 
     // 流管理接口
-    int addStream(const QString& url);           // 添加视频流，返回句柄
-    void removeStream(int handle);               // 移除视频流
+    StreamHandle addStream(const QString& url, FrameSink sink = FrameSink()); // 添加视频流，返回句柄，失败返回-1
+    void removeStream(StreamHandle handle);      // 移除视频流
+    void removeStreams(const QList<StreamHandle>& handles); // 批量移除视频流
     void removeAllStreams();                     // 移除所有视频流
+    bool switchStreamUrl(StreamHandle handle, const QString& url); // 句柄改用另一个地址（主/子码流切换），句柄不变
 
     // 流控制接口
-    void pauseStream(int handle);                // 暂停指定流
-    void resumeStream(int handle);               // 恢复指定流
+    void pauseStream(StreamHandle handle);       // 暂停指定流
+    void resumeStream(StreamHandle handle);      // 恢复指定流
     void pauseAllStreams();                      // 暂停所有流
     void resumeAllStreams();                     // 恢复所有流
+    void setStreamFocused(StreamHandle handle, bool focused); // 设置焦点（全分辨率、全帧率输出）
+    void setFrameSink(StreamHandle handle, FrameSink sink); // 设置画面接收者，空表示改用frameReady信号
+    void setFramePacing(bool enabled);           // 显示用：帧经过抖动缓冲再输出（对之后添加的视频流生效）
 
     // 获取流信息
-    QImage getCurrentFrame(int handle);          // 获取当前帧
-    QString getStreamUrl(int handle);            // 获取流URL
-    bool isStreamConnected(int handle);          // 检查流连接状态
-    QList<int> getAllStreamHandles();            // 获取所有流句柄
+    QImage getCurrentFrame(StreamHandle handle); // 获取当前帧
+    FrameTiming getCurrentFrameTiming(StreamHandle handle); // 当前帧的时间
+    QString getStreamUrl(StreamHandle handle);   // 获取流URL
+    bool isStreamConnected(StreamHandle handle); // 检查流连接状态
+    QList<StreamHandle> getAllStreamHandles();   // 获取所有流句柄
+    StreamMetrics* getStreamMetrics(StreamHandle handle); // 获取流水线计数（无锁，同一会话的句柄共用）
+    double getStreamFrameRate(StreamHandle handle); // 按帧时间戳估计的帧率，未知时返回0
     int getStreamCount() const;                  // 获取流数量
 
 signals:
-    void frameReady(int handle, const QImage& frame);      // 新帧就绪
-    void streamConnected(int handle, const QString& url);  // 流连接成功
-    void streamDisconnected(int handle, const QString& url); // 流断开连接
-    void streamError(int handle, const QString& error);    // 流错误
+    void frameReady(StreamHandle handle, const QImage& frame, const FrameTiming& timing); // 新帧就绪
+    void streamConnected(StreamHandle handle, const QString& url); // 流连接成功
+    void streamDisconnected(StreamHandle handle, const QString& url); // 流断开连接
+    void streamError(StreamHandle handle, const QString& error); // 流错误
 
 private slots:
-    void onFrameReady(const QImage& frame);
     void onConnectionStatusChanged(bool connected);
     void onErrorOccurred(const QString& error);
 
 private:
+    static QSharedPointer<MultiStreamDecoder> sessionPointer(MultiStreamDecoder* decoder); // 释放时交还会话缓存的共享指针
+    void attachDecoder(MultiStreamDecoder* decoder, StreamHandle handle); // 建立反向映射并连接信号
+    void connectFrameSink(MultiStreamDecoder* decoder, StreamHandle handle); // 把解码器的帧直接接到句柄的接收者
+
+    // 句柄的帧输出：接收者、抖动缓冲和对应的帧信号连接（只在增删句柄时修改）
+    struct FrameBinding {
+        FrameSink sink;
+        QSharedPointer<FramePacer> pacer;        // 未打开显示节奏控制时为空
+        QMetaObject::Connection connection;
+    };
+
     HandleManager<MultiStreamDecoder> m_handleManager;
-    QMap<MultiStreamDecoder*, int> m_decoderToHandle;  // 反向映射，用于信号处理
+    QMultiMap<MultiStreamDecoder*, StreamHandle> m_decoderToHandle;  // 反向映射，用于连接状态和错误信号（共享会话对应多个句柄）
+    QMap<StreamHandle, FrameBinding> m_frameBindings;  // 句柄 -> 帧输出
+    QSet<StreamHandle> m_pausedHandles;                         // 已暂停的句柄
+    QSet<StreamHandle> m_focusedHandles;                        // 需要全分辨率输出的句柄
+    bool m_framePacing;                                         // 新句柄是否经过抖动缓冲
     mutable QMutex m_mutex;
 };
 
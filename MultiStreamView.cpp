@@ -56,10 +56,12 @@ void MultiStreamView::setupUI()
     setupControlPanel();
     setupStreamList();
     setupStatusPanel();
+    setupStatsPanel();
     
     leftLayout->addWidget(m_controlGroup);
     leftLayout->addWidget(m_streamListGroup);
     leftLayout->addWidget(m_statusGroup);
+    leftLayout->addWidget(m_statsGroup);
     leftLayout->addStretch();
     
     // 添加到分割器
@@ -139,6 +141,20 @@ void MultiStreamView::setupStatusPanel()
     statusLayout->addWidget(m_statusText);
 }
 
+void MultiStreamView::setupStatsPanel()
+{
+    m_statsGroup = new QGroupBox("流水线统计");
+    QVBoxLayout* statsLayout = new QVBoxLayout(m_statsGroup);
+    
+    m_statsOverlayCheck = new QCheckBox("在画面上显示统计");
+    statsLayout->addWidget(m_statsOverlayCheck);
+    
+    // 每路一行，最近一秒的帧率、码率和各阶段耗时
+    m_statsTable = new StreamStatsTable();
+    m_statsTable->setMaximumHeight(200);
+    statsLayout->addWidget(m_statsTable);
+}
+
 void MultiStreamView::connectSignals()
 {
     // 控制按钮信号
@@ -173,6 +189,9 @@ void MultiStreamView::connectSignals()
                 this, &MultiStreamView::onStreamError);
         connect(m_streamController, &MultiStreamController::videoSelected,
                 this, &MultiStreamView::onVideoSelected);
+        m_statsTable->setStreamController(m_streamController);
+        connect(m_statsOverlayCheck, &QCheckBox::toggled,
+                m_streamController, &MultiStreamController::setStatsOverlayEnabled);
     }
 }
 
@@ -185,7 +204,7 @@ void MultiStreamView::onAddStreamClicked()
     }
     
     if (m_streamController) {
-        int handle = m_streamController->addStream(url);
+        StreamHandle handle = m_streamController->addStream(url);
         if (handle >= 0) {
             m_urlEdit->clear();
             m_statusText->append(QString("[%1] 正在添加流: %2")
@@ -256,7 +275,7 @@ void MultiStreamView::onBackToSingleClicked()
     }
 }
 
-void MultiStreamView::onStreamAdded(int handle, const QString& url)
+void MultiStreamView::onStreamAdded(StreamHandle handle, const QString& url)
 {
     updateStreamList();
     updateStatusPanel();
@@ -267,7 +286,7 @@ void MultiStreamView::onStreamAdded(int handle, const QString& url)
         .arg(url).arg(handle));
 }
 
-void MultiStreamView::onStreamRemoved(int handle, const QString& url)
+void MultiStreamView::onStreamRemoved(StreamHandle handle, const QString& url)
 {
     updateStreamList();
     updateStatusPanel();
@@ -278,7 +297,7 @@ void MultiStreamView::onStreamRemoved(int handle, const QString& url)
         .arg(url).arg(handle));
 }
 
-void MultiStreamView::onStreamConnected(int handle, const QString& url)
+void MultiStreamView::onStreamConnected(StreamHandle handle, const QString& url)
 {
     updateStreamList();
     m_statusText->append(QString("[%1] 流已连接: %2")
@@ -286,7 +305,7 @@ void MultiStreamView::onStreamConnected(int handle, const QString& url)
         .arg(url));
 }
 
-void MultiStreamView::onStreamDisconnected(int handle, const QString& url)
+void MultiStreamView::onStreamDisconnected(StreamHandle handle, const QString& url)
 {
     updateStreamList();
     m_statusText->append(QString("[%1] 流已断开: %2")
@@ -294,7 +313,7 @@ void MultiStreamView::onStreamDisconnected(int handle, const QString& url)
         .arg(url));
 }
 
-void MultiStreamView::onStreamError(int handle, const QString& error)
+void MultiStreamView::onStreamError(StreamHandle handle, const QString& error)
 {
     updateStreamList();
     m_statusText->append(QString("[%1] 流错误 (句柄: %2): %3")
@@ -302,7 +321,7 @@ void MultiStreamView::onStreamError(int handle, const QString& error)
         .arg(handle).arg(error));
 }
 
-void MultiStreamView::onVideoSelected(int globalIndex, int handle)
+void MultiStreamView::onVideoSelected(int globalIndex, StreamHandle handle)
 {
     m_selectedStreamHandle = handle;
     updateStatusPanel();
@@ -310,7 +329,7 @@ void MultiStreamView::onVideoSelected(int globalIndex, int handle)
     // 更新流列表选择
     for (int i = 0; i < m_streamList->count(); ++i) {
         QListWidgetItem* item = m_streamList->item(i);
-        if (item && item->data(Qt::UserRole).toInt() == handle) {
+        if (item && item->data(Qt::UserRole).toLongLong() == handle) {
             m_streamList->setCurrentItem(item);
             break;
         }
@@ -321,7 +340,7 @@ void MultiStreamView::onStreamListItemClicked()
 {
     QListWidgetItem* item = m_streamList->currentItem();
     if (item) {
-        int handle = item->data(Qt::UserRole).toInt();
+        StreamHandle handle = item->data(Qt::UserRole).toLongLong();
         m_selectedStreamHandle = handle;
         updateStatusPanel();
     }
@@ -329,13 +348,14 @@ void MultiStreamView::onStreamListItemClicked()
 
 void MultiStreamView::onStreamListItemDoubleClicked()
 {
-    // 双击切换到该流对应的视频网格位置
+    // 双击选中并放大该流对应的视频画面
     QListWidgetItem* item = m_streamList->currentItem();
     if (item && m_streamController) {
-        int handle = item->data(Qt::UserRole).toInt();
+        StreamHandle handle = item->data(Qt::UserRole).toLongLong();
         auto streamInfo = m_streamController->getStreamInfo(handle);
         if (streamInfo.handle == handle) {
             m_streamController->selectVideo(streamInfo.displayIndex);
+            m_streamController->promoteVideo(streamInfo.displayIndex);
         }
     }
 }
@@ -422,7 +442,7 @@ void MultiStreamView::updateControlButtons()
     m_pauseResumeBtn->setEnabled(streamCount > 0);
 }
 
-QString MultiStreamView::formatStreamStatus(int handle)
+QString MultiStreamView::formatStreamStatus(StreamHandle handle)
 {
     if (!m_streamController) return "未知";
     
@@ -15,10 +15,12 @@
 #include <QSpinBox>
 #include <QTimer>
 #include <QTextEdit>
+#include <QCheckBox>
 
 #include "MultiStreamManager.h"
 #include "MultiStreamController.h"
 #include "VideoGridWidget.h"
+#include "StreamStatsTable.h"
 
 /**
  * @brief 多路视频流视图，整合所有多路推流功能的用户界面
@@ -48,12 +50,12 @@ private slots:
     void onBackToSingleClicked();                   // 返回单路模式
 
     // 流状态处理
-    void onStreamAdded(int handle, const QString& url);
-    void onStreamRemoved(int handle, const QString& url);
-    void onStreamConnected(int handle, const QString& url);
-    void onStreamDisconnected(int handle, const QString& url);
-    void onStreamError(int handle, const QString& error);
-    void onVideoSelected(int globalIndex, int handle);
+    void onStreamAdded(StreamHandle handle, const QString& url);
+    void onStreamRemoved(StreamHandle handle, const QString& url);
+    void onStreamConnected(StreamHandle handle, const QString& url);
+    void onStreamDisconnected(StreamHandle handle, const QString& url);
+    void onStreamError(StreamHandle handle, const QString& error);
+    void onVideoSelected(int globalIndex, StreamHandle handle);
 
     // 流列表操作
     void onStreamListItemClicked();                 // 流列表项点击
@@ -67,11 +69,12 @@ private:
     void setupControlPanel();                       // 设置控制面板
     void setupStreamList();                         // 设置流列表
     void setupStatusPanel();                        // 设置状态面板
+    void setupStatsPanel();                         // 设置统计面板
     void connectSignals();                          // 连接信号
     void updateStreamList();                        // 更新流列表
     void updateStatusPanel();                       // 更新状态面板
     void updateControlButtons();                    // 更新控制按钮状态
-    QString formatStreamStatus(int handle);         // 格式化流状态
+    QString formatStreamStatus(StreamHandle handle); // 格式化流状态
 
     // 核心组件
     MultiStreamManager* m_streamManager;
@@ -103,12 +106,17 @@ private:
     QLabel* m_currentLayoutLabel;
     QLabel* m_currentPageLabel;
     
+    // 统计面板组件
+    QGroupBox* m_statsGroup;
+    QCheckBox* m_statsOverlayCheck;
+    StreamStatsTable* m_statsTable;
+    
     // 定时器
     QTimer* m_updateTimer;
     
     // 状态变量
     bool m_allStreamsPaused;
-    int m_selectedStreamHandle;
+    StreamHandle m_selectedStreamHandle;
 };
 
 #endif // MULTISTREAMVIEW_H
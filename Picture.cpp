@@ -14,16 +14,13 @@
 #include <QComboBox>
 #include <QFileInfo>
 #include <QDateTime>
-#include <QRegularExpression>
 #include <QGridLayout>
 #include <QFile>
-#include <QDesktopServices>
-#include <QUrl>
+#include "VideoPlayerDialog.h"
 #include <QMouseEvent>
-#include <algorithm>
 
 Picture::Picture(QWidget* parent)
-    : QWidget(parent), currentIndex(0)
+    : QWidget(parent), mediaIndex(nullptr), thumbnailCache(nullptr), currentIndex(0)
 {
     this->setWindowTitle("电子相册 - 截图相册");
     this->resize(900, 600);
@@ -52,6 +49,7 @@ Picture::Picture(QWidget* parent)
     sortComboBox = new QComboBox(this);
     infoLabel = new QLabel("0/0", this);
     timeLabel = new QLabel("", this);
+    thumbnailStrip = new QListWidget(this);
     
     // 设置滑动条
     imageSlider->setMinimum(1);
@@ -316,6 +314,27 @@ Picture::Picture(QWidget* parent)
         "}"
     );
     
+    // 设置缩略图条：单行横向排列
+    thumbnailStrip->setViewMode(QListView::IconMode);
+    thumbnailStrip->setFlow(QListView::LeftToRight);
+    thumbnailStrip->setWrapping(false);
+    thumbnailStrip->setMovement(QListView::Static);
+    thumbnailStrip->setUniformItemSizes(true);
+    thumbnailStrip->setIconSize(QSize(96, 72));
+    thumbnailStrip->setFixedHeight(110);
+    thumbnailStrip->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    thumbnailStrip->setStyleSheet(
+        "QListWidget {"
+        "  background-color: #ffffff;"
+        "  border: 2px solid #dee2e6;"
+        "  border-radius: 8px;"
+        "}"
+        "QListWidget::item:selected {"
+        "  background-color: #90caf9;"
+        "  border-radius: 4px;"
+        "}"
+    );
+    
     // 设置按钮大小
     prevBtn->setFixedSize(80, 40);
     nextBtn->setFixedSize(80, 40);
@@ -404,6 +423,7 @@ Picture::Picture(QWidget* parent)
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
     mainLayout->addLayout(topLayout);
     mainLayout->addLayout(middleLayout, 1); // 中间区域占主要空间
+    mainLayout->addWidget(thumbnailStrip);  // 缩略图条
     mainLayout->addLayout(bottomControlLayout); // 底部控制区域
     mainLayout->setContentsMargins(20, 20, 20, 20);
     mainLayout->setSpacing(15);
@@ -422,10 +442,21 @@ Picture::Picture(QWidget* parent)
     connect(jumpBtn, &QPushButton::clicked, this, &Picture::onJumpToImage);
     connect(jumpEdit, &QLineEdit::returnPressed, this, &Picture::onJumpToImage);
     connect(sortComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &Picture::onSortOrderChanged);
+    connect(thumbnailStrip, &QListWidget::itemClicked, this, &Picture::onThumbnailClicked);
 
     // 初始化按钮样式
     updateAlbumButtonStyles();
     
+    // 打开相册媒体索引，目录变化时增量同步
+    mediaIndex = new MediaIndex(this);
+    mediaIndex->open();
+    connect(mediaIndex, &MediaIndex::albumChanged, this, &Picture::onAlbumChanged);
+    
+    // 缩略图与显示图在后台线程解码
+    thumbnailCache = new ThumbnailCache(this);
+    connect(thumbnailCache, &ThumbnailCache::thumbnailReady, this, &Picture::onThumbnailReady);
+    connect(thumbnailCache, &ThumbnailCache::displayImageReady, this, &Picture::onDisplayImageReady);
+    
     // 加载图片
     loadImages();
     updateImage();
@@ -435,7 +466,6 @@ Picture::~Picture() {}
 
 void Picture::loadImages()
 {
-    imageFiles.clear();
     // 确保picture文件夹存在（使用源码路径）
     QString sourcePath = QString(__FILE__).section('/', 0, -2); // 获取源码目录路径
     QString albumPath;
@@ -467,20 +497,17 @@ void Picture::loadImages()
         filters << "*.jpg" << "*.png" << "*.jpeg" << "*.bmp" << "*.mp4" << "*.avi" << "*.mov";
     }
     
-    QFileInfoList fileList = dir.entryInfoList(filters, QDir::Files | QDir::NoSymLinks);
-    for (const QFileInfo& fileInfo : fileList) {
-        imageFiles << fileInfo.absoluteFilePath();
-    }
-    
-    // 对图片进行排序
-    sortImages();
+    // 同步索引：目录未变化时直接使用已有索引，否则只处理新增/删除的文件
+    mediaIndex->setAlbumDirectory(currentAlbumMode, albumPath, filters);
+    totalCount = mediaIndex->count(currentAlbumMode);
     
+    invalidatePage();
     currentIndex = 0;
 }
 
 void Picture::updateImage()
 {
-    if (imageFiles.isEmpty()) {
+    if (totalCount == 0) {
         imageLabel->setText("没有图片");
         prevBtn->setEnabled(false);
         nextBtn->setEnabled(false);
@@ -492,48 +519,56 @@ void Picture::updateImage()
         imageSlider->setMaximum(1);
         imageSlider->setValue(1);
         imageSlider->setEnabled(false);
+        thumbnailStrip->clear();
         return;
     }
     
-    QString currentFile = imageFiles[currentIndex];
+    MediaEntry entry = entryAt(currentIndex);
+    QString currentFile = entry.path;
     QFileInfo fileInfo(currentFile);
-    QString suffix = fileInfo.suffix().toLower();
-    
-    // 检查是否为视频文件
-    if (suffix == "mp4" || suffix == "avi" || suffix == "mov") {
-        // 对于视频文件，显示视频图标和文件信息
-        imageLabel->clear();
-        imageLabel->setText(QString("🎬 视频文件\n\n文件名: %1\n大小: %2\n\n双击可用系统默认播放器打开")
-                          .arg(fileInfo.fileName())
-                          .arg(formatFileSize(fileInfo.size())));
-        imageLabel->setStyleSheet(imageLabel->styleSheet() + 
-            "QLabel { font-size: 16px; color: #2c3e50; }");
+    
+    // 视频文件显示封面帧，双击在应用内播放
+    if (isVideoFile(currentFile)) {
+        imageLabel->setToolTip(QString("🎬 %1\n大小: %2\n双击播放")
+                               .arg(fileInfo.fileName())
+                               .arg(formatFileSize(entry.size)));
     } else {
-        // 对于图片文件，正常显示
-        QPixmap pix(currentFile);
-        if (pix.isNull()) {
-            imageLabel->setText("图片加载失败");
+        imageLabel->setToolTip(QString());
+    }
+    
+    // 优先使用已按显示尺寸解码的缓存
+    QImage image = thumbnailCache->displayImage(currentFile, displayTargetSize());
+    if (!image.isNull()) {
+        showDisplayImage(image);
+    } else {
+        // 显示图还在后台解码，先用缩略图占位
+        QImage thumb = thumbnailCache->thumbnail(currentFile);
+        if (!thumb.isNull()) {
+            showDisplayImage(thumb);
         } else {
-            QSize targetSize = imageLabel->size() * scaleFactor;
-            imageLabel->setPixmap(pix.scaled(targetSize, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
+            imageLabel->setText(isVideoFile(currentFile) ? "🎬 正在提取视频封面..." : "加载中...");
         }
     }
     
+    // 预取前后图片并刷新缩略图条
+    prefetchNeighbours();
+    updateThumbnailStrip();
+    
     // 更新按钮状态
     prevBtn->setEnabled(currentIndex > 0);
-    nextBtn->setEnabled(currentIndex < imageFiles.size() - 1);
+    nextBtn->setEnabled(currentIndex < totalCount - 1);
     
     // 更新图片信息显示
     updateImageInfo();
     
     // 更新滑动条
     imageSlider->setMinimum(1);
-    imageSlider->setMaximum(imageFiles.size());
+    imageSlider->setMaximum(totalCount);
     imageSlider->setValue(currentIndex + 1);
-    imageSlider->setEnabled(imageFiles.size() > 1);
+    imageSlider->setEnabled(totalCount > 1);
     
-    // 更新时间标签
-    QString timeStr = extractTimeFromFilename(imageFiles[currentIndex]);
+    // 更新时间标签（时间在入库时已从文件名解析）
+    QString timeStr = QDateTime::fromMSecsSinceEpoch(entry.timestamp).toString("yyyy-MM-dd hh:mm:ss");
     timeLabel->setText(timeStr);
 }
 
@@ -547,7 +582,7 @@ void Picture::onPrevClicked()
 
 void Picture::onNextClicked()
 {
-    if (currentIndex < imageFiles.size() - 1) {
+    if (currentIndex < totalCount - 1) {
         ++currentIndex;
         updateImage();
     }
@@ -614,7 +649,7 @@ void Picture::onVideoAlbumClicked()
 
 void Picture::wheelEvent(QWheelEvent* event)
 {
-    if (imageFiles.isEmpty()) return;
+    if (totalCount == 0) return;
     if (event->angleDelta().y() > 0) {
         // 向上滚动，放大
         if (scaleFactor < 3.0) {
@@ -633,15 +668,15 @@ void Picture::wheelEvent(QWheelEvent* event)
 
 void Picture::mouseDoubleClickEvent(QMouseEvent* event)
 {
-    if (imageFiles.isEmpty()) return;
+    if (totalCount == 0) return;
     
-    QString currentFile = imageFiles[currentIndex];
-    QFileInfo fileInfo(currentFile);
-    QString suffix = fileInfo.suffix().toLower();
+    QString currentFile = entryAt(currentIndex).path;
     
-    // 如果是视频文件，用系统默认播放器打开
-    if (suffix == "mp4" || suffix == "avi" || suffix == "mov") {
-        QDesktopServices::openUrl(QUrl::fromLocalFile(currentFile));
+    // 如果是视频文件，在应用内播放窗口中打开
+    if (isVideoFile(currentFile)) {
+        VideoPlayerDialog* player = new VideoPlayerDialog(currentFile, this);
+        player->setAttribute(Qt::WA_DeleteOnClose); // 关闭时自动释放
+        player->show();
     }
     
     QWidget::mouseDoubleClickEvent(event);
@@ -651,11 +686,11 @@ void Picture::mouseDoubleClickEvent(QMouseEvent* event)
 
 void Picture::onSliderValueChanged(int value)
 {
-    if (imageFiles.isEmpty()) return;
+    if (totalCount == 0) return;
     
     // 滑动条值是1开始的，转换为0开始的索引
     int newIndex = value - 1;
-    if (newIndex >= 0 && newIndex < imageFiles.size() && newIndex != currentIndex) {
+    if (newIndex >= 0 && newIndex < totalCount && newIndex != currentIndex) {
         currentIndex = newIndex;
         updateImage();
     }
@@ -663,28 +698,28 @@ void Picture::onSliderValueChanged(int value)
 
 void Picture::onJumpToImage()
 {
-    if (imageFiles.isEmpty()) return;
+    if (totalCount == 0) return;
     
     QString text = jumpEdit->text().trimmed();
     bool ok;
     int targetIndex = text.toInt(&ok);
     
-    if (ok && targetIndex >= 1 && targetIndex <= imageFiles.size()) {
+    if (ok && targetIndex >= 1 && targetIndex <= totalCount) {
         currentIndex = targetIndex - 1; // 转换为0开始的索引
         updateImage();
         jumpEdit->clear(); // 清空输入框
     } else {
         QMessageBox::warning(this, "错误", 
-            QString("请输入有效的序号 (1-%1)").arg(imageFiles.size()));
+            QString("请输入有效的序号 (1-%1)").arg(totalCount));
         jumpEdit->clear();
     }
 }
 
 void Picture::onDeleteImage()
 {
-    if (imageFiles.isEmpty()) return;
+    if (totalCount == 0) return;
     
-    QString currentFile = imageFiles[currentIndex];
+    QString currentFile = entryAt(currentIndex).path;
     QString fileName = QFileInfo(currentFile).fileName();
     
     int ret = QMessageBox::question(this, "确认删除", 
@@ -694,14 +729,17 @@ void Picture::onDeleteImage()
     if (ret == QMessageBox::Yes) {
         // 删除文件
         if (QFile::remove(currentFile)) {
-            // 从列表中移除
-            imageFiles.removeAt(currentIndex);
+            // 从索引中移除
+            mediaIndex->removeEntry(currentFile);
+            thumbnailCache->removeFile(currentFile);
+            --totalCount;
+            invalidatePage();
             
             // 调整当前索引
-            if (imageFiles.isEmpty()) {
+            if (totalCount == 0) {
                 currentIndex = 0;
-            } else if (currentIndex >= imageFiles.size()) {
-                currentIndex = imageFiles.size() - 1;
+            } else if (currentIndex >= totalCount) {
+                currentIndex = totalCount - 1;
             }
             
             // 重新更新显示
@@ -717,8 +755,8 @@ void Picture::onSortOrderChanged()
     // 获取排序方式
     isAscendingOrder = (sortComboBox->currentIndex() == 1);
     
-    // 重新排序
-    sortImages();
+    // 排序由索引查询完成，只需丢弃已缓存的分页
+    invalidatePage();
     
     // 重置到第一张图片
     currentIndex = 0;
@@ -727,61 +765,167 @@ void Picture::onSortOrderChanged()
 
 void Picture::updateImageInfo()
 {
-    if (imageFiles.isEmpty()) {
+    if (totalCount == 0) {
         infoLabel->setText("0/0");
     } else {
-        infoLabel->setText(QString("%1/%2").arg(currentIndex + 1).arg(imageFiles.size()));
+        infoLabel->setText(QString("%1/%2").arg(currentIndex + 1).arg(totalCount));
     }
 }
 
-void Picture::sortImages()
+void Picture::invalidatePage()
 {
-    if (imageFiles.isEmpty()) return;
+    pageEntries.clear();
+    pageOffset = -1;
+}
+
+MediaEntry Picture::entryAt(int index)
+{
+    // 不在缓存分页内时，加载以目标序号为中心的一段：预取和缩略图条前后交替访问，
+    // 按页对齐时在页边界附近会反复重新加载，居中后前后半页内都能命中
+    if (pageOffset < 0 || index < pageOffset || index >= pageOffset + pageEntries.size()) {
+        pageOffset = qMax(0, index - kPageSize / 2);
+        pageEntries = mediaIndex->page(currentAlbumMode, isAscendingOrder, pageOffset, kPageSize);
+    }
+
+    int pageIndex = index - pageOffset;
+    if (pageIndex < 0 || pageIndex >= pageEntries.size()) {
+        return MediaEntry();
+    }
+    return pageEntries[pageIndex];
+}
+
+void Picture::onAlbumChanged(int album)
+{
+    if (album != currentAlbumMode) return;
     
-    // 使用自定义排序函数，根据文件名中的时间戳排序
-    std::sort(imageFiles.begin(), imageFiles.end(), [this](const QString& a, const QString& b) {
-        QString timeA = extractTimeFromFilename(a);
-        QString timeB = extractTimeFromFilename(b);
-        
-        if (isAscendingOrder) {
-            return timeA < timeB; // 升序
+    // 相册目录有新增或删除的文件，尽量保持当前查看的文件不变
+    QString currentFile = totalCount > 0 ? entryAt(currentIndex).path : QString();
+    totalCount = mediaIndex->count(currentAlbumMode);
+    invalidatePage();
+    
+    if (totalCount == 0) {
+        currentIndex = 0;
+    } else {
+        if (currentIndex >= totalCount) {
+            currentIndex = totalCount - 1;
+        }
+        if (!currentFile.isEmpty() && entryAt(currentIndex).path != currentFile) {
+            // 新文件按时间插入在前面时，当前文件会整体后移，在附近一页内查找
+            for (int i = currentIndex + 1; i < qMin(totalCount, currentIndex + kPageSize); ++i) {
+                if (entryAt(i).path == currentFile) {
+                    currentIndex = i;
+                    break;
+                }
+            }
+        }
+    }
+    updateImage();
+}
+
+bool Picture::isVideoFile(const QString& path) const
+{
+    return ThumbnailCache::isVideoFile(path);
+}
+
+QSize Picture::displayTargetSize() const
+{
+    return imageLabel->size() * scaleFactor;
+}
+
+void Picture::showDisplayImage(const QImage& image)
+{
+    // 显示图已按目标尺寸解码，这里的缩放只处理缩略图占位和尺寸微差
+    QPixmap pix = QPixmap::fromImage(image);
+    imageLabel->setPixmap(pix.scaled(displayTargetSize(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
+}
+
+void Picture::prefetchNeighbours()
+{
+    QString current = entryAt(currentIndex).path;
+
+    // 由近到远排列，线程池按顺序处理，离当前位置越近越先解码
+    QStringList neighbours;
+    for (int offset = 1; offset <= kPrefetchRadius; ++offset) {
+        int candidates[2] = { currentIndex + offset, currentIndex - offset };
+        for (int index : candidates) {
+            if (index < 0 || index >= totalCount) continue;
+            QString path = entryAt(index).path;
+            if (!path.isEmpty()) {
+                neighbours << path;
+            }
+        }
+    }
+    thumbnailCache->prefetch(current, neighbours, displayTargetSize());
+}
+
+void Picture::updateThumbnailStrip()
+{
+    // 只显示当前图片附近的一段，数量与相册总数无关
+    thumbnailStrip->clear();
+    int first = qMax(0, currentIndex - kStripRadius);
+    int last = qMin(totalCount - 1, currentIndex + kStripRadius);
+
+    for (int i = first; i <= last; ++i) {
+        MediaEntry entry = entryAt(i);
+        QListWidgetItem* item = new QListWidgetItem(thumbnailStrip);
+        item->setData(Qt::UserRole, i);
+        item->setData(Qt::UserRole + 1, entry.path);
+        item->setToolTip(QFileInfo(entry.path).fileName());
+        item->setSizeHint(QSize(104, 80));
+
+        if (isVideoFile(entry.path)) {
+            item->setText("🎬"); // 视频在封面下方加标记
+        }
+        QImage thumb = thumbnailCache->thumbnail(entry.path);
+        if (!thumb.isNull()) {
+            item->setIcon(QIcon(QPixmap::fromImage(thumb)));
         } else {
-            return timeA > timeB; // 降序
+            thumbnailCache->requestThumbnail(entry.path);
         }
-    });
+
+        if (i == currentIndex) {
+            thumbnailStrip->setCurrentItem(item);
+        }
+    }
+
+    if (thumbnailStrip->currentItem()) {
+        thumbnailStrip->scrollToItem(thumbnailStrip->currentItem(), QAbstractItemView::PositionAtCenter);
+    }
 }
 
-QString Picture::extractTimeFromFilename(const QString& filename)
+void Picture::onThumbnailReady(const QString& path, const QImage& image)
 {
-    QFileInfo fileInfo(filename);
-    QString baseName = fileInfo.baseName();
-    
-    // 尝试从文件名中提取时间戳
-    // 假设文件名格式为：screenshot_20240101_123456.jpg 或 alarm_20240101_123456.jpg
-    QRegularExpression timeRegex(R"((\d{8}_\d{6}))");
-    QRegularExpressionMatch match = timeRegex.match(baseName);
-    
-    if (match.hasMatch()) {
-        QString timeStr = match.captured(1);
-        // 转换为更易读的格式：20240101_123456 -> 2024-01-01 12:34:56
-        if (timeStr.length() == 15) { // 8位日期 + 1位下划线 + 6位时间
-            QString date = timeStr.left(8);
-            QString time = timeStr.right(6);
-            QString formattedDate = QString("%1-%2-%3")
-                .arg(date.left(4))     // 年
-                .arg(date.mid(4, 2))   // 月
-                .arg(date.right(2));   // 日
-            QString formattedTime = QString("%1:%2:%3")
-                .arg(time.left(2))     // 时
-                .arg(time.mid(2, 2))   // 分
-                .arg(time.right(2));   // 秒
-            return formattedDate + " " + formattedTime;
+    for (int i = 0; i < thumbnailStrip->count(); ++i) {
+        QListWidgetItem* item = thumbnailStrip->item(i);
+        if (item->data(Qt::UserRole + 1).toString() == path) {
+            item->setIcon(QIcon(QPixmap::fromImage(image)));
         }
     }
+}
+
+void Picture::onDisplayImageReady(const QString& path, const QImage& image)
+{
+    // 预取的其它图片只入缓存，只有当前图片需要刷新显示
+    if (totalCount == 0 || entryAt(currentIndex).path != path) return;
+
+    if (image.isNull()) {
+        imageLabel->setText("图片加载失败");
+    } else {
+        showDisplayImage(image);
+    }
+}
+
+void Picture::onThumbnailClicked(QListWidgetItem* item)
+{
+    int index = item->data(Qt::UserRole).toInt();
     
-    // 如果无法从文件名提取时间，使用文件修改时间
-    QDateTime modifyTime = fileInfo.lastModified();
-    return modifyTime.toString("yyyy-MM-dd hh:mm:ss");
+    // 跳转会重建缩略图条并删除被点击的条目，放到信号处理结束后再执行
+    QMetaObject::invokeMethod(this, [this, index]() {
+        if (index >= 0 && index < totalCount && index != currentIndex) {
+            currentIndex = index;
+            updateImage();
+        }
+    }, Qt::QueuedConnection);
 }
 
 QString Picture::formatFileSize(qint64 size)
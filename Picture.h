@@ -7,6 +7,10 @@
 #include <QSlider>
 #include <QLineEdit>
 #include <QComboBox>
+#include <QVector>
+#include <QListWidget>
+#include "MediaIndex.h"
+#include "ThumbnailCache.h"
 
 class Picture : public QWidget {
     Q_OBJECT
@@ -25,14 +29,23 @@ private slots:
     void onJumpToImage(); // 跳转到指定图片
     void onDeleteImage(); // 删除当前图片
     void onSortOrderChanged(); // 排序方式改变
+    void onAlbumChanged(int album); // 相册目录内容变化
+    void onThumbnailReady(const QString& path, const QImage& image); // 缩略图解码完成
+    void onDisplayImageReady(const QString& path, const QImage& image); // 显示图解码完成
+    void onThumbnailClicked(QListWidgetItem* item); // 点击缩略图跳转
 
 private:
-    void loadImages();    // 加载picture文件夹下所有图片
+    void loadImages();    // 同步当前相册索引并获取文件总数
     void updateImage();   // 更新当前显示图片
     void updateImageInfo(); // 更新图片信息显示
-    void sortImages();    // 对图片按时间排序
+    void invalidatePage(); // 清空分页缓存（排序或相册内容变化时调用）
+    MediaEntry entryAt(int index); // 获取指定序号的文件，未缓存时加载以它为中心的一页
+    bool isVideoFile(const QString& path) const; // 是否为视频文件
+    QSize displayTargetSize() const; // 当前显示尺寸（含缩放比例）
+    void showDisplayImage(const QImage& image); // 显示已解码的图片
+    void prefetchNeighbours(); // 预取当前图片前后若干张
+    void updateThumbnailStrip(); // 更新缩略图条
     void updateAlbumButtonStyles(); // 更新相册按钮样式
-    QString extractTimeFromFilename(const QString& filename); // 从文件名提取时间
     QString formatFileSize(qint64 size); // 格式化文件大小
 
     QLabel* imageLabel;   // 图片显示区域
@@ -49,7 +62,15 @@ private:
     QComboBox* sortComboBox;         // 排序方式下拉框
     QLabel* infoLabel;               // 图片信息标签(总数/序号)
     QLabel* timeLabel;               // 时间信息标签
-    QStringList imageFiles; // 图片文件路径列表
+    QListWidget* thumbnailStrip;     // 缩略图条
+    MediaIndex* mediaIndex;          // 相册媒体索引
+    int totalCount = 0;              // 当前相册文件总数
+    QVector<MediaEntry> pageEntries; // 当前缓存的分页
+    int pageOffset = -1;             // 缓存分页的起始序号（不按页对齐），-1表示无缓存
+    static const int kPageSize = 200; // 每页加载的文件数
+    ThumbnailCache* thumbnailCache;  // 缩略图与显示图缓存
+    static const int kPrefetchRadius = 3; // 预取当前图片前后的数量
+    static const int kStripRadius = 10;   // 缩略图条显示当前图片前后的数量
     int currentIndex;     // 当前图片索引
     double scaleFactor = 1.0; // 当前缩放比例
     
@@ -0,0 +1,488 @@
+#include "PlanStore.h"
+#include <QtSql/QSqlError>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QStandardPaths>
+#include <QDir>
+#include <QUrl>
+#include <QDebug>
+#include <algorithm>
+
+QSet<int> PlanData::effectiveObjectList(const PlanStream& stream) const
+{
+    return stream.objectList.isEmpty() ? objectList : stream.objectList;
+}
+
+QStringList PlanData::conflictingHosts() const
+{
+    QHash<QString, int> firstByHost;    // 设备 -> 第一路视频流的位置
+    QStringList hosts;
+    for (int i = 0; i < streams.size(); ++i) {
+        const PlanStream& stream = streams[i];
+        QString host = QUrl(stream.rtspUrl).host();
+        if (host.isEmpty()) {
+            continue;
+        }
+        if (!firstByHost.contains(host)) {
+            firstByHost.insert(host, i);
+            continue;
+        }
+        const PlanStream& first = streams[firstByHost.value(host)];
+        if ((first.aiEnabled != stream.aiEnabled || first.regionEnabled != stream.regionEnabled
+             || first.objectEnabled != stream.objectEnabled
+             || effectiveObjectList(first) != effectiveObjectList(stream))
+            && !hosts.contains(host)) {
+            hosts.append(host);
+        }
+    }
+    return hosts;
+}
+
+PlanStore::PlanStore(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PlanStore::~PlanStore()
+{
+    // 预编译语句持有连接，必须先释放再关闭数据库
+    m_insertQuery = QSqlQuery();
+    m_updateQuery = QSqlQuery();
+    m_deleteQuery = QSqlQuery();
+    m_insertStreamQuery = QSqlQuery();
+    m_deleteStreamsQuery = QSqlQuery();
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase("PlanDB");
+}
+
+bool PlanStore::open(const QString& dbPath)
+{
+    if (m_database.isOpen()) {
+        return true;
+    }
+
+    // 获取应用程序数据目录 - 在Linux下通常是 ~/.local/share/<AppName>/
+    QString path = dbPath;
+    if (path.isEmpty()) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataDir);
+        path = dataDir + "/plans.db";
+    }
+
+    // 使用命名连接"PlanDB"避免与其他数据库连接冲突
+    m_database = QSqlDatabase::addDatabase("QSQLITE", "PlanDB");
+    m_database.setDatabaseName(path);
+    if (!m_database.open()) {
+        return fail("无法打开数据库", m_database.lastError().text());
+    }
+
+    return createTables() && migrateTables() && prepareStatements() && loadAll();
+}
+
+bool PlanStore::createTables()
+{
+    QSqlQuery query(m_database);
+
+    // 定义创建表的SQL语句 - 使用原始字符串字面量(R"(...)")避免转义字符问题
+    QString createTableSql = R"(
+        CREATE TABLE IF NOT EXISTS plans (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,  -- 主键，自动递增
+            name TEXT NOT NULL UNIQUE,             -- 方案名称，非空且唯一
+            rtsp_url TEXT NOT NULL,                -- RTSP地址，非空
+            ai_enabled INTEGER DEFAULT 0,          -- AI功能开关，0=关闭，1=开启
+            region_enabled INTEGER DEFAULT 0,      -- 区域识别开关，0=关闭，1=开启
+            object_enabled INTEGER DEFAULT 0,      -- 对象识别开关，0=关闭，1=开启
+            object_list TEXT DEFAULT '',           -- 检测对象列表，JSON格式存储
+            grid_layout INTEGER DEFAULT 0,         -- 多路方案网格路数，0=按流数量自动选择
+            created_time DATETIME DEFAULT CURRENT_TIMESTAMP,  -- 创建时间，自动设置
+            updated_time DATETIME DEFAULT CURRENT_TIMESTAMP   -- 更新时间，自动设置
+        )
+    )";
+
+    if (!query.exec(createTableSql)) {
+        return fail("创建表失败", query.lastError().text());
+    }
+
+    // 多路方案的视频流表，position为画面位置
+    QString createStreamTableSql = R"(
+        CREATE TABLE IF NOT EXISTS plan_streams (
+            plan_id INTEGER NOT NULL,              -- 所属方案ID
+            position INTEGER NOT NULL,             -- 画面位置，从0开始
+            rtsp_url TEXT NOT NULL,                -- RTSP地址（子码流）
+            main_url TEXT DEFAULT '',              -- 主码流地址
+            ai_enabled INTEGER DEFAULT 0,          -- AI功能开关
+            region_enabled INTEGER DEFAULT 0,      -- 区域识别开关
+            object_enabled INTEGER DEFAULT 0,      -- 对象识别开关
+            object_list TEXT DEFAULT '',           -- 检测对象列表，JSON格式存储
+            PRIMARY KEY (plan_id, position)
+        )
+    )";
+
+    if (!query.exec(createStreamTableSql)) {
+        return fail("创建表失败", query.lastError().text());
+    }
+    return true;
+}
+
+bool PlanStore::migrateTables()
+{
+    // 旧版本数据库没有网格路数和主码流地址字段
+    return addColumnIfMissing("plans", "grid_layout", "INTEGER DEFAULT 0")
+        && addColumnIfMissing("plan_streams", "main_url", "TEXT DEFAULT ''");
+}
+
+bool PlanStore::addColumnIfMissing(const QString& table, const QString& column, const QString& definition)
+{
+    QSqlQuery query(m_database);
+    if (!query.exec(QString("PRAGMA table_info(%1)").arg(table))) {
+        return fail("读取表结构失败", query.lastError().text());
+    }
+    while (query.next()) {
+        if (query.value(1).toString() == column) {
+            return true;
+        }
+    }
+    if (!query.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, definition))) {
+        return fail("升级表结构失败", query.lastError().text());
+    }
+    return true;
+}
+
+bool PlanStore::prepareStatements()
+{
+    // 语句只编译一次，之后每次写入只需重新绑定参数
+    m_insertQuery = QSqlQuery(m_database);
+    if (!m_insertQuery.prepare(R"(
+            INSERT INTO plans (name, rtsp_url, ai_enabled, region_enabled, object_enabled, object_list, grid_layout)
+            VALUES (?, ?, ?, ?, ?, ?, ?)
+        )")) {
+        return fail("预编译插入语句失败", m_insertQuery.lastError().text());
+    }
+
+    m_updateQuery = QSqlQuery(m_database);
+    if (!m_updateQuery.prepare(R"(
+            UPDATE plans
+            SET name=?, rtsp_url=?, ai_enabled=?, region_enabled=?, object_enabled=?, object_list=?, grid_layout=?, updated_time=CURRENT_TIMESTAMP
+            WHERE id=?
+        )")) {
+        return fail("预编译更新语句失败", m_updateQuery.lastError().text());
+    }
+
+    m_deleteQuery = QSqlQuery(m_database);
+    if (!m_deleteQuery.prepare("DELETE FROM plans WHERE id = ?")) {
+        return fail("预编译删除语句失败", m_deleteQuery.lastError().text());
+    }
+
+    m_insertStreamQuery = QSqlQuery(m_database);
+    if (!m_insertStreamQuery.prepare(R"(
+            INSERT INTO plan_streams (plan_id, position, rtsp_url, main_url, ai_enabled, region_enabled, object_enabled, object_list)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+        )")) {
+        return fail("预编译插入语句失败", m_insertStreamQuery.lastError().text());
+    }
+
+    m_deleteStreamsQuery = QSqlQuery(m_database);
+    if (!m_deleteStreamsQuery.prepare("DELETE FROM plan_streams WHERE plan_id = ?")) {
+        return fail("预编译删除语句失败", m_deleteStreamsQuery.lastError().text());
+    }
+    return true;
+}
+
+bool PlanStore::loadAll()
+{
+    m_plansById.clear();
+    m_idByName.clear();
+    m_orderedIds.clear();
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, name, rtsp_url, ai_enabled, region_enabled, object_enabled, object_list, grid_layout FROM plans ORDER BY id")) {
+        return fail("加载方案失败", query.lastError().text());
+    }
+
+    while (query.next()) {
+        PlanData plan;
+        plan.id = query.value(0).toInt();
+        plan.name = query.value(1).toString();
+        plan.rtspUrl = query.value(2).toString();
+        plan.aiEnabled = query.value(3).toBool();
+        plan.regionEnabled = query.value(4).toBool();
+        plan.objectEnabled = query.value(5).toBool();
+        plan.objectList = objectListFromJson(query.value(6).toString()); // 只在加载时解析一次
+        plan.gridLayout = query.value(7).toInt();
+
+        m_plansById.insert(plan.id, plan);
+        m_idByName.insert(plan.name, plan.id);
+        m_orderedIds.append(plan.id);
+    }
+
+    // 一次查询取出全部视频流，按方案分组挂到内存索引上
+    if (!query.exec("SELECT plan_id, rtsp_url, ai_enabled, region_enabled, object_enabled, object_list, main_url FROM plan_streams ORDER BY plan_id, position")) {
+        return fail("加载方案视频流失败", query.lastError().text());
+    }
+    while (query.next()) {
+        auto it = m_plansById.find(query.value(0).toInt());
+        if (it == m_plansById.end()) {
+            continue; // 方案已删除的残留记录
+        }
+        PlanStream stream;
+        stream.rtspUrl = query.value(1).toString();
+        stream.aiEnabled = query.value(2).toBool();
+        stream.regionEnabled = query.value(3).toBool();
+        stream.objectEnabled = query.value(4).toBool();
+        stream.objectList = objectListFromJson(query.value(5).toString());
+        stream.mainUrl = query.value(6).toString();
+        it.value().streams.append(stream);
+    }
+    return true;
+}
+
+QList<PlanData> PlanStore::plans() const
+{
+    QList<PlanData> result;
+    result.reserve(m_orderedIds.size());
+    for (int id : m_orderedIds) {
+        result.append(m_plansById.value(id));
+    }
+    return result;
+}
+
+PlanData PlanStore::planById(int planId) const
+{
+    return m_plansById.value(planId);
+}
+
+PlanData PlanStore::planByName(const QString& name) const
+{
+    auto it = m_idByName.constFind(name);
+    if (it == m_idByName.constEnd()) {
+        return PlanData();
+    }
+    return m_plansById.value(it.value());
+}
+
+bool PlanStore::savePlan(PlanData& plan)
+{
+    QList<PlanData> plans;
+    plans.append(plan);
+    if (!savePlans(plans)) {
+        return false;
+    }
+    plan = plans.first();
+    return true;
+}
+
+bool PlanStore::savePlans(QList<PlanData>& plans)
+{
+    if (plans.isEmpty()) {
+        return true;
+    }
+    if (!m_database.transaction()) {
+        return fail("开启事务失败", m_database.lastError().text());
+    }
+
+    // 先全部写入数据库，提交成功后再更新内存索引，失败时内存保持原状
+    QList<PlanData> written = plans;
+    for (PlanData& plan : written) {
+        if (!writePlan(plan)) {
+            m_database.rollback();
+            return false;
+        }
+    }
+    if (!m_database.commit()) {
+        QString error = m_database.lastError().text();
+        m_database.rollback();
+        return fail("提交事务失败", error);
+    }
+
+    for (int i = 0; i < written.size(); ++i) {
+        cachePlan(written[i]);
+        plans[i] = written[i];                      // 回填ID及补全的字段
+    }
+    emit plansChanged();
+    return true;
+}
+
+bool PlanStore::removePlan(int planId)
+{
+    return removePlans(QList<int>() << planId);
+}
+
+bool PlanStore::removePlans(const QList<int>& planIds)
+{
+    if (planIds.isEmpty()) {
+        return true;
+    }
+    if (!m_database.transaction()) {
+        return fail("开启事务失败", m_database.lastError().text());
+    }
+
+    for (int planId : planIds) {
+        if (!deletePlan(planId)) {
+            m_database.rollback();
+            return false;
+        }
+    }
+    if (!m_database.commit()) {
+        QString error = m_database.lastError().text();
+        m_database.rollback();
+        return fail("提交事务失败", error);
+    }
+
+    for (int planId : planIds) {
+        uncachePlan(planId);
+    }
+    emit plansChanged();
+    return true;
+}
+
+bool PlanStore::writePlan(PlanData& plan)
+{
+    // 根据方案ID判断是新增还是更新，同一名称的旧方案在内存索引中可直接判重
+    int existingId = m_idByName.value(plan.name, -1);
+    if (existingId != -1 && existingId != plan.id) {
+        return fail("保存方案失败", QString("方案名称\"%1\"已存在").arg(plan.name));
+    }
+
+    // 多路方案的主RTSP地址取第一路，保证rtsp_url字段非空且旧版本可读
+    if (plan.isMultiStream() && plan.rtspUrl.isEmpty()) {
+        plan.rtspUrl = plan.streams.first().rtspUrl;
+    }
+
+    QSqlQuery& query = (plan.id == -1) ? m_insertQuery : m_updateQuery;
+    query.addBindValue(plan.name);                              // 方案名称
+    query.addBindValue(plan.rtspUrl);                           // RTSP地址
+    query.addBindValue(plan.aiEnabled ? 1 : 0);                 // AI开关（布尔转整数）
+    query.addBindValue(plan.regionEnabled ? 1 : 0);             // 区域识别开关（布尔转整数）
+    query.addBindValue(plan.objectEnabled ? 1 : 0);             // 对象识别开关（布尔转整数）
+    query.addBindValue(objectListToJson(plan.objectList));      // 对象列表（转换为JSON字符串）
+    query.addBindValue(plan.gridLayout);                        // 网格路数
+    if (plan.id != -1) {
+        query.addBindValue(plan.id);                            // WHERE条件：方案ID
+    }
+
+    if (!query.exec()) {
+        return fail("保存方案失败", query.lastError().text());
+    }
+    if (plan.id == -1) {
+        plan.id = query.lastInsertId().toInt();                 // 回填数据库生成的ID
+    }
+    query.finish();
+    return writeStreams(plan);
+}
+
+bool PlanStore::writeStreams(const PlanData& plan)
+{
+    // 视频流列表整体替换，位置变化时无需逐条比对
+    m_deleteStreamsQuery.addBindValue(plan.id);
+    if (!m_deleteStreamsQuery.exec()) {
+        return fail("保存方案视频流失败", m_deleteStreamsQuery.lastError().text());
+    }
+    m_deleteStreamsQuery.finish();
+
+    for (int i = 0; i < plan.streams.size(); ++i) {
+        const PlanStream& stream = plan.streams[i];
+        m_insertStreamQuery.addBindValue(plan.id);
+        m_insertStreamQuery.addBindValue(i);
+        m_insertStreamQuery.addBindValue(stream.rtspUrl);
+        m_insertStreamQuery.addBindValue(stream.mainUrl);
+        m_insertStreamQuery.addBindValue(stream.aiEnabled ? 1 : 0);
+        m_insertStreamQuery.addBindValue(stream.regionEnabled ? 1 : 0);
+        m_insertStreamQuery.addBindValue(stream.objectEnabled ? 1 : 0);
+        m_insertStreamQuery.addBindValue(objectListToJson(stream.objectList));
+        if (!m_insertStreamQuery.exec()) {
+            return fail("保存方案视频流失败", m_insertStreamQuery.lastError().text());
+        }
+        m_insertStreamQuery.finish();
+    }
+    return true;
+}
+
+bool PlanStore::deletePlan(int planId)
+{
+    m_deleteQuery.addBindValue(planId);
+    if (!m_deleteQuery.exec()) {
+        return fail("删除方案失败", m_deleteQuery.lastError().text());
+    }
+    m_deleteQuery.finish();
+
+    m_deleteStreamsQuery.addBindValue(planId);
+    if (!m_deleteStreamsQuery.exec()) {
+        return fail("删除方案失败", m_deleteStreamsQuery.lastError().text());
+    }
+    m_deleteStreamsQuery.finish();
+    return true;
+}
+
+void PlanStore::cachePlan(const PlanData& plan)
+{
+    // 更新时如果改了名称，先移除旧名称的索引
+    auto it = m_plansById.constFind(plan.id);
+    if (it != m_plansById.constEnd()) {
+        m_idByName.remove(it.value().name);
+    } else {
+        // 自增ID通常大于已有ID，直接追加；否则按序插入
+        if (m_orderedIds.isEmpty() || m_orderedIds.last() < plan.id) {
+            m_orderedIds.append(plan.id);
+        } else {
+            m_orderedIds.insert(std::lower_bound(m_orderedIds.begin(), m_orderedIds.end(), plan.id), plan.id);
+        }
+    }
+    m_plansById.insert(plan.id, plan);
+    m_idByName.insert(plan.name, plan.id);
+}
+
+void PlanStore::uncachePlan(int planId)
+{
+    auto it = m_plansById.find(planId);
+    if (it == m_plansById.end()) {
+        return;
+    }
+    m_idByName.remove(it.value().name);
+    m_plansById.erase(it);
+
+    auto pos = std::lower_bound(m_orderedIds.begin(), m_orderedIds.end(), planId);
+    if (pos != m_orderedIds.end() && *pos == planId) {
+        m_orderedIds.erase(pos);
+    }
+}
+
+bool PlanStore::fail(const QString& message, const QString& error)
+{
+    m_lastError = QString("%1：%2").arg(message).arg(error);
+    qWarning() << m_lastError;
+    return false;
+}
+
+QString PlanStore::objectListToJson(const QSet<int>& objectList)
+{
+    // 将QSet<int>类型的对象ID集合转换为JSON字符串格式，以TEXT字段存储
+    QJsonArray jsonArray;
+    for (int id : objectList) {
+        jsonArray.append(id);
+    }
+    QJsonDocument doc(jsonArray);
+    return doc.toJson(QJsonDocument::Compact);
+}
+
+QSet<int> PlanStore::objectListFromJson(const QString& jsonString)
+{
+    // 将JSON字符串格式的对象列表转换回QSet<int>类型
+    QSet<int> objectList;
+    if (jsonString.isEmpty()) {
+        return objectList;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(jsonString.toUtf8());
+    if (doc.isArray()) {
+        for (const QJsonValue& value : doc.array()) {
+            if (value.isDouble()) {
+                objectList.insert(value.toInt());
+            }
+        }
+    }
+    return objectList;
+}
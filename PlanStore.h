@@ -0,0 +1,117 @@
+#ifndef PLANSTORE_H
+#define PLANSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+
+#include "CameraProfile.h"
+
+// 方案中的单路视频流配置（多路方案）
+struct PlanStream {
+    QString rtspUrl;           // RTSP地址（子码流，网格小画面使用）
+    QString mainUrl;           // 主码流地址，为空表示只有一路码流
+    bool aiEnabled;            // AI识别功能使能
+    bool regionEnabled;        // 区域识别功能使能
+    bool objectEnabled;        // 对象识别功能使能
+    QSet<int> objectList;      // 对象列表，为空时沿用方案的对象列表
+
+    PlanStream() : aiEnabled(false), regionEnabled(false), objectEnabled(false) {}
+
+    CameraProfile profile() const { return CameraProfile(rtspUrl, mainUrl); }
+};
+
+// 方案数据结构
+struct PlanData {
+    int id;                    // 方案ID（数据库主键）
+    QString name;              // 方案名称
+    QString rtspUrl;           // RTSP地址
+    bool aiEnabled;            // AI识别功能使能
+    bool regionEnabled;        // 区域识别功能使能
+    bool objectEnabled;        // 对象识别功能使能
+    QSet<int> objectList;      // 对象列表（对象ID集合）
+    QList<PlanStream> streams; // 多路方案的视频流列表，按画面位置排列；为空时为单路方案
+    int gridLayout;            // 多路方案的网格路数（1/4/9/16/25/36），0表示按流数量自动选择
+
+    // 默认构造函数
+    PlanData() : id(-1), aiEnabled(false), regionEnabled(false), objectEnabled(false), gridLayout(0) {}
+
+    bool isMultiStream() const { return !streams.isEmpty(); }
+
+    // 设备配置指令不带通道号，同一设备（RTSP地址的主机）只能有一套AI/区域/对象配置
+    QSet<int> effectiveObjectList(const PlanStream& stream) const;  // 视频流为空时沿用方案的对象列表
+    QStringList conflictingHosts() const;                           // 多路视频流配置不一致的设备
+};
+
+/**
+ * @brief 方案数据仓库（不依赖界面）
+ *
+ * 打开时一次性把plans表读入内存，按ID和名称建立哈希索引，对象列表JSON只在加载时解析一次；
+ * 增删改使用打开时预编译好的语句，批量保存/删除在一个事务中完成，失败整体回滚。
+ * 多路方案的视频流存放在plan_streams表中，与方案在同一事务内整体替换。
+ */
+class PlanStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlanStore(QObject *parent = nullptr);
+    ~PlanStore();
+
+    bool open(const QString& dbPath = QString());   // 打开数据库，默认路径为应用数据目录下的plans.db
+    bool isOpen() const { return m_database.isOpen(); }
+    QString lastError() const { return m_lastError; }
+
+    // 查询接口（只读内存索引，不访问数据库）
+    QList<PlanData> plans() const;                  // 全部方案，按ID升序
+    int count() const { return m_orderedIds.size(); }
+    bool contains(int planId) const { return m_plansById.contains(planId); }
+    PlanData planById(int planId) const;            // 不存在时返回id为-1的方案
+    PlanData planByName(const QString& name) const; // 不存在时返回id为-1的方案
+
+    // 写入接口：新方案（id为-1）插入后回填数据库生成的ID
+    bool savePlan(PlanData& plan);
+    bool savePlans(QList<PlanData>& plans);         // 批量保存，单个事务
+    bool removePlan(int planId);
+    bool removePlans(const QList<int>& planIds);    // 批量删除，单个事务
+
+    // 对象列表序列化转换函数
+    static QString objectListToJson(const QSet<int>& objectList);  // 将对象ID集合转换为JSON字符串格式
+    static QSet<int> objectListFromJson(const QString& jsonString); // 将JSON字符串解析为对象ID集合
+
+signals:
+    void plansChanged();                            // 方案数据发生变化
+
+private:
+    bool createTables();                            // 创建方案数据表
+    bool migrateTables();                           // 旧版本数据库补充新增字段
+    bool addColumnIfMissing(const QString& table, const QString& column, const QString& definition);
+    bool prepareStatements();                       // 预编译增删改语句
+    bool loadAll();                                 // 加载全部方案并建立索引
+    bool writePlan(PlanData& plan);                 // 在当前事务中写入单个方案（不更新内存索引）
+    bool deletePlan(int planId);                    // 在当前事务中删除单个方案（不更新内存索引）
+    bool writeStreams(const PlanData& plan);        // 在当前事务中替换方案的视频流列表
+    void cachePlan(const PlanData& plan);           // 写入内存索引
+    void uncachePlan(int planId);                   // 从内存索引移除
+    bool fail(const QString& message, const QString& error); // 记录错误并返回false
+
+    QSqlDatabase m_database;                // 方案数据库
+    QSqlQuery m_insertQuery;                // 预编译：插入方案
+    QSqlQuery m_updateQuery;                // 预编译：更新方案
+    QSqlQuery m_deleteQuery;                // 预编译：删除方案
+    QSqlQuery m_insertStreamQuery;          // 预编译：插入方案视频流
+    QSqlQuery m_deleteStreamsQuery;         // 预编译：删除方案的全部视频流
+
+    QHash<int, PlanData> m_plansById;       // 按ID索引
+    QHash<QString, int> m_idByName;         // 按名称索引到ID
+    QVector<int> m_orderedIds;              // 按ID升序排列，保持列表顺序稳定
+    QString m_lastError;                    // 最近一次错误信息
+};
+
+#endif // PLANSTORE_H
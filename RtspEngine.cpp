@@ -0,0 +1,266 @@
+#include "RtspEngine.h"
+#include "MultiStreamManager.h"
+#include "TcpCommandServer.h"
+#include "EventStore.h"
+#include "AlarmEngine.h"
+#include "StreamRecorder.h"
+#include "MetricsHttpServer.h"
+#include "FrameMemoryBudget.h"
+#include "StreamSessionCache.h"
+#include <QDir>
+#include <QUrl>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QDebug>
+
+// 录像子目录名：取地址中的主机和路径，去掉不能用作文件名的字符
+static QString channelDirName(const QString& url)
+{
+    QUrl parsed(url);
+    QString name = parsed.host() + parsed.path();
+    if (name.isEmpty()) {
+        name = url;
+    }
+    name.replace(QRegularExpression("[^A-Za-z0-9._-]+"), "_");
+    return name;
+}
+
+// 句柄低32位为槽位索引，同时存在的视频流不会重复
+static int budgetSlot(StreamHandle handle)
+{
+    return static_cast<int>(handle & 0xffffffff);
+}
+
+RtspEngine::RtspEngine(QObject *parent)
+    : QObject(parent)
+    , m_streams(new MultiStreamManager(this))
+    , m_tcp(new TcpCommandServer(this))
+    , m_eventStore(new EventStore(this))
+    , m_alarms(nullptr)
+    , m_metrics(new MetricsHttpServer(this))
+    , m_running(false)
+{
+    connect(m_tcp, &TcpCommandServer::detectionDataReceived, this, &RtspEngine::onDetectionData);
+    connect(m_tcp, &TcpCommandServer::detectionObjectsReceived, this, &RtspEngine::onDetectionObjects);
+    connect(m_tcp, &TcpCommandServer::clientConnected, this, [this](const QString& ip, quint16 port) {
+        emit message("info", QString("设备已连接: %1:%2").arg(ip).arg(port));
+    });
+    connect(m_tcp, &TcpCommandServer::protocolError, this, [this](const QString& error) {
+        emit message("warning", error);
+    });
+    connect(m_eventStore, &EventStore::storeError, this, [this](const QString& error) {
+        emit message("error", error);
+    });
+
+    connect(m_streams, &MultiStreamManager::streamConnected, this, [this](StreamHandle, const QString& url) {
+        emit message("info", "视频流已连接: " + url);
+    });
+    connect(m_streams, &MultiStreamManager::streamDisconnected, this, [this](StreamHandle, const QString& url) {
+        emit message("warning", "视频流已断开: " + url);
+    });
+    connect(m_streams, &MultiStreamManager::streamError, this, [this](StreamHandle, const QString& error) {
+        emit message("error", error);
+    });
+
+    m_metrics->addCollector([this](MetricsText& out) { collectMetrics(out); });
+
+    // 各路最后一帧用于报警图片，只计入内存预算，不回收
+    FrameMemoryBudget::instance()->addOwner(this, "engine");
+}
+
+RtspEngine::~RtspEngine()
+{
+    stop();
+    FrameMemoryBudget::instance()->removeOwner(this);
+}
+
+bool RtspEngine::start(const RtspEngineConfig& config)
+{
+    if (m_running) {
+        return true;
+    }
+    m_config = config;
+
+    QDir dataDir(m_config.dataDir);
+    if (!dataDir.exists() && !dataDir.mkpath(".")) {
+        m_lastError = "无法创建数据目录: " + m_config.dataDir;
+        return false;
+    }
+
+    // 事件数据库打不开时仍然继续运行，只是不保存报警记录
+    if (!m_eventStore->open(dataDir.filePath("events.db"))) {
+        emit message("error", "事件数据库打开失败，报警记录将不会保存");
+    }
+    if (!m_alarms) {
+        m_alarms = new AlarmEngine(dataDir.filePath("alarm-picture"), m_eventStore, this);
+    }
+
+    if (m_config.tcpPort != 0 && !m_tcp->listen(m_config.tcpAddress, m_config.tcpPort)) {
+        m_lastError = QString("设备TCP服务监听失败 %1:%2: %3")
+            .arg(m_config.tcpAddress.toString()).arg(m_config.tcpPort).arg(m_tcp->errorString());
+        m_eventStore->close();
+        return false;
+    }
+
+    if (!m_metrics->start()) {
+        emit message("warning", m_metrics->lastError());
+    }
+
+    m_running = true;
+    for (const QString& url : m_config.urls) {
+        addStream(url);
+    }
+    return true;
+}
+
+void RtspEngine::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+
+    for (auto it = m_channels.begin(); it != m_channels.end(); ++it) {
+        delete it->recorder;    // 析构时结束录像并关闭文件
+        it->recorder = nullptr;
+        FrameMemoryBudget::instance()->untrack(this, budgetSlot(it.key()));
+    }
+    m_channels.clear();
+    m_streams->removeAllStreams();
+    StreamSessionCache::instance()->closeAll();  // 句柄已全部释放，不再保留延迟关闭的会话
+
+    m_metrics->stop();
+    m_tcp->close();
+    m_eventStore->close();      // 写完队列中剩余的事件再关闭
+}
+
+StreamHandle RtspEngine::addStream(const QString& url)
+{
+    StreamHandle handle = m_streams->addStream(url, [this](StreamHandle h, const QImage& frame,
+                                                           const FrameTiming& timing) {
+        onFrame(h, frame, timing);
+    });
+    if (handle < 0) {
+        emit message("error", "视频流数量已达上限，无法接入: " + url);
+        return handle;
+    }
+
+    Channel channel;
+    channel.url = url;
+    channel.frameSlot = FrameMemoryBudget::instance()->slot(this, budgetSlot(handle));
+    if (m_config.record) {
+        channel.recorder = new StreamRecorder();
+        m_streams->setStreamFocused(handle, true);   // 录像需要原始分辨率、全帧率
+    }
+    m_channels.insert(handle, channel);
+    emit message("info", "接入视频流: " + url);
+    return handle;
+}
+
+void RtspEngine::removeStream(StreamHandle handle)
+{
+    auto it = m_channels.find(handle);
+    if (it == m_channels.end()) {
+        return;
+    }
+    delete it->recorder;
+    m_channels.erase(it);
+    FrameMemoryBudget::instance()->untrack(this, budgetSlot(handle));
+    m_streams->removeStream(handle);
+}
+
+void RtspEngine::onFrame(StreamHandle handle, const QImage& frame, const FrameTiming& timing)
+{
+    auto it = m_channels.find(handle);
+    if (it == m_channels.end() || frame.isNull()) {
+        return;
+    }
+    Channel& channel = it.value();
+    channel.lastFrame = frame;
+    channel.lastTiming = timing;
+    channel.frameSlot->track(frame, true);
+
+    if (!channel.recorder) {
+        return;
+    }
+
+    // 按时长分段，避免单个文件无限增长
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (channel.recorder->isRecording() && m_config.recordSegmentMinutes > 0
+        && nowMs - channel.segmentStartMs >= m_config.recordSegmentMinutes * 60000LL) {
+        channel.recorder->stop();
+        emit message("info", "录像已保存: " + channel.recorder->fileName());
+    }
+    if (!channel.recorder->isRecording()) {
+        startRecording(handle, channel, frame.size());
+    }
+    channel.recorder->writeFrame(frame, timing);
+}
+
+void RtspEngine::startRecording(StreamHandle handle, Channel& channel, const QSize& frameSize)
+{
+    QString dir = QDir(m_config.dataDir).filePath("save-video/" + channelDirName(channel.url));
+    QString fileName = StreamRecorder::makeFileName(dir);
+    // 没有指定帧率时按视频流的实际帧率录制，录像时长与实际时间一致
+    double fps = m_config.recordFps > 0 ? m_config.recordFps : m_streams->getStreamFrameRate(handle);
+    if (channel.recorder->start(fileName, frameSize, fps)) {
+        channel.segmentStartMs = QDateTime::currentMSecsSinceEpoch();
+        emit message("info", "开始录像: " + fileName);
+    } else {
+        emit message("error", channel.recorder->lastError() + " " + fileName);
+    }
+}
+
+StreamHandle RtspEngine::channelForHost(const QString& host) const
+{
+    QList<StreamHandle> handles;
+    QStringList urls;
+    for (auto it = m_channels.constBegin(); it != m_channels.constEnd(); ++it) {
+        handles.append(it.key());
+        urls.append(it->url);
+    }
+    int index = AlarmEngine::matchStreamHost(host, urls);
+    return index >= 0 ? handles[index] : -1;
+}
+
+void RtspEngine::onDetectionData(const QString& detectionData)
+{
+    m_lastSummary = detectionData;
+}
+
+void RtspEngine::onDetectionObjects(const QString& sourceHost, const QVector<DetectionObject>& objects)
+{
+    StreamHandle handle = channelForHost(sourceHost);
+    auto it = m_channels.constFind(handle);
+    QString stream = it != m_channels.constEnd() ? it->url : sourceHost;
+
+    m_alarms->recordDetections(stream, objects);
+    emit message("info", QString("检测到目标[%1]: %2").arg(sourceHost, m_lastSummary));
+
+    if (it == m_channels.constEnd()) {
+        emit message("warning", QString("没有与设备%1对应的视频流，报警图片未保存").arg(sourceHost));
+        return;
+    }
+    if (it->lastFrame.isNull()) {
+        emit message("warning", "检测到目标但当前没有可保存的图像！");
+        return;
+    }
+    QString fileName = m_alarms->saveAlarm(it->lastFrame, stream, m_lastSummary, it->lastTiming.captureMs);
+    if (!fileName.isEmpty()) {
+        emit message("alarm", "检测到目标，报警图片已保存: " + fileName);
+    }
+}
+
+void RtspEngine::collectMetrics(MetricsText& out)
+{
+    if (m_alarms) {
+        m_alarms->collectMetrics(out);
+    }
+    m_tcp->collectMetrics(out);
+    for (auto it = m_channels.constBegin(); it != m_channels.constEnd(); ++it) {
+        if (it->recorder) {
+            it->recorder->collectMetrics(out, MetricsText::urlLabel(it->url));
+        }
+    }
+    MetricsHttpServer::collectStorageMetrics(out, m_config.dataDir);
+}
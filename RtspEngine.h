@@ -0,0 +1,103 @@
+#ifndef RTSPENGINE_H
+#define RTSPENGINE_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QStringList>
+#include <QImage>
+#include <QMap>
+#include <QVector>
+#include "common.h"
+#include "HandleManager.h"
+#include "FrameTiming.h"
+#include "FrameMemoryBudget.h"
+
+class MultiStreamManager;
+class TcpCommandServer;
+class EventStore;
+class AlarmEngine;
+class StreamRecorder;
+class MetricsHttpServer;
+class MetricsText;
+
+/**
+ * @brief 无界面服务的启动参数
+ */
+struct RtspEngineConfig {
+    QStringList urls;                       // 接入的视频流
+    QString dataDir;                        // 报警图片、录像和事件数据库的根目录
+    QHostAddress tcpAddress;                // 设备指令TCP服务监听地址
+    quint16 tcpPort;                        // 0表示不启动TCP服务
+    bool record;                            // 是否录制所有视频流
+    double recordFps;                       // 录像帧率，0表示按视频流的实际帧率
+    int recordSegmentMinutes;               // 录像分段时长，0表示不分段
+
+    RtspEngineConfig()
+        : tcpAddress(QHostAddress::Any), tcpPort(8890), record(false)
+        , recordFps(0.0), recordSegmentMinutes(30) {}
+};
+
+/**
+ * @brief 不依赖界面的核心引擎：解码、录像、设备TCP服务、报警和指标
+ *
+ * 在 QCoreApplication 下运行（rtspd 服务进程），录像服务器不需要绘制任何窗口，
+ * 基准测试和自动化测试也可以直接驱动它。所有接口只在创建它的线程中调用。
+ *
+ * 报警来源：设备上报的检测数据按对端IP匹配视频流地址中的主机名，匹配不到时使用第一路视频流。
+ */
+class RtspEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RtspEngine(QObject *parent = nullptr);
+    ~RtspEngine();
+
+    bool start(const RtspEngineConfig& config);     // 打开数据库、启动TCP和指标服务并接入视频流
+    void stop();                                    // 结束录像、断开视频流并关闭服务
+    QString lastError() const { return m_lastError; }
+
+    StreamHandle addStream(const QString& url);     // 运行中追加一路视频流
+    void removeStream(StreamHandle handle);
+
+    MultiStreamManager* streams() const { return m_streams; }
+    TcpCommandServer* tcpServer() const { return m_tcp; }
+    AlarmEngine* alarms() const { return m_alarms; }
+    MetricsHttpServer* metricsServer() const { return m_metrics; }
+
+signals:
+    void message(const QString& type, const QString& text); // 运行消息（info/warning/error/alarm）
+
+private slots:
+    void onDetectionData(const QString& detectionData);
+    void onDetectionObjects(const QString& sourceHost, const QVector<DetectionObject>& objects);
+
+private:
+    // 每路视频流：最近一帧及其时间（报警截图用）和录像
+    struct Channel {
+        QString url;
+        QImage lastFrame;
+        FrameTiming lastTiming;
+        FrameMemoryBudget::Slot* frameSlot = nullptr;   // 最近一帧在内存预算中的位置
+        StreamRecorder* recorder = nullptr;
+        qint64 segmentStartMs = 0;
+    };
+
+    void onFrame(StreamHandle handle, const QImage& frame, const FrameTiming& timing);
+    void startRecording(StreamHandle handle, Channel& channel, const QSize& frameSize);
+    StreamHandle channelForHost(const QString& host) const;   // 与上报设备主机相同的视频流，没有时返回-1
+    void collectMetrics(MetricsText& out);
+
+    RtspEngineConfig m_config;
+    MultiStreamManager* m_streams;
+    TcpCommandServer* m_tcp;
+    EventStore* m_eventStore;
+    AlarmEngine* m_alarms;
+    MetricsHttpServer* m_metrics;
+    QMap<StreamHandle, Channel> m_channels;
+    QString m_lastSummary;       // 最近一次检测数据的摘要（随后的检测明细信号使用）
+    QString m_lastError;
+    bool m_running;
+};
+
+#endif // RTSPENGINE_H
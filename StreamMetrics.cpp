@@ -0,0 +1,167 @@
+#include "StreamMetrics.h"
+#include <chrono>
+
+double LatencyHistogram::Snapshot::percentileMs(double p) const
+{
+    if (count <= 0) {
+        return 0.0;
+    }
+    qint64 target = qMax<qint64>(1, static_cast<qint64>(count * p + 0.5));
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return (qint64(1) << (i + 1)) / 1000.0;
+        }
+    }
+    return (qint64(1) << BucketCount) / 1000.0;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::operator-(const Snapshot& other) const
+{
+    Snapshot delta;
+    for (int i = 0; i < BucketCount; ++i) {
+        delta.counts[i] = counts[i] - other.counts[i];
+    }
+    delta.count = count - other.count;
+    delta.sumUs = sumUs - other.sumUs;
+    return delta;
+}
+
+LatencyHistogram::Snapshot& LatencyHistogram::Snapshot::operator+=(const Snapshot& other)
+{
+    for (int i = 0; i < BucketCount; ++i) {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sumUs += other.sumUs;
+    return *this;
+}
+
+void LatencyHistogram::record(qint64 us)
+{
+    us = qMax<qint64>(1, us);
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && (us >> (bucket + 1)) > 0) {
+        ++bucket;
+    }
+    m_counts[bucket].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_sumUs.fetchAndAddRelaxed(us);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    // 各计数分别读取，采样与记录并发时个别样本可能只计入一部分，不影响统计用途
+    Snapshot snap;
+    for (int i = 0; i < BucketCount; ++i) {
+        snap.counts[i] = static_cast<quint32>(m_counts[i].load());
+    }
+    snap.count = m_count.load();
+    snap.sumUs = m_sumUs.load();
+    return snap;
+}
+
+QString StreamMetrics::Report::overlayText() const
+{
+    return QString("%1/%2 fps  %3 kbps\n解码 %4ms 转换 %5ms 延迟 %6ms  丢 %7")
+        .arg(renderFps, 0, 'f', 1)
+        .arg(receiveFps, 0, 'f', 1)
+        .arg(qRound(bitrateKbps))
+        .arg(decodeMs, 0, 'f', 1)
+        .arg(convertMs, 0, 'f', 1)
+        .arg(latencyP50Ms, 0, 'f', 0)
+        .arg(dropped);
+}
+
+qint64 StreamMetrics::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void StreamMetrics::recordPacket(int bytes, qint64 demuxUs)
+{
+    m_packetsReceived.fetchAndAddRelaxed(1);
+    m_bytesReceived.fetchAndAddRelaxed(bytes);
+    m_demux.record(demuxUs);
+}
+
+void StreamMetrics::recordDecoded(qint64 decodeUs)
+{
+    m_framesDecoded.fetchAndAddRelaxed(1);
+    m_decode.record(decodeUs);
+}
+
+void StreamMetrics::recordConverted(qint64 convertUs)
+{
+    m_convert.record(convertUs);
+}
+
+void StreamMetrics::recordSkipped()
+{
+    m_framesSkipped.fetchAndAddRelaxed(1);
+}
+
+void StreamMetrics::recordDropped()
+{
+    m_framesDropped.fetchAndAddRelaxed(1);
+}
+
+void StreamMetrics::recordRendered(qint64 paintUs, qint64 arrivalUs)
+{
+    m_framesRendered.fetchAndAddRelaxed(1);
+    m_paint.record(paintUs);
+
+    // 按所显示这一帧的到达时间计算，抖动缓冲的等待也计入收包到显示的延迟
+    if (arrivalUs > 0) {
+        m_latency.record(nowUs() - arrivalUs);
+    }
+}
+
+void StreamMetrics::recordReconnect()
+{
+    m_reconnects.fetchAndAddRelaxed(1);
+}
+
+StreamMetrics::Snapshot StreamMetrics::snapshot() const
+{
+    Snapshot snap;
+    snap.timestampUs = nowUs();
+    snap.packetsReceived = m_packetsReceived.load();
+    snap.bytesReceived = m_bytesReceived.load();
+    snap.framesDecoded = m_framesDecoded.load();
+    snap.framesSkipped = m_framesSkipped.load();
+    snap.framesDropped = m_framesDropped.load();
+    snap.framesRendered = m_framesRendered.load();
+    snap.reconnects = m_reconnects.load();
+    snap.demux = m_demux.snapshot();
+    snap.decode = m_decode.snapshot();
+    snap.convert = m_convert.snapshot();
+    snap.paint = m_paint.snapshot();
+    snap.latency = m_latency.snapshot();
+    return snap;
+}
+
+StreamMetrics::Report StreamMetrics::report(const Snapshot& current, const Snapshot& previous)
+{
+    Report r;
+    double seconds = (current.timestampUs - previous.timestampUs) / 1e6;
+    if (seconds <= 0.0) {
+        return r;
+    }
+    r.receiveFps = (current.packetsReceived - previous.packetsReceived) / seconds;
+    r.decodeFps = (current.framesDecoded - previous.framesDecoded) / seconds;
+    r.renderFps = (current.framesRendered - previous.framesRendered) / seconds;
+    r.skippedFps = (current.framesSkipped - previous.framesSkipped) / seconds;
+    r.dropped = current.framesDropped - previous.framesDropped;
+    r.bitrateKbps = (current.bytesReceived - previous.bytesReceived) * 8 / 1000.0 / seconds;
+    r.demuxMs = (current.demux - previous.demux).meanMs();
+    r.decodeMs = (current.decode - previous.decode).meanMs();
+    r.convertMs = (current.convert - previous.convert).meanMs();
+    r.paintMs = (current.paint - previous.paint).meanMs();
+    LatencyHistogram::Snapshot latency = current.latency - previous.latency;
+    r.latencyP50Ms = latency.percentileMs(0.5);
+    r.latencyP95Ms = latency.percentileMs(0.95);
+    return r;
+}
@@ -0,0 +1,110 @@
+#ifndef STREAMMETRICS_H
+#define STREAMMETRICS_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QString>
+
+/**
+ * @brief 耗时直方图：按微秒数的 2 的幂分桶，只做原子累加，任意线程记录都不加锁
+ *
+ * 第 i 个桶统计 [2^i, 2^(i+1)) 微秒的样本，最后一个桶收纳所有更大的值（约1秒以上）。
+ */
+class LatencyHistogram
+{
+public:
+    static const int BucketCount = 21;
+
+    struct Snapshot {
+        quint32 counts[BucketCount] = {};
+        qint64 count = 0;
+        qint64 sumUs = 0;
+
+        double meanMs() const { return count > 0 ? sumUs / 1000.0 / count : 0.0; }
+        double percentileMs(double p) const;    // 按桶上界估算的分位值
+        Snapshot operator-(const Snapshot& other) const; // 两次采样之间的增量
+        Snapshot& operator+=(const Snapshot& other);     // 合并多路的分布
+    };
+
+    void record(qint64 us);
+    Snapshot snapshot() const;
+
+private:
+    QAtomicInt m_counts[BucketCount];
+    QAtomicInteger<qint64> m_count;
+    QAtomicInteger<qint64> m_sumUs;
+};
+
+/**
+ * @brief 单路视频流的流水线计数：解复用、解码、格式转换、显示各阶段的帧数和耗时
+ *
+ * 解码线程记录收包/解码/转换/丢帧，界面线程记录显示（绘制耗时和收包到显示的延迟）。
+ * 所有计数都是累计值，使用者保存上一次的快照，用 report() 求两次采样之间的帧率和耗时。
+ */
+class StreamMetrics
+{
+public:
+    struct Snapshot {
+        qint64 timestampUs = 0;
+        qint64 packetsReceived = 0;             // 收到的视频包
+        qint64 bytesReceived = 0;
+        qint64 framesDecoded = 0;
+        qint64 framesSkipped = 0;               // 网格限帧率主动跳过（不转换、不显示）
+        qint64 framesDropped = 0;               // 转换失败等异常丢弃
+        qint64 framesRendered = 0;
+        qint64 reconnects = 0;                  // 断开后重新连接的次数
+        LatencyHistogram::Snapshot demux;       // 读取一个视频包的耗时（含网络等待）
+        LatencyHistogram::Snapshot decode;
+        LatencyHistogram::Snapshot convert;     // 缩放和像素格式转换
+        LatencyHistogram::Snapshot paint;       // 界面线程写入画面
+        LatencyHistogram::Snapshot latency;     // 收包到显示
+    };
+
+    // 两次采样之间的统计结果
+    struct Report {
+        double receiveFps = 0.0;
+        double decodeFps = 0.0;
+        double renderFps = 0.0;
+        double skippedFps = 0.0;
+        qint64 dropped = 0;
+        double bitrateKbps = 0.0;
+        double demuxMs = 0.0;                   // 各阶段平均耗时
+        double decodeMs = 0.0;
+        double convertMs = 0.0;
+        double paintMs = 0.0;
+        double latencyP50Ms = 0.0;
+        double latencyP95Ms = 0.0;
+
+        QString overlayText() const;            // 画面左上角显示的简短统计
+    };
+
+    static qint64 nowUs();                      // 单调时钟（微秒），各线程共用
+
+    void recordPacket(int bytes, qint64 demuxUs);
+    void recordDecoded(qint64 decodeUs);
+    void recordConverted(qint64 convertUs);
+    void recordSkipped();
+    void recordDropped();
+    void recordRendered(qint64 paintUs, qint64 arrivalUs); // 界面线程调用，arrivalUs为该帧对应包的到达时间
+    void recordReconnect();
+
+    Snapshot snapshot() const;
+    static Report report(const Snapshot& current, const Snapshot& previous);
+
+private:
+    QAtomicInteger<qint64> m_packetsReceived;
+    QAtomicInteger<qint64> m_bytesReceived;
+    QAtomicInteger<qint64> m_framesDecoded;
+    QAtomicInteger<qint64> m_framesSkipped;
+    QAtomicInteger<qint64> m_framesDropped;
+    QAtomicInteger<qint64> m_framesRendered;
+    QAtomicInteger<qint64> m_reconnects;
+    LatencyHistogram m_demux;
+    LatencyHistogram m_decode;
+    LatencyHistogram m_convert;
+    LatencyHistogram m_paint;
+    LatencyHistogram m_latency;
+};
+
+#endif // STREAMMETRICS_H
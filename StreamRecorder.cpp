@@ -0,0 +1,151 @@
+#include "StreamRecorder.h"
+#include "MetricsHttpServer.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+#include <opencv2/opencv.hpp>
+
+namespace {
+
+const double MaxGapSeconds = 2.0;   // 空缺或时间戳回退超过2秒视为跳变（重连、定位），不再补帧
+
+} // namespace
+
+StreamRecorder::StreamRecorder()
+    : m_writer(nullptr)
+    , m_fps(25.0)
+    , m_firstPtsUs(-1)
+    , m_fileFrames(0)
+    , m_framesWritten(0)
+    , m_framesDuplicated(0)
+    , m_framesDropped(0)
+    , m_finishedBytes(0)
+{
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    stop();
+}
+
+bool StreamRecorder::start(const QString& fileName, const QSize& frameSize, double fps)
+{
+    if (m_writer) {
+        m_lastError = "已经在录制中";
+        return false;
+    }
+    if (frameSize.isEmpty()) {
+        m_lastError = "当前没有视频流，无法开始录制！";
+        return false;
+    }
+    if (fps <= 0) {
+        fps = 25.0;
+    }
+
+    m_writer = new cv::VideoWriter(fileName.toStdString(),
+                                   cv::VideoWriter::fourcc('X','2','6','4'),
+                                   fps,
+                                   cv::Size(frameSize.width(), frameSize.height()));
+    if (!m_writer->isOpened()) {
+        delete m_writer;
+        m_writer = nullptr;
+        m_lastError = "无法创建视频文件！";
+        return false;
+    }
+
+    m_fileName = fileName;
+    m_frameSize = frameSize;
+    m_fps = fps;
+    m_firstPtsUs = -1;
+    m_fileFrames = 0;
+    qDebug() << "开始录制视频到:" << m_fileName << "帧率:" << m_fps;
+    return true;
+}
+
+void StreamRecorder::stop()
+{
+    if (!m_writer) {
+        return;
+    }
+    m_writer->release();
+    delete m_writer;
+    m_writer = nullptr;
+    m_lastFrame = QImage();
+    m_finishedBytes += QFileInfo(m_fileName).size();
+    qDebug() << "录制完成，文件保存到:" << m_fileName;
+}
+
+bool StreamRecorder::writeFrame(const QImage& frame, const FrameTiming& timing)
+{
+    if (!m_writer || frame.isNull()) {
+        return false;
+    }
+
+    // VideoWriter要求每帧尺寸与打开时一致
+    QImage image = frame.size() == m_frameSize ? frame : frame.scaled(m_frameSize);
+
+    if (timing.hasPts()) {
+        // 按时间戳计算这一帧在固定帧率文件中的位置
+        const qint64 maxGap = qMax<qint64>(1, qRound64(m_fps * MaxGapSeconds));
+        qint64 slot = m_firstPtsUs >= 0 ? qRound64((timing.ptsUs - m_firstPtsUs) * m_fps / 1e6) : m_fileFrames;
+        if (m_firstPtsUs < 0 || slot > m_fileFrames + maxGap || slot < m_fileFrames - maxGap) {
+            // 第一帧或时间戳跳变：从当前位置接着写
+            m_firstPtsUs = timing.ptsUs - qRound64(m_fileFrames * 1e6 / m_fps);
+            slot = m_fileFrames;
+        }
+        if (slot < m_fileFrames) {
+            ++m_framesDropped;
+            return true;
+        }
+        while (m_fileFrames < slot && !m_lastFrame.isNull()) {
+            writeImage(m_lastFrame);
+            ++m_framesDuplicated;
+        }
+    }
+
+    writeImage(image);
+    m_lastFrame = image;
+    return true;
+}
+
+void StreamRecorder::writeImage(const QImage& frame)
+{
+    // OpenCV按BGR顺序读取像素。解码输出已是RGB32（小端内存顺序为BGRA），直接去掉Alpha通道即可，其他格式先转换
+    QImage rgbImage = frame.convertToFormat(QImage::Format_RGB32);
+    cv::Mat mat(rgbImage.height(), rgbImage.width(), CV_8UC4,
+                const_cast<uchar*>(rgbImage.constBits()), rgbImage.bytesPerLine());
+    cv::Mat bgrMat;
+    cv::cvtColor(mat, bgrMat, cv::COLOR_BGRA2BGR);
+
+    m_writer->write(bgrMat);
+    ++m_framesWritten;
+    ++m_fileFrames;
+}
+
+qint64 StreamRecorder::bytesWritten() const
+{
+    return m_finishedBytes + (m_writer ? QFileInfo(m_fileName).size() : 0);
+}
+
+void StreamRecorder::collectMetrics(MetricsText& out, const QString& labels) const
+{
+    // 吞吐量由监控系统对累计值求速率
+    out.gauge("rtsp_recording_active", "1 while a recording is in progress.", isRecording() ? 1 : 0, labels);
+    out.counter("rtsp_recording_frames_total", "Frames written to recordings.", m_framesWritten, labels);
+    out.counter("rtsp_recording_duplicated_frames_total", "Frames repeated to fill timestamp gaps in recordings.",
+                m_framesDuplicated, labels);
+    out.counter("rtsp_recording_dropped_frames_total", "Frames skipped because their frame slot was already written.",
+                m_framesDropped, labels);
+    out.counter("rtsp_recording_bytes_total", "Bytes written to recordings (current file included).",
+                bytesWritten(), labels);
+}
+
+QString StreamRecorder::makeFileName(const QString& dir)
+{
+    QDir recordDir(dir);
+    if (!recordDir.exists()) {
+        recordDir.mkpath(".");
+    }
+    return recordDir.filePath(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz") + ".mp4");
+}
@@ -0,0 +1,63 @@
+#ifndef STREAMRECORDER_H
+#define STREAMRECORDER_H
+
+#include <QString>
+#include <QSize>
+#include <QImage>
+#include "FrameTiming.h"
+
+namespace cv { class VideoWriter; }
+class MetricsText;
+
+/**
+ * @brief 视频录制器：把解码后的画面写入MP4文件（OpenCV VideoWriter，H.264）
+ *
+ * 不依赖界面，单路界面和无界面服务共用。只在创建它的线程中调用。
+ *
+ * 录像文件是固定帧率：带时间戳的帧按时间戳放到对应的帧位上，网络抖动或丢包造成的空缺重复上一帧补齐，
+ * 同一帧位上多出的帧丢弃，录像时长与实际时间一致。没有时间戳的帧按到达顺序逐帧写入。
+ */
+class StreamRecorder
+{
+public:
+    StreamRecorder();
+    ~StreamRecorder();
+
+    // 开始录制到指定文件，fps为视频流的帧率（未知时传0，按25fps录制）
+    bool start(const QString& fileName, const QSize& frameSize, double fps = 25.0);
+    void stop();                                    // 结束录制并关闭文件
+    // 写入一帧，尺寸不同时缩放到录制尺寸；按 timing 的时间戳补帧或丢帧
+    bool writeFrame(const QImage& frame, const FrameTiming& timing = FrameTiming());
+
+    bool isRecording() const { return m_writer != nullptr; }
+    QString fileName() const { return m_fileName; }
+    QString lastError() const { return m_lastError; }
+    double fps() const { return m_fps; }
+    qint64 framesWritten() const { return m_framesWritten; } // 累计写入帧数（含已结束的录像和补齐的帧）
+    qint64 framesDuplicated() const { return m_framesDuplicated; } // 为补齐空缺重复写入的帧数
+    qint64 framesDropped() const { return m_framesDropped; } // 同一帧位上多出而丢弃的帧数
+    qint64 bytesWritten() const;                    // 累计文件大小（已结束的录像加当前文件）
+    void collectMetrics(MetricsText& out, const QString& labels = QString()) const;
+
+    static QString makeFileName(const QString& dir); // 目录下按时间戳生成文件名，目录不存在时创建
+
+private:
+    Q_DISABLE_COPY(StreamRecorder)
+
+    void writeImage(const QImage& frame);           // 转换为BGR写入一帧
+
+    cv::VideoWriter* m_writer;
+    QString m_fileName;         // 当前录制文件名
+    QSize m_frameSize;
+    double m_fps;
+    qint64 m_firstPtsUs;        // 当前文件第0帧对应的时间戳，-1表示还没有带时间戳的帧
+    qint64 m_fileFrames;        // 当前文件已写入的帧数
+    QImage m_lastFrame;         // 上一帧（已缩放到录制尺寸），补帧用
+    QString m_lastError;
+    qint64 m_framesWritten;
+    qint64 m_framesDuplicated;
+    qint64 m_framesDropped;
+    qint64 m_finishedBytes;     // 已结束录像的文件大小
+};
+
+#endif // STREAMRECORDER_H
@@ -0,0 +1,211 @@
+#include "StreamSessionCache.h"
+#include "DecoderReaper.h"
+#include <QDebug>
+
+StreamSessionCache* StreamSessionCache::instance()
+{
+    // 实例本身从不析构，退出时由界面程序（MainWindow）和无界面服务（RtspEngine::stop）
+    // 在释放全部句柄之后显式调用 closeAll()，不依赖应用对象析构子对象的顺序
+    static StreamSessionCache* cache = new StreamSessionCache();
+    return cache;
+}
+
+StreamSessionCache::StreamSessionCache(QObject *parent)
+    : QObject(parent)
+    , m_lingerMs(10000)
+    , m_tileFps(15)
+{
+}
+
+StreamSessionCache::~StreamSessionCache()
+{
+    closeAll();
+}
+
+QHash<QString, MultiStreamDecoder*> StreamSessionCache::sessions() const
+{
+    QHash<QString, MultiStreamDecoder*> result;
+    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        result.insert(it.key(), it.value().decoder);
+    }
+    return result;
+}
+
+MultiStreamDecoder* StreamSessionCache::acquire(const QString& url)
+{
+    auto it = m_sessions.find(url);
+    if (it != m_sessions.end()) {
+        Session& session = it.value();
+        session.lingerTimer->stop();            // 延迟关闭期间被重新使用
+        if (session.activeCount == 0) {
+            session.decoder->resumeDecoding();
+        }
+        ++session.refCount;
+        ++session.activeCount;
+        qDebug() << "Reuse stream session:" << url << "refs:" << session.refCount;
+        return session.decoder;
+    }
+
+    Session session;
+    session.decoder = new MultiStreamDecoder(url);
+    session.refCount = 1;
+    session.activeCount = 1;
+    applyOutputMode(session);
+    session.lingerTimer = new QTimer(this);
+    session.lingerTimer->setSingleShot(true);
+    connect(session.lingerTimer, &QTimer::timeout, this, [this, url]() {
+        auto it = m_sessions.find(url);
+        if (it != m_sessions.end() && it.value().refCount == 0) {
+            closeSession(url);
+        }
+    });
+    m_sessions.insert(url, session);
+
+    session.decoder->start();
+    qDebug() << "Open stream session:" << url;
+    emit sessionOpened(url);
+    return session.decoder;
+}
+
+void StreamSessionCache::release(MultiStreamDecoder* decoder)
+{
+    QString url;
+    Session* session = findSession(decoder, &url);
+    if (!session || session->refCount == 0) {
+        return;
+    }
+
+    --session->refCount;
+    session->activeCount = qMax(0, session->activeCount - 1);
+    if (session->refCount > 0) {
+        if (session->activeCount == 0) {
+            session->decoder->pauseDecoding();
+        }
+        return;
+    }
+
+    // 无人使用：先暂停，保留一段时间再关闭
+    session->decoder->pauseDecoding();
+    if (m_lingerMs > 0) {
+        session->lingerTimer->start(m_lingerMs);
+    } else {
+        closeSession(url);
+    }
+}
+
+void StreamSessionCache::suspend(MultiStreamDecoder* decoder)
+{
+    Session* session = findSession(decoder);
+    if (!session || session->activeCount == 0) {
+        return;
+    }
+    if (--session->activeCount == 0) {
+        session->decoder->pauseDecoding();
+    }
+}
+
+void StreamSessionCache::resume(MultiStreamDecoder* decoder)
+{
+    Session* session = findSession(decoder);
+    if (!session || session->activeCount >= session->refCount) {
+        return;
+    }
+    if (session->activeCount++ == 0) {
+        session->decoder->resumeDecoding();
+    }
+}
+
+void StreamSessionCache::setFocused(MultiStreamDecoder* decoder, bool focused)
+{
+    Session* session = findSession(decoder);
+    if (!session) {
+        return;
+    }
+    if (focused) {
+        ++session->focusCount;
+    } else if (session->focusCount > 0) {
+        --session->focusCount;
+    }
+    applyOutputMode(*session);
+}
+
+void StreamSessionCache::setTileSize(const QSize& size)
+{
+    if (m_tileSize == size) {
+        return;
+    }
+    m_tileSize = size;
+    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        applyOutputMode(it.value());
+    }
+}
+
+void StreamSessionCache::setTileFrameRate(int fps)
+{
+    if (m_tileFps == fps) {
+        return;
+    }
+    m_tileFps = fps;
+    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        applyOutputMode(it.value());
+    }
+}
+
+void StreamSessionCache::applyOutputMode(const Session& session)
+{
+    // 1路网格的格子就是整个画面，不降低帧率
+    bool tileMode = session.focusCount == 0 && m_tileSize.isValid();
+    session.decoder->setOutputSize(tileMode ? m_tileSize : QSize());
+    session.decoder->setMaxFrameRate(tileMode ? m_tileFps : 0);
+}
+
+int StreamSessionCache::refCount(const QString& url) const
+{
+    auto it = m_sessions.constFind(url);
+    return it == m_sessions.constEnd() ? 0 : it.value().refCount;
+}
+
+void StreamSessionCache::closeAll()
+{
+    // 全部交给回收器：停止请求同时发出，总等待时间约等于最慢的一路
+    for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        DecoderReaper::instance()->retire(it.value().decoder);
+        delete it.value().lingerTimer;
+    }
+    m_sessions.clear();
+    DecoderReaper::instance()->shutdown();
+}
+
+StreamSessionCache::Session* StreamSessionCache::findSession(MultiStreamDecoder* decoder, QString* url)
+{
+    // 按指针查找，不解引用：closeAll() 之后仍持有旧指针的调用方释放时也是安全的
+    if (!decoder) {
+        return nullptr;
+    }
+    for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        if (it.value().decoder == decoder) {
+            if (url) {
+                *url = it.key();
+            }
+            return &it.value();
+        }
+    }
+    return nullptr;
+}
+
+void StreamSessionCache::closeSession(const QString& url)
+{
+    auto it = m_sessions.find(url);
+    if (it == m_sessions.end()) {
+        return;
+    }
+    MultiStreamDecoder* decoder = it.value().decoder;
+    it.value().lingerTimer->deleteLater();
+    m_sessions.erase(it);
+
+    // 交给回收器，界面线程不等待解码线程退出
+    DecoderReaper::instance()->retire(decoder);
+
+    qDebug() << "Close stream session:" << url;
+    emit sessionClosed(url);
+}
@@ -0,0 +1,76 @@
+#ifndef STREAMSESSIONCACHE_H
+#define STREAMSESSIONCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSize>
+#include <QString>
+#include <QTimer>
+
+#include "MultiStreamDecoder.h"
+
+/**
+ * @brief 按URL共享的RTSP会话缓存（引用计数）
+ *
+ * 同一个地址只建立一次RTSP连接和一个解码线程，网格、单路画面和录像都从同一个会话取帧。
+ * 引用计数归零后会话先保留一段时间，期间重新打开同一地址（例如重复应用方案）直接复用；
+ * 超时后把解码器交给DecoderReaper，停止和回收都不阻塞界面线程。
+ * 只在界面线程中使用。
+ */
+class StreamSessionCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static StreamSessionCache* instance();     // 进程内唯一的会话缓存
+    ~StreamSessionCache();
+
+    MultiStreamDecoder* acquire(const QString& url);   // 获取会话（不存在时创建并启动），引用计数加一
+    void release(MultiStreamDecoder* decoder);         // 引用计数减一，归零后延迟关闭
+
+    // 暂停/恢复：所有使用者都暂停时才真正暂停解码
+    void suspend(MultiStreamDecoder* decoder);
+    void resume(MultiStreamDecoder* decoder);
+
+    // 输出规格：有焦点订阅者（单路画面、放大的格子）时按原始分辨率和帧率输出，
+    // 否则缩小到网格格子大小并限制帧率
+    void setFocused(MultiStreamDecoder* decoder, bool focused);
+    void setTileSize(const QSize& size);        // 空尺寸表示不缩放（1路网格）
+    QSize tileSize() const { return m_tileSize; }
+    void setTileFrameRate(int fps);             // 格子画面的帧率上限，0表示不限制
+    int tileFrameRate() const { return m_tileFps; }
+
+    bool contains(const QString& url) const { return m_sessions.contains(url); }
+    int refCount(const QString& url) const;
+    int sessionCount() const { return m_sessions.size(); }
+    QHash<QString, MultiStreamDecoder*> sessions() const; // URL -> 解码器（含延迟关闭中的会话）
+
+    void setLingerInterval(int ms) { m_lingerMs = ms; }
+    void closeAll();                            // 立即关闭全部会话并等待解码线程退出（程序退出、释放全部句柄后调用）
+
+signals:
+    void sessionOpened(const QString& url);     // 新建了RTSP会话
+    void sessionClosed(const QString& url);     // RTSP会话已关闭
+
+private:
+    explicit StreamSessionCache(QObject *parent = nullptr);
+
+    struct Session {
+        MultiStreamDecoder* decoder = nullptr;
+        int refCount = 0;           // 使用者数量
+        int activeCount = 0;        // 未暂停的使用者数量
+        int focusCount = 0;         // 需要全分辨率的使用者数量
+        QTimer* lingerTimer = nullptr; // 引用归零后的延迟关闭定时器
+    };
+
+    Session* findSession(MultiStreamDecoder* decoder, QString* url = nullptr);
+    void closeSession(const QString& url);      // 移出缓存并交给回收器
+    void applyOutputMode(const Session& session);
+
+    QHash<QString, Session> m_sessions;         // URL -> 会话
+    int m_lingerMs;                             // 引用归零后保留的时间
+    QSize m_tileSize;                           // 非焦点会话的输出尺寸
+    int m_tileFps;                              // 非焦点会话的帧率上限
+};
+
+#endif // STREAMSESSIONCACHE_H
@@ -0,0 +1,75 @@
+#include "StreamStatsTable.h"
+#include "MultiStreamController.h"
+#include <QHeaderView>
+#include <algorithm>
+
+StreamStatsTable::StreamStatsTable(QWidget *parent)
+    : QTableWidget(parent)
+    , m_streamController(nullptr)
+{
+    QStringList headers;
+    headers << "画面" << "接收fps" << "解码fps" << "显示fps" << "丢帧" << "码率kbps"
+            << "收包ms" << "解码ms" << "转换ms" << "绘制ms" << "延迟p50" << "延迟p95";
+    setColumnCount(headers.size());
+    setHorizontalHeaderLabels(headers);
+    verticalHeader()->setVisible(false);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionMode(QAbstractItemView::NoSelection);
+    horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+}
+
+void StreamStatsTable::setStreamController(MultiStreamController* controller)
+{
+    if (m_streamController) {
+        disconnect(m_streamController, nullptr, this, nullptr);
+    }
+    m_streamController = controller;
+    if (m_streamController) {
+        connect(m_streamController, &MultiStreamController::statsUpdated, this, &StreamStatsTable::refresh);
+    }
+    refresh();
+}
+
+void StreamStatsTable::refresh()
+{
+    if (!m_streamController) {
+        setRowCount(0);
+        return;
+    }
+
+    QList<MultiStreamController::StreamInfo> infos = m_streamController->getAllStreamInfo();
+    std::sort(infos.begin(), infos.end(), [](const MultiStreamController::StreamInfo& a,
+                                             const MultiStreamController::StreamInfo& b) {
+        return a.displayIndex < b.displayIndex;
+    });
+
+    setRowCount(infos.size());
+    for (int row = 0; row < infos.size(); ++row) {
+        const auto& info = infos[row];
+        StreamMetrics::Report report = m_streamController->getStreamReport(info.handle);
+
+        QStringList values;
+        values << QString::number(info.displayIndex + 1)
+               << QString::number(report.receiveFps, 'f', 1)
+               << QString::number(report.decodeFps, 'f', 1)
+               << QString::number(report.renderFps, 'f', 1)
+               << QString::number(report.dropped)
+               << QString::number(qRound(report.bitrateKbps))
+               << QString::number(report.demuxMs, 'f', 1)
+               << QString::number(report.decodeMs, 'f', 1)
+               << QString::number(report.convertMs, 'f', 1)
+               << QString::number(report.paintMs, 'f', 1)
+               << QString::number(report.latencyP50Ms, 'f', 0)
+               << QString::number(report.latencyP95Ms, 'f', 0);
+
+        for (int column = 0; column < values.size(); ++column) {
+            QTableWidgetItem* cell = item(row, column);
+            if (!cell) {
+                cell = new QTableWidgetItem();
+                setItem(row, column, cell);
+            }
+            cell->setText(values[column]);
+        }
+        item(row, 0)->setToolTip(info.url);
+    }
+}
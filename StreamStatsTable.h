@@ -0,0 +1,30 @@
+#ifndef STREAMSTATSTABLE_H
+#define STREAMSTATSTABLE_H
+
+#include <QTableWidget>
+
+class MultiStreamController;
+
+/**
+ * @brief 各路视频流的流水线统计表
+ *
+ * 每路一行，显示最近一秒的帧率、码率、各阶段耗时和延迟；
+ * 随 MultiStreamController::statsUpdated 每秒刷新，按画面位置排序。
+ */
+class StreamStatsTable : public QTableWidget
+{
+    Q_OBJECT
+
+public:
+    explicit StreamStatsTable(QWidget *parent = nullptr);
+
+    void setStreamController(MultiStreamController* controller);
+
+public slots:
+    void refresh();                                 // 按控制器中最新的统计刷新全部行
+
+private:
+    MultiStreamController* m_streamController;
+};
+
+#endif // STREAMSTATSTABLE_H
@@ -0,0 +1,281 @@
+#include "TcpCommandServer.h"
+#include "MetricsHttpServer.h"
+#include <QDebug>
+
+// 比较客户端地址，兼容IPv4映射的IPv6地址（::ffff:x.x.x.x）
+static bool peerMatches(const QTcpSocket* sock, const QString& host)
+{
+    return QHostAddress(host).isEqual(sock->peerAddress(), QHostAddress::TolerantConversion);
+}
+
+TcpCommandServer::TcpCommandServer(QObject *parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &TcpCommandServer::onNewConnection);
+}
+
+TcpCommandServer::~TcpCommandServer()
+{
+    close();
+}
+
+bool TcpCommandServer::listen(const QHostAddress& address, quint16 port)
+{
+    if (m_server->isListening()) {
+        m_server->close();
+    }
+    if (!m_server->listen(address, port)) {
+        qWarning() << "TCP listen failed" << address.toString() << port << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void TcpCommandServer::close()
+{
+    m_server->close();
+
+    // 断开并删除所有已连接的客户端socket（先取出列表，断开时的状态回调不再修改它）
+    QList<QTcpSocket*> clients;
+    clients.swap(m_clients);
+    for (QTcpSocket* sock : clients) {
+        if (sock->state() == QAbstractSocket::ConnectedState) {
+            sock->disconnectFromHost();
+        }
+        sock->deleteLater();
+    }
+}
+
+int TcpCommandServer::send(const QString& message, const QString& host)
+{
+    QByteArray payload = message.toUtf8();
+    int sentCount = 0;
+    for (QTcpSocket* sock : m_clients) {
+        if (sock->state() != QAbstractSocket::ConnectedState) {
+            continue;
+        }
+        if (!host.isEmpty() && !peerMatches(sock, host)) {
+            continue;
+        }
+        sock->write(payload);
+        ++sentCount;
+    }
+    return sentCount;
+}
+
+int TcpCommandServer::sendToPort(const QString& message, quint16 port)
+{
+    QByteArray payload = message.toUtf8();
+    int sentCount = 0;
+    for (QTcpSocket* sock : m_clients) {
+        if (sock->state() == QAbstractSocket::ConnectedState && sock->peerPort() == port) {
+            sock->write(payload);
+            ++sentCount;
+        }
+    }
+    return sentCount;
+}
+
+int TcpCommandServer::sendBatch(const QString& host, const QStringList& messages)
+{
+    if (messages.isEmpty()) {
+        return 0;
+    }
+    // 多条指令拼接后一次写入，每个设备只产生一次发送
+    return send(messages.join(QString()), host);
+}
+
+bool TcpCommandServer::hasClient(const QString& host) const
+{
+    for (QTcpSocket* sock : m_clients) {
+        if (sock && sock->state() == QAbstractSocket::ConnectedState && peerMatches(sock, host)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TcpCommandServer::hasConnectedClients() const
+{
+    return connectedClientCount() > 0;
+}
+
+int TcpCommandServer::connectedClientCount() const
+{
+    int count = 0;
+    for (QTcpSocket* sock : m_clients) {
+        if (sock && sock->state() == QAbstractSocket::ConnectedState) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+qint64 TcpCommandServer::pendingSendBytes() const
+{
+    qint64 bytes = 0;
+    for (QTcpSocket* sock : m_clients) {
+        if (sock) {
+            bytes += sock->bytesToWrite();
+        }
+    }
+    return bytes;
+}
+
+void TcpCommandServer::collectMetrics(MetricsText& out) const
+{
+    out.gauge("rtsp_tcp_clients", "Connected detection/servo TCP clients.", connectedClientCount());
+    out.gauge("rtsp_tcp_send_backlog_bytes", "Bytes queued for sending to the TCP clients.", pendingSendBytes());
+}
+
+QString TcpCommandServer::formatInfoMessage(int deviceId, int operationId, int operationValue)
+{
+    return QString("DEVICE_%1:OP_%2:VALUE_%3\r\n")
+        .arg(deviceId)
+        .arg(operationId)
+        .arg(operationValue);
+}
+
+QString TcpCommandServer::formatRectMessage(int x, int y, int width, int height)
+{
+    return QString("RECT_ABS:%1:%2:%3:%4\r\n")
+        .arg(x)
+        .arg(y)
+        .arg(width)
+        .arg(height);
+}
+
+QString TcpCommandServer::formatRectMessage(float x, float y, float width, float height)
+{
+    // 归一化坐标保留4位小数
+    return QString("RECT:%1:%2:%3:%4\r\n")
+        .arg(QString::number(x, 'f', 4))
+        .arg(QString::number(y, 'f', 4))
+        .arg(QString::number(width, 'f', 4))
+        .arg(QString::number(height, 'f', 4));
+}
+
+QString TcpCommandServer::formatListMessage(const QSet<int>& objectIds)
+{
+    QStringList idList;
+    for (int id : objectIds) {
+        idList.append(QString::number(id));
+    }
+    return QString("LIST:%1\r\n").arg(idList.join(","));
+}
+
+bool TcpCommandServer::parseDetections(const QString& data, QString* summary, QVector<DetectionObject>* objects,
+                                       QString* error)
+{
+    // 去除首尾空白字符并检查数据是否以DETECTIONS开头
+    QString trimmedData = data.trimmed();
+    if (!trimmedData.startsWith("DETECTIONS")) {
+        return false;
+    }
+
+    // 解析检测数据格式：DETECTIONS:6|0:person:209:2:506:475:0.843|62:tv:633:313:57:62:0.774|...
+    // 对象信息内部也以':'分隔，因此只按第一个':'截取前缀之后的内容
+    int prefixEnd = trimmedData.indexOf(':');
+    if (prefixEnd < 0) {
+        if (error) {
+            *error = "检测数据格式错误：" + trimmedData;
+        }
+        return false;
+    }
+
+    QString detectionInfo = trimmedData.mid(prefixEnd + 1);
+    QStringList objectParts = detectionInfo.split("|");
+    if (objectParts.isEmpty()) {
+        if (error) {
+            *error = "检测数据为空";
+        }
+        return false;
+    }
+
+    // 第一个部分是对象总数
+    int totalObjects = objectParts[0].toInt();
+
+    // 解析每个检测对象的信息，格式：class_id:class_name:x:y:width:height:confidence
+    QStringList categories;
+    int objectIndex = 1;
+    for (int i = 1; i < objectParts.size(); ++i) {
+        QStringList objectDetails = objectParts[i].split(":");
+        if (objectDetails.size() < 2) {
+            continue;
+        }
+        QString className = objectDetails[1];
+        categories.append(QString("%1:%2").arg(objectIndex).arg(className));
+        objectIndex++;
+
+        if (objects) {
+            DetectionObject obj;
+            obj.classId = objectDetails[0].toInt();
+            obj.className = className;
+            if (objectDetails.size() >= 7) {
+                obj.x = objectDetails[2].toInt();
+                obj.y = objectDetails[3].toInt();
+                obj.width = objectDetails[4].toInt();
+                obj.height = objectDetails[5].toInt();
+                obj.confidence = objectDetails[6].toFloat();
+            }
+            objects->append(obj);
+        }
+    }
+
+    if (summary) {
+        if (!categories.isEmpty()) {
+            *summary = QString("%1个物体,%2").arg(totalObjects).arg(categories.join(";"));
+        } else {
+            *summary = QString("%1个物体").arg(totalObjects);
+        }
+    }
+    return true;
+}
+
+void TcpCommandServer::onNewConnection()
+{
+    while (QTcpSocket* clientSocket = m_server->nextPendingConnection()) {
+        m_clients << clientSocket;
+        connect(clientSocket, &QTcpSocket::readyRead, this, &TcpCommandServer::onReadyRead);
+        connect(clientSocket, &QTcpSocket::stateChanged, this, &TcpCommandServer::onStateChanged);
+        emit clientConnected(clientSocket->peerAddress().toString(), clientSocket->peerPort());
+    }
+}
+
+void TcpCommandServer::onReadyRead()
+{
+    QTcpSocket* senderSocket = qobject_cast<QTcpSocket*>(sender());
+    if (!senderSocket) {
+        return;
+    }
+
+    QString message = QString::fromUtf8(senderSocket->readAll());
+    QString host = senderSocket->peerAddress().toString();
+    emit messageReceived(host, senderSocket->peerPort(), message);
+
+    // 检查是否为检测数据并进行处理
+    QString summary;
+    QString error;
+    QVector<DetectionObject> objects;
+    if (parseDetections(message, &summary, &objects, &error)) {
+        emit detectionDataReceived(summary);
+        emit detectionObjectsReceived(host, objects);
+    } else if (!error.isEmpty()) {
+        emit protocolError(error);
+    }
+}
+
+void TcpCommandServer::onStateChanged(QAbstractSocket::SocketState state)
+{
+    QTcpSocket* sock = qobject_cast<QTcpSocket*>(sender());
+    if (!sock) {
+        return;
+    }
+    emit clientStateChanged(sock->peerPort(), state);
+
+    // 断开的客户端从列表中移除，避免列表随重连无限增长
+    if (state == QAbstractSocket::UnconnectedState && m_clients.removeOne(sock)) {
+        sock->deleteLater();
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef TCPCOMMANDSERVER_H
+#define TCPCOMMANDSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include "common.h"
+
+class MetricsText;
+
+// 设备ID枚举定义
+enum DeviceID {
+    DEVICE_SERVO = 1,    // 舵机设备
+    DEVICE_CAMERA = 2,   // 摄像头设备
+    DEVICE_LED = 3       // LED设备
+};
+
+// 操作ID枚举定义
+enum OperationID {
+    // 舵机操作ID (1-5)
+    SERVO_UP = 1,      // 云台上
+    SERVO_DOWN = 2,    // 云台下
+    SERVO_LEFT = 3,    // 云台左
+    SERVO_RIGHT = 4,   // 云台右
+    SERVO_RESET = 5,   // 云台复位
+
+    // 摄像头操作ID
+    CAMERA_AI_ENABLE = 6,      // AI使能
+    CAMERA_REGION_ENABLE = 7,  // 区域使能
+    CAMERA_OBJECT_ENABLE = 8,  // 对象使能
+    RTSP_ENABLE = 9            // RTSP使能
+};
+
+/**
+ * @brief 设备指令TCP服务（不依赖界面）
+ *
+ * 管理检测板/云台的TCP连接：向设备下发指令，解析设备上报的 DETECTIONS 检测数据。
+ * 界面程序由 Tcpserver 窗口包装使用，无界面的服务进程直接使用本类。
+ */
+class TcpCommandServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TcpCommandServer(QObject *parent = nullptr);
+    ~TcpCommandServer();
+
+    bool listen(const QHostAddress& address, quint16 port); // 开始监听
+    void close();                                           // 停止监听并断开所有客户端
+    bool isListening() const { return m_server->isListening(); }
+    QString errorString() const { return m_server->errorString(); }
+
+    // 发送接口，返回发送到的设备数
+    int send(const QString& message, const QString& host = QString()); // host为空时发给所有设备
+    int sendToPort(const QString& message, quint16 port);               // 发给指定端口的设备
+    int sendBatch(const QString& host, const QStringList& messages);    // 多条指令拼接后一次写入
+
+    bool hasClient(const QString& host) const;  // 指定IP的设备是否已连接
+    bool hasConnectedClients() const;           // 判断是否有已连接客户端
+    int connectedClientCount() const;           // 已连接客户端数量
+    qint64 pendingSendBytes() const;            // 各客户端尚未发出的数据量（发送积压）
+    void collectMetrics(MetricsText& out) const;
+
+    // 指令格式化（单条指令，含结尾换行）
+    static QString formatInfoMessage(int deviceId, int operationId, int operationValue);
+    static QString formatRectMessage(int x, int y, int width, int height);          // 绝对坐标
+    static QString formatRectMessage(float x, float y, float width, float height);  // 归一化坐标
+    static QString formatListMessage(const QSet<int>& objectIds);
+
+    // 解析 DETECTIONS:数量|类别ID:类别:x:y:w:h:置信度|... ，不是检测数据时返回false
+    static bool parseDetections(const QString& data, QString* summary, QVector<DetectionObject>* objects,
+                                QString* error);
+
+signals:
+    void clientConnected(const QString& ip, quint16 port);
+    void clientStateChanged(quint16 port, QAbstractSocket::SocketState state);
+    void messageReceived(const QString& ip, quint16 port, const QString& message);
+    void detectionDataReceived(const QString& detectionData); // 处理后的检测摘要
+    void detectionObjectsReceived(const QString& sourceHost, const QVector<DetectionObject>& objects); // 检测对象明细
+    void protocolError(const QString& error);                 // 检测数据格式错误
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onStateChanged(QAbstractSocket::SocketState state);
+
+private:
+    QTcpServer* m_server;
+    QList<QTcpSocket*> m_clients;   // 已连接的客户端socket列表
+};
+
+#endif // TCPCOMMANDSERVER_H
@@ -5,12 +5,12 @@
 #include <QDebug>
 
 Tcpserver::Tcpserver(QWidget* parent)
-    : QWidget(parent), tcpServer(nullptr), serverThread(nullptr)
+    : QWidget(parent), m_core(nullptr), serverThread(nullptr)
 {
     this->setWindowTitle("Tcpserver");
     this->resize(800, 480);
 
-    tcpServer = new QTcpServer(this);
+    m_core = new TcpCommandServer(this);
 
     pushButton[0] = new QPushButton("开始监听");
     pushButton[1] = new QPushButton("停止监听");
@@ -75,7 +75,15 @@ Tcpserver::Tcpserver(QWidget* parent)
     connect(pushButton[2], &QPushButton::clicked, this, &Tcpserver::clearTextBrowser);
     connect(pushButton[3], &QPushButton::clicked, this, &Tcpserver::sendMessages);
     connect(pushButton[4], &QPushButton::clicked, this, &Tcpserver::lockip);
-    connect(tcpServer, &QTcpServer::newConnection, this, &Tcpserver::clientConnected);
+    connect(m_core, &TcpCommandServer::clientConnected, this, &Tcpserver::clientConnected);
+    connect(m_core, &TcpCommandServer::messageReceived, this, &Tcpserver::receiveMessages);
+    connect(m_core, &TcpCommandServer::clientStateChanged, this, &Tcpserver::socketStateChange);
+    connect(m_core, &TcpCommandServer::protocolError, this, [this](const QString& error) {
+        textBrowser->append("⚠️ " + error);
+    });
+    // 检测数据直接转发给controller
+    connect(m_core, &TcpCommandServer::detectionDataReceived, this, &Tcpserver::detectionDataReceived);
+    connect(m_core, &TcpCommandServer::detectionObjectsReceived, this, &Tcpserver::detectionObjectsReceived);
 }
 
 Tcpserver::~Tcpserver() {
@@ -113,7 +121,10 @@ void Tcpserver::startListen()
     // 检查IP地址输入框内容是否有效（此处原代码判断条件有误，应该判断IP地址是否为空）
     if (!Ip_lineEdit->text().isEmpty()) {
         // 开始监听指定IP和端口
-        tcpServer->listen(hostAddress, spinBox->value());
+        if (!m_core->listen(hostAddress, spinBox->value())) {
+            textBrowser->append("监听失败：" + m_core->errorString());
+            return;
+        }
         // 设置“开始监听”按钮不可用
         pushButton[0]->setEnabled(false);
         // 设置“停止监听”按钮可用
@@ -134,16 +145,8 @@ void Tcpserver::startListen()
 
 void Tcpserver::stopListen()
 {
-    // 关闭TCP服务器
-    tcpServer->close();
-
-    // 断开并删除所有已连接的客户端socket
-    foreach (QTcpSocket* sock, clientSockets) {
-        if (sock->state() == QAbstractSocket::ConnectedState)
-            sock->disconnectFromHost(); // 断开连接
-        sock->deleteLater(); // 延迟删除socket对象
-    }
-    clientSockets.clear(); // 清空客户端socket列表
+    // 关闭TCP服务器，断开并删除所有已连接的客户端socket
+    m_core->close();
 
     // 更新按钮和控件状态
     pushButton[1]->setEnabled(false); // 停止监听按钮不可用
@@ -175,15 +178,11 @@ void Tcpserver::sendMessages()
     QString msg = Sent_lineEdit->text() + "\r\n"; // 每次发送信息添加换行符号\r\n
     QString selectedPort = comboBox->currentText();
     
-    // 遍历所有客户端socket
-    for (QTcpSocket* sock : clientSockets) {
-        // 如果socket处于已连接状态
-        if (sock->state() == QAbstractSocket::ConnectedState) {
-            // 如果选择"all"或端口号匹配，则发送消息
-            if (selectedPort == "all" || selectedPort == QString::number(sock->peerPort())) {
-                sock->write(msg.toUtf8());
-            }
-        }
+    // 选择"all"时发给所有客户端，否则只发给端口号匹配的客户端
+    if (selectedPort == "all") {
+        m_core->send(msg);
+    } else {
+        m_core->sendToPort(msg, selectedPort.toUShort());
     }
     
     // 在文本浏览器中显示服务端发送的消息（显示内容也加\r\n）
@@ -194,24 +193,12 @@ void Tcpserver::sendMessages()
     }
 }
 
-void Tcpserver::clientConnected()
+void Tcpserver::clientConnected(const QString& ip, quint16 port)
 {
-    // 获取下一个待处理的客户端连接
-    QTcpSocket* clientSocket = tcpServer->nextPendingConnection();
-    // 将新连接的客户端socket添加到clientSockets列表
-    clientSockets << clientSocket;
-    // 获取客户端IP地址
-    QString ip = clientSocket->peerAddress().toString();
-    // 获取客户端端口号
-    quint16 port = clientSocket->peerPort();
     // 在文本浏览器中显示客户端已连接的信息
     textBrowser->append("客户端已连接");
     textBrowser->append("客户端ip地址:" + ip);
     textBrowser->append("客户端端口:" + QString::number(port));
-    // 连接readyRead信号，用于接收客户端消息
-    connect(clientSocket, &QTcpSocket::readyRead, this, &Tcpserver::receiveMessages);
-    // 连接stateChanged信号，用于监控socket状态变化
-    connect(clientSocket, &QTcpSocket::stateChanged, this, &Tcpserver::socketStateChange);
 
     // 新增：将端口号添加到comboBox（避免重复）
     QString portStr = QString::number(port);
@@ -222,25 +209,12 @@ void Tcpserver::clientConnected()
     emit tcpClientConnected(ip, port);
 }
 
-void Tcpserver::receiveMessages()
+void Tcpserver::receiveMessages(const QString& ip, quint16 port, const QString& message)
 {
-    // 获取发送消息的客户端socket
-    QTcpSocket* senderSocket = qobject_cast<QTcpSocket*>(sender());
-    if (!senderSocket) return; // 如果获取失败则直接返回
-    
-    // 获取客户端端口号
-    quint16 port = senderSocket->peerPort();
-    
-    // 读取客户端发送的全部数据
-    QByteArray data = senderSocket->readAll();
-    QString message = QString::fromUtf8(data);
-    
-    // 格式化显示普通消息
+    Q_UNUSED(ip);
+    // 格式化显示普通消息，检测数据由TcpCommandServer解析后转发
     QString displayMessage = QString("客户端[%1]：%2").arg(port).arg(message);
     textBrowser->append(displayMessage);
-    
-    // 检查是否为检测数据并进行处理
-    processDetectionData(message);
 }
 
 void Tcpserver::lockip()
@@ -257,8 +231,9 @@ void Tcpserver::lockip()
     }
 }
 
-void Tcpserver::socketStateChange(QAbstractSocket::SocketState state)
+void Tcpserver::socketStateChange(quint16 port, QAbstractSocket::SocketState state)
 {
+    Q_UNUSED(port);
     switch (state) {
     case QAbstractSocket::UnconnectedState:
         textBrowser->append("scoket状态：UnconnectedState");
@@ -298,161 +273,76 @@ void TcpServerThread::run()
 
 void Tcpserver::Tcp_sent_info(int deviceId, int operationId, int operationValue)
 {
-    // 构造固定格式的字符串：DEVICE_ID:OPERATION_ID:OPERATION_VALUE，并添加换行符
-    QString message = QString("DEVICE_%1:OP_%2:VALUE_%3\r\n")
-                     .arg(deviceId)
-                     .arg(operationId)
-                     .arg(operationValue);
+    // 构造固定格式的字符串：DEVICE_ID:OPERATION_ID:OPERATION_VALUE，并添加换行符，发送给所有连接的客户端
+    QString message = formatInfoMessage(deviceId, operationId, operationValue);
+    m_core->send(message);
     
-    // 发送给所有连接的客户端
-    for (QTcpSocket* sock : clientSockets) {
-        if (sock->state() == QAbstractSocket::ConnectedState) {
-            sock->write(message.toUtf8());
-        }
-    }
-    
-    // 在文本浏览器中显示发送的信息，并手动添加换行
+    // 在文本浏览器中显示发送的信息
     textBrowser->append("服务端发送设备信息：" + message);
-//    textBrowser->append(QString("设备ID: %1, 操作ID: %2, 操作数值: %3\n")
-//                       .arg(deviceId)
-//                       .arg(operationId)
-//                       .arg(operationValue));
 }
 
 void Tcpserver::Tcp_sent_rect(int x, int y, int width, int height)
 {
-    // 构造绝对坐标矩形框信息的字符串
-    QString message = QString("RECT_ABS:%1:%2:%3:%4\r\n")
-                         .arg(x)
-                         .arg(y)
-                         .arg(width)
-                         .arg(height);
-    // 发送给所有连接的客户端
-    for (QTcpSocket* sock : clientSockets) {
-        if (sock->state() == QAbstractSocket::ConnectedState) {
-            sock->write(message.toUtf8());
-        }
-    }
-    // 在文本浏览器中显示发送的矩形框信息
+    // 构造绝对坐标矩形框信息的字符串，发送给所有连接的客户端
+    QString message = TcpCommandServer::formatRectMessage(x, y, width, height);
+    m_core->send(message);
     textBrowser->append("服务端发送绝对矩形框信息：" + message);
-//    textBrowser->append(QString("绝对矩形框: x=%1, y=%2, 尺寸: %3×%4\n")
-//                       .arg(x)
-//                       .arg(y)
-//                       .arg(width)
-//                       .arg(height));
 }
 
 void Tcpserver::Tcp_sent_rect(float x, float y, float width, float height)
 {
     // 构造归一化矩形框信息的字符串，保留4位小数
-    QString message = QString("RECT:%1:%2:%3:%4\r\n")
-                         .arg(QString::number(x, 'f', 4))
-                         .arg(QString::number(y, 'f', 4))
-                         .arg(QString::number(width, 'f', 4))
-                         .arg(QString::number(height, 'f', 4));
-    // 发送给所有连接的客户端
-    for (QTcpSocket* sock : clientSockets) {
-        if (sock->state() == QAbstractSocket::ConnectedState) {
-            sock->write(message.toUtf8());
-        }
-    }
-    // 在文本浏览器中显示发送的矩形框信息
+    QString message = TcpCommandServer::formatRectMessage(x, y, width, height);
+    m_core->send(message);
     textBrowser->append("服务端发送归一化矩形框信息：" + message);
-//    textBrowser->append(QString("归一化矩形框: x=%1, y=%2, 尺寸: %3×%4\n")
-//                       .arg(QString::number(x, 'f', 4))
-//                       .arg(QString::number(y, 'f', 4))
-//                       .arg(QString::number(width, 'f', 4))
-//                       .arg(QString::number(height, 'f', 4)));
 }
 
 void Tcpserver::Tcp_sent_list(const QSet<int>& objectIds)
 {
     // 构造对象列表信息的字符串：LIST:objectId1,objectId2,objectId3...，并添加换行符
-    QStringList idList;
-    for (int id : objectIds) {
-        idList.append(QString::number(id));
-    }
-    
-    QString message = QString("LIST:%1\r\n").arg(idList.join(","));
-    
-    // 发送给所有连接的客户端
-    for (QTcpSocket* sock : clientSockets) {
-        if (sock->state() == QAbstractSocket::ConnectedState) {
-            sock->write(message.toUtf8());
-        }
-    }
-    
-    // 在文本浏览器中显示发送的对象列表信息
+    QString message = formatListMessage(objectIds);
+    m_core->send(message);
     textBrowser->append("服务端发送对象列表信息：" + message);
-//    textBrowser->append(QString("选中对象数量: %1, 对象ID: %2\n")
-//                       .arg(objectIds.size())
-//                       .arg(idList.join(", ")));
-} 
+}
 
-bool Tcpserver::hasConnectedClients() const
+int Tcpserver::Tcp_sent_batch(const QString& host, const QStringList& messages)
 {
-    for (QTcpSocket* sock : clientSockets) {
-        if (sock && sock->state() == QAbstractSocket::ConnectedState) {
-            return true;
-        }
+    if (messages.isEmpty()) {
+        return 0;
     }
-    return false;
+
+    int sentCount = m_core->sendBatch(host, messages);
+    textBrowser->append(QString("服务端批量发送%1条指令到%2：").arg(messages.size())
+                        .arg(host.isEmpty() ? "全部设备" : host) + messages.join(QString()));
+    return sentCount;
 }
 
-// 处理检测数据的函数，当接收到DETECTIONS格式的数据时触发图像保存
-void Tcpserver::processDetectionData(const QString& data)
+bool Tcpserver::hasClient(const QString& host) const
 {
-    // 去除首尾空白字符并检查数据是否以DETECTIONS开头
-    QString trimmedData = data.trimmed();
-    if (!trimmedData.startsWith("DETECTIONS")) {
-        return; // 不是检测数据格式，直接返回
-    }
-    
-    // 解析检测数据格式：DETECTIONS:6|0:person:209:2:506:475:0.843|62:tv:633:313:57:62:0.774|...
-    QStringList parts = trimmedData.split(":");
-    if (parts.size() < 2) {
-        // 数据格式不正确，记录错误信息
-        textBrowser->append("⚠️ 检测数据格式错误：" + trimmedData);
-        return;
-    }
-    
-    // 提取检测对象数量和详细信息
-    QString detectionInfo = parts[1]; // 获取"6|0:person:209:2:506:475:0.843|62:tv:..."部分
-    QStringList objectParts = detectionInfo.split("|");
-    
-    if (objectParts.isEmpty()) {
-        textBrowser->append("⚠️ 检测数据为空");
-        return;
-    }
-    
-    // 第一个部分是对象总数
-    int totalObjects = objectParts[0].toInt();
-    
-    // 解析每个检测对象的信息
-    QStringList categories;
-    int objectIndex = 1;
-    
-    for (int i = 1; i < objectParts.size(); ++i) {
-        QString objectInfo = objectParts[i];
-        QStringList objectDetails = objectInfo.split(":");
-        
-        // 格式：class_id:class_name:x:y:width:height:confidence
-        if (objectDetails.size() >= 2) {
-            QString className = objectDetails[1]; // 获取类别名称
-            categories.append(QString("%1:%2").arg(objectIndex).arg(className));
-            objectIndex++;
-        }
-    }
-    
-    // 构建处理后的数据格式
-    QString processedData;
-    if (!categories.isEmpty()) {
-        processedData = QString("%1个物体,%2").arg(totalObjects).arg(categories.join(";"));
-    } else {
-        processedData = QString("%1个物体").arg(totalObjects);
-    }
-    
-    
-    // 发射信号给controller，传递处理后的数据
-    emit detectionDataReceived(processedData);
+    return m_core->hasClient(host);
+}
+
+QString Tcpserver::formatInfoMessage(int deviceId, int operationId, int operationValue)
+{
+    return TcpCommandServer::formatInfoMessage(deviceId, operationId, operationValue);
+}
+
+QString Tcpserver::formatListMessage(const QSet<int>& objectIds)
+{
+    return TcpCommandServer::formatListMessage(objectIds);
+}
+
+bool Tcpserver::hasConnectedClients() const
+{
+    return m_core->hasConnectedClients();
+}
+
+int Tcpserver::connectedClientCount() const
+{
+    return m_core->connectedClientCount();
+}
+
+qint64 Tcpserver::pendingSendBytes() const
+{
+    return m_core->pendingSendBytes();
 }
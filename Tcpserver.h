@@ -14,32 +14,13 @@
 #include <QList>
 #include <QNetworkInterface>
 #include <QNetworkAddressEntry>
-
-// 设备ID枚举定义
-enum DeviceID {
-    DEVICE_SERVO = 1,    // 舵机设备
-    DEVICE_CAMERA = 2,   // 摄像头设备
-    DEVICE_LED = 3       // LED设备
-};
-
-// 操作ID枚举定义
-enum OperationID {
-    // 舵机操作ID (1-5)
-    SERVO_UP = 1,      // 云台上
-    SERVO_DOWN = 2,    // 云台下
-    SERVO_LEFT = 3,    // 云台左
-    SERVO_RIGHT = 4,   // 云台右
-    SERVO_RESET = 5,   // 云台复位
-
-    // 摄像头操作ID
-    CAMERA_AI_ENABLE = 6,      // AI使能
-    CAMERA_REGION_ENABLE = 7,  // 区域使能
-    CAMERA_OBJECT_ENABLE = 8,  // 对象使能
-    RTSP_ENABLE = 9            // RTSP使能
-}; 
+#include <QVector>
+#include "common.h"
+#include "TcpCommandServer.h"
 
 class TcpServerThread;
 
+// 设备指令TCP服务的调试窗口：网络收发由 TcpCommandServer 完成，本窗口只负责显示和手动发送
 class Tcpserver : public QWidget {
     Q_OBJECT
 public:
@@ -50,9 +31,20 @@ public:
     void Tcp_sent_rect(int x, int y, int width, int height);    // 发送矩形框信息  
     void Tcp_sent_rect(float x, float y, float width, float height);
     void Tcp_sent_list(const QSet<int>& objectIds); // 发送目标ID列表
+    int Tcp_sent_batch(const QString& host, const QStringList& messages); // 向指定IP的设备一次性发送多条指令，host为空时发给所有设备，返回发送到的设备数
+    bool hasClient(const QString& host) const;  // 指定IP的设备是否已连接
+
+    // 指令格式化（单条指令，含结尾换行）
+    static QString formatInfoMessage(int deviceId, int operationId, int operationValue);
+    static QString formatListMessage(const QSet<int>& objectIds);
+
+    TcpCommandServer* core() const { return m_core; } // 不依赖界面的TCP服务
+
     void startListen();                // 开始监听
     void stopListen();                 // 停止监听
     bool hasConnectedClients() const;  // 判断是否有已连接客户端
+    int connectedClientCount() const;  // 已连接客户端数量
+    qint64 pendingSendBytes() const;   // 各客户端尚未发出的数据量（发送积压）
 
     // 公有成员：文本显示区（为了让Controller能够访问）
     QTextBrowser* textBrowser;         // 文本显示区
@@ -60,20 +52,19 @@ public:
 signals:
     void tcpClientConnected(const QString& ip, quint16 port); // 新增：客户端连接成功信号
     void detectionDataReceived(const QString& detectionData); // 新增：检测数据接收信号
+    void detectionObjectsReceived(const QString& sourceHost, const QVector<DetectionObject>& objects); // 检测对象明细信号
 
 private slots:
     void clearTextBrowser();           // 清空文本显示
     void sendMessages();               // 发送消息给客户端
-    void clientConnected();            // 有客户端连接
-    void receiveMessages();            // 接收客户端消息
+    void clientConnected(const QString& ip, quint16 port); // 有客户端连接
+    void receiveMessages(const QString& ip, quint16 port, const QString& message); // 显示客户端消息
     void lockip();                     // 锁定/解锁IP输入框
-    void socketStateChange(QAbstractSocket::SocketState state); // socket状态变化处理
+    void socketStateChange(quint16 port, QAbstractSocket::SocketState state); // socket状态变化处理
 
 private:
     void getLocalHostIP();             // 获取本地所有IP
-    void processDetectionData(const QString& data); // 新增：处理检测数据
-    QTcpServer* tcpServer;             // TCP服务器对象
-    QList<QTcpSocket*> clientSockets;  // 已连接的客户端socket列表
+    TcpCommandServer* m_core;          // TCP服务（监听、收发、检测数据解析）
     QPushButton* pushButton[5];        // 按钮数组
     QLabel* label[2];                  // 标签数组
     QLineEdit* Ip_lineEdit;            // IP输入框
@@ -0,0 +1,224 @@
+#include "ThumbnailCache.h"
+#include "MultiStreamDecoder.h"
+#include <QRunnable>
+#include <QThread>
+#include <QImageReader>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+
+// 线程池中的解码任务：缩略图或屏幕尺寸显示图
+class ThumbnailTask : public QRunnable
+{
+public:
+    ThumbnailTask(ThumbnailCache* cache, const QString& path, const QString& key,
+                  const QSize& targetSize, bool isThumbnail, int generation = 0)
+        : m_cache(cache), m_path(path), m_key(key), m_targetSize(targetSize)
+        , m_cacheDir(cache->m_cacheDir), m_isThumbnail(isThumbnail), m_generation(generation) {}
+
+    void run() override
+    {
+        // 排队期间又预取了别的位置：显示图不再需要，跳过解码
+        ThumbnailCache* cache = m_cache;
+        QString key = m_key;
+        int generation = m_generation;
+        if (!m_isThumbnail && generation != cache->m_displayGeneration.loadAcquire()) {
+            QMetaObject::invokeMethod(cache, [cache, key, generation]() {
+                cache->discardDisplayImage(key, generation);
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        QImage image = m_isThumbnail
+            ? ThumbnailCache::loadThumbnail(m_path, m_cacheDir)
+            : ThumbnailCache::decodeScaled(m_path, m_targetSize, Qt::KeepAspectRatioByExpanding);
+
+        // 结果回到界面线程写入缓存（缓存对象析构时会等待线程池结束，指针在此处一定有效）
+        QString path = m_path;
+        bool isThumbnail = m_isThumbnail;
+        QMetaObject::invokeMethod(cache, [cache, path, key, image, isThumbnail, generation]() {
+            if (isThumbnail) {
+                cache->storeThumbnail(path, image);
+            } else {
+                cache->storeDisplayImage(key, path, image, generation);
+            }
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    ThumbnailCache* m_cache;
+    QString m_path;
+    QString m_key;
+    QSize m_targetSize;
+    QString m_cacheDir;
+    bool m_isThumbnail;
+    int m_generation;                       // 显示图任务的批次
+};
+
+ThumbnailCache::ThumbnailCache(QObject *parent)
+    : QObject(parent)
+    , m_displayGeneration(0)
+{
+    m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/thumbnails";
+    QDir().mkpath(m_cacheDir);
+
+    // 留出一半核心给视频解码
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+
+    // 缓存按KB计费：缩略图32MB，显示图128MB
+    m_thumbnails.setMaxCost(32 * 1024);
+    m_displayImages.setMaxCost(128 * 1024);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QImage ThumbnailCache::thumbnail(const QString& path) const
+{
+    QImage* image = m_thumbnails.object(path);
+    return image ? *image : QImage();
+}
+
+QImage ThumbnailCache::displayImage(const QString& path, const QSize& targetSize) const
+{
+    QImage* image = m_displayImages.object(displayKey(path, targetSize));
+    return image ? *image : QImage();
+}
+
+void ThumbnailCache::requestThumbnail(const QString& path)
+{
+    QString key = "thumb:" + path;
+    if (m_thumbnails.contains(path) || m_pending.contains(key)) {
+        return;
+    }
+    m_pending.insert(key);
+    m_pool.start(new ThumbnailTask(this, path, key, thumbnailSize(), true), -1);
+}
+
+void ThumbnailCache::requestDisplayImage(const QString& path, const QSize& targetSize, int priority)
+{
+    QString key = displayKey(path, targetSize);
+    int generation = m_displayGeneration.loadAcquire();
+    auto pending = m_pendingDisplay.constFind(key);
+    if (m_displayImages.contains(key) || (pending != m_pendingDisplay.constEnd() && pending.value() == generation)) {
+        return;
+    }
+    m_pendingDisplay.insert(key, generation);
+    m_pool.start(new ThumbnailTask(this, path, key, targetSize, false, generation), priority);
+}
+
+void ThumbnailCache::prefetch(const QString& current, const QStringList& neighbours, const QSize& targetSize)
+{
+    // 作废还没开始执行的旧显示图任务（正在执行的完成后照常入缓存），排队中的缩略图任务保留
+    m_displayGeneration.fetchAndAddOrdered(1);
+
+    if (!current.isEmpty()) {
+        requestDisplayImage(current, targetSize, 1); // 当前文件优先
+    }
+    for (const QString& path : neighbours) {
+        requestDisplayImage(path, targetSize, 0);
+    }
+}
+
+void ThumbnailCache::removeFile(const QString& path)
+{
+    m_thumbnails.remove(path);
+    const QStringList keys = m_displayImages.keys();
+    for (const QString& key : keys) {
+        if (key.endsWith("|" + path)) {
+            m_displayImages.remove(key);
+        }
+    }
+}
+
+bool ThumbnailCache::isVideoFile(const QString& path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "mp4" || suffix == "avi" || suffix == "mov"
+        || suffix == "mkv" || suffix == "flv" || suffix == "wmv";
+}
+
+QImage ThumbnailCache::decodeScaled(const QString& path, const QSize& targetSize, Qt::AspectRatioMode mode)
+{
+    if (isVideoFile(path)) {
+        // 视频取封面帧，只缩小不放大
+        return MultiStreamDecoder::extractPosterFrame(path, targetSize);
+    }
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+
+    // 只在需要缩小时设置解码尺寸，放大交给显示时处理
+    QSize sourceSize = reader.size();
+    if (sourceSize.isValid() && targetSize.isValid()) {
+        QSize scaledSize = sourceSize.scaled(targetSize, mode);
+        if (scaledSize.width() < sourceSize.width() && scaledSize.height() < sourceSize.height()) {
+            reader.setScaledSize(scaledSize);
+        }
+    }
+    return reader.read();
+}
+
+QImage ThumbnailCache::loadThumbnail(const QString& path, const QString& cacheDir)
+{
+    // 磁盘缓存文件名由路径、修改时间和大小决定，原文件变化后自动失效
+    QFileInfo fileInfo(path);
+    QByteArray id = QString("%1|%2|%3")
+                        .arg(fileInfo.absoluteFilePath())
+                        .arg(fileInfo.lastModified().toMSecsSinceEpoch())
+                        .arg(fileInfo.size()).toUtf8();
+    QString cacheFile = cacheDir + "/" + QCryptographicHash::hash(id, QCryptographicHash::Md5).toHex() + ".jpg";
+
+    if (QFile::exists(cacheFile)) {
+        QImage cached(cacheFile);
+        if (!cached.isNull()) {
+            return cached;
+        }
+    }
+
+    QImage image = decodeScaled(path, thumbnailSize(), Qt::KeepAspectRatio);
+    if (!image.isNull()) {
+        image.save(cacheFile, "JPG", 85);
+    }
+    return image;
+}
+
+void ThumbnailCache::storeThumbnail(const QString& path, const QImage& image)
+{
+    m_pending.remove("thumb:" + path);
+    if (image.isNull()) {
+        return;
+    }
+    m_thumbnails.insert(path, new QImage(image), qMax(1, int(image.sizeInBytes() / 1024)));
+    emit thumbnailReady(path, image);
+}
+
+void ThumbnailCache::discardDisplayImage(const QString& key, int generation)
+{
+    // 同一文件可能已按新批次重新排队，只清除本批次的记录
+    if (m_pendingDisplay.value(key, -1) == generation) {
+        m_pendingDisplay.remove(key);
+    }
+}
+
+void ThumbnailCache::storeDisplayImage(const QString& key, const QString& path, const QImage& image, int generation)
+{
+    discardDisplayImage(key, generation);
+    if (image.isNull()) {
+        emit displayImageReady(path, image); // 解码失败也通知界面，便于提示加载失败
+        return;
+    }
+    m_displayImages.insert(key, new QImage(image), qMax(1, int(image.sizeInBytes() / 1024)));
+    emit displayImageReady(path, image);
+}
+
+QString ThumbnailCache::displayKey(const QString& path, const QSize& targetSize)
+{
+    return QString("%1x%2|%3").arg(targetSize.width()).arg(targetSize.height()).arg(path);
+}
@@ -0,0 +1,73 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QCache>
+#include <QSet>
+#include <QHash>
+#include <QAtomicInt>
+#include <QThreadPool>
+
+/**
+ * @brief 相册缩略图与显示图缓存
+ *
+ * 图片解码全部在线程池中进行，结果通过信号回到界面线程：
+ * - 缩略图同时缓存在内存和磁盘（应用数据目录/thumbnails），再次打开相册无需重新解码原图；
+ * - 显示图按屏幕尺寸用QImageReader::setScaledSize缩小解码，JPEG可直接在DCT阶段缩放；
+ * - 视频文件用FFmpeg提取封面帧（定位到关键帧后解码一帧），同样走磁盘和内存缓存；
+ * - prefetch() 作废尚未开始的旧显示图任务（开始执行时发现已过期直接返回），只为当前位置附近的文件排队，
+ *   拖动滑动条时不会积压；缩略图任务不受影响。
+ */
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailCache(QObject *parent = nullptr);
+    ~ThumbnailCache();
+
+    static QSize thumbnailSize() { return QSize(160, 120); } // 缩略图尺寸
+    static bool isVideoFile(const QString& path);   // 是否为视频文件（按扩展名判断）
+
+    // 内存缓存查询（未命中返回空图像，不会阻塞）
+    QImage thumbnail(const QString& path) const;
+    QImage displayImage(const QString& path, const QSize& targetSize) const;
+
+    // 异步请求，完成后发出对应信号
+    void requestThumbnail(const QString& path);
+    void requestDisplayImage(const QString& path, const QSize& targetSize, int priority = 0);
+
+    // 预取：作废排队中的旧显示图任务，为当前文件附近的文件重新排队
+    void prefetch(const QString& current, const QStringList& neighbours, const QSize& targetSize);
+
+    void removeFile(const QString& path);           // 文件被删除时清理对应缓存
+
+    // 同步解码接口（在工作线程中调用）
+    static QImage decodeScaled(const QString& path, const QSize& targetSize, Qt::AspectRatioMode mode);
+    static QImage loadThumbnail(const QString& path, const QString& cacheDir);
+
+signals:
+    void thumbnailReady(const QString& path, const QImage& image);
+    void displayImageReady(const QString& path, const QImage& image);
+
+private:
+    friend class ThumbnailTask;
+    void storeThumbnail(const QString& path, const QImage& image);
+    void storeDisplayImage(const QString& key, const QString& path, const QImage& image, int generation);
+    void discardDisplayImage(const QString& key, int generation);  // 过期任务未解码就结束
+    static QString displayKey(const QString& path, const QSize& targetSize);
+
+    QString m_cacheDir;                     // 磁盘缩略图目录
+    QThreadPool m_pool;                     // 解码线程池
+    QCache<QString, QImage> m_thumbnails;   // 缩略图内存缓存（按字节计费）
+    QCache<QString, QImage> m_displayImages; // 显示图内存缓存（按字节计费）
+    QSet<QString> m_pending;                // 已排队的缩略图任务，避免重复解码
+    QHash<QString, int> m_pendingDisplay;   // 已排队的显示图任务 -> 排队时的批次
+    QAtomicInt m_displayGeneration;         // 显示图任务批次，prefetch() 时递增，旧批次的任务不再解码
+};
+
+#endif // THUMBNAILCACHE_H
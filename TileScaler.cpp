@@ -0,0 +1,439 @@
+#include "TileScaler.h"
+#include <QtGlobal>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TILESCALER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// BT.601 定点系数（2^13），与 swscale 默认的 YUV->RGB 矩阵一致
+const int kCoeffBits = 13;
+const int kCoeffRound = 1 << (kCoeffBits - 1);
+
+struct Coeffs {
+    int32_t yOffset;
+    int32_t y;
+    int32_t rv;
+    int32_t gu;
+    int32_t gv;
+    int32_t bu;
+};
+
+const Coeffs kLimitedRange = { 16, 9539, 13075, 3209, 6660, 16525 };   // YUV420P：16-235
+const Coeffs kFullRange = { 0, 8192, 11485, 2819, 5850, 14516 };       // YUVJ420P：0-255
+
+typedef void (*SumRowsFn)(const uint8_t* src, int stride, int rows, int width, uint16_t* out);
+typedef void (*SumColumnsFn)(const uint16_t* in, int factor, int shift, int count, int32_t* out);
+typedef void (*YuvToRgbFn)(const int32_t* y, const int32_t* u, const int32_t* v, int count,
+                           const Coeffs& c, uint32_t* out);
+
+struct Kernels {
+    SumRowsFn sumRows;
+    SumColumnsFn sumColumns;
+    YuvToRgbFn yuvToRgb;
+};
+
+// ---------------- 标量版本（也用于处理SIMD版本剩余的尾部） ----------------
+
+// 逐行累加，内层循环连续访问内存，编译器可以自动向量化（非 x86 平台也能受益）
+void sumRowsScalar(const uint8_t* src, int stride, int rows, int width, uint16_t* out)
+{
+    for (int x = 0; x < width; ++x) {
+        out[x] = src[x];
+    }
+    for (int r = 1; r < rows; ++r) {
+        const uint8_t* row = src + r * stride;
+        for (int x = 0; x < width; ++x) {
+            out[x] = static_cast<uint16_t>(out[x] + row[x]);
+        }
+    }
+}
+
+void sumColumnsScalar(const uint16_t* in, int factor, int shift, int count, int32_t* out)
+{
+    const int32_t round = (1 << shift) >> 1;
+    for (int i = 0; i < count; ++i) {
+        int32_t sum = 0;
+        for (int k = 0; k < factor; ++k) {
+            sum += in[i * factor + k];
+        }
+        out[i] = (sum + round) >> shift;
+    }
+}
+
+inline uint32_t packPixel(int32_t r, int32_t g, int32_t b)
+{
+    r = qBound(0, r, 255);
+    g = qBound(0, g, 255);
+    b = qBound(0, b, 255);
+    return 0xff000000u | (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+}
+
+void yuvToRgbScalar(const int32_t* y, const int32_t* u, const int32_t* v, int count,
+                    const Coeffs& c, uint32_t* out)
+{
+    for (int i = 0; i < count; ++i) {
+        int32_t yy = (y[i] - c.yOffset) * c.y;
+        int32_t uu = u[i] - 128;
+        int32_t vv = v[i] - 128;
+        out[i] = packPixel((yy + c.rv * vv + kCoeffRound) >> kCoeffBits,
+                           (yy - c.gu * uu - c.gv * vv + kCoeffRound) >> kCoeffBits,
+                           (yy + c.bu * uu + kCoeffRound) >> kCoeffBits);
+    }
+}
+
+const Kernels kScalarKernels = { sumRowsScalar, sumColumnsScalar, yuvToRgbScalar };
+
+#ifdef TILESCALER_X86
+
+// ---------------- SSE4.1 ----------------
+
+__attribute__((target("sse4.1")))
+void sumRowsSse41(const uint8_t* src, int stride, int rows, int width, uint16_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i lo = zero;
+        __m128i hi = zero;
+        for (int r = 0; r < rows; ++r) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + r * stride + x));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 8), hi);
+    }
+    sumRowsScalar(src + x, stride, rows, width - x, out + x);
+}
+
+// 纵向和最多 8*255，可以按有符号16位用 madd 两两相加
+__attribute__((target("sse4.1")))
+void sumColumnsSse41(const uint16_t* in, int factor, int shift, int count, int32_t* out)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi32((1 << shift) >> 1);
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+    const __m128i* src = reinterpret_cast<const __m128i*>(in);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i sum;
+        switch (factor) {
+        case 1:
+            sum = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+            break;
+        case 2:
+            sum = _mm_madd_epi16(_mm_loadu_si128(src + i / 4), ones);
+            break;
+        case 4:
+            sum = _mm_hadd_epi32(_mm_madd_epi16(_mm_loadu_si128(src + i / 2), ones),
+                                 _mm_madd_epi16(_mm_loadu_si128(src + i / 2 + 1), ones));
+            break;
+        default: {
+            __m128i a = _mm_hadd_epi32(_mm_madd_epi16(_mm_loadu_si128(src + i), ones),
+                                       _mm_madd_epi16(_mm_loadu_si128(src + i + 1), ones));
+            __m128i b = _mm_hadd_epi32(_mm_madd_epi16(_mm_loadu_si128(src + i + 2), ones),
+                                       _mm_madd_epi16(_mm_loadu_si128(src + i + 3), ones));
+            sum = _mm_hadd_epi32(a, b);
+            break;
+        }
+        }
+        sum = _mm_sra_epi32(_mm_add_epi32(sum, round), shiftCount);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), sum);
+    }
+    sumColumnsScalar(in + i * factor, factor, shift, count - i, out + i);
+}
+
+__attribute__((target("sse4.1")))
+void yuvToRgbSse41(const int32_t* y, const int32_t* u, const int32_t* v, int count,
+                   const Coeffs& c, uint32_t* out)
+{
+    const __m128i yOffset = _mm_set1_epi32(c.yOffset);
+    const __m128i cy = _mm_set1_epi32(c.y);
+    const __m128i rv = _mm_set1_epi32(c.rv);
+    const __m128i gu = _mm_set1_epi32(c.gu);
+    const __m128i gv = _mm_set1_epi32(c.gv);
+    const __m128i bu = _mm_set1_epi32(c.bu);
+    const __m128i half = _mm_set1_epi32(128);
+    const __m128i round = _mm_set1_epi32(kCoeffRound);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi32(255);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i yy = _mm_mullo_epi32(_mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)),
+                                                   yOffset), cy);
+        yy = _mm_add_epi32(yy, round);
+        __m128i uu = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i)), half);
+        __m128i vv = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i)), half);
+        __m128i r = _mm_srai_epi32(_mm_add_epi32(yy, _mm_mullo_epi32(vv, rv)), kCoeffBits);
+        __m128i g = _mm_srai_epi32(_mm_sub_epi32(_mm_sub_epi32(yy, _mm_mullo_epi32(uu, gu)),
+                                                 _mm_mullo_epi32(vv, gv)), kCoeffBits);
+        __m128i b = _mm_srai_epi32(_mm_add_epi32(yy, _mm_mullo_epi32(uu, bu)), kCoeffBits);
+        r = _mm_min_epi32(_mm_max_epi32(r, zero), max);
+        g = _mm_min_epi32(_mm_max_epi32(g, zero), max);
+        b = _mm_min_epi32(_mm_max_epi32(b, zero), max);
+        __m128i pixel = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(g, 8)),
+                                     _mm_or_si128(b, alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), pixel);
+    }
+    yuvToRgbScalar(y + i, u + i, v + i, count - i, c, out + i);
+}
+
+const Kernels kSse41Kernels = { sumRowsSse41, sumColumnsSse41, yuvToRgbSse41 };
+
+// ---------------- AVX2 ----------------
+
+__attribute__((target("avx2")))
+void sumRowsAvx2(const uint8_t* src, int stride, int rows, int width, uint16_t* out)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i sum = _mm256_setzero_si256();
+        for (int r = 0; r < rows; ++r) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + r * stride + x));
+            sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(v));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), sum);
+    }
+    sumRowsScalar(src + x, stride, rows, width - x, out + x);
+}
+
+// _mm256_hadd_epi32 在两个128位通道内分别相加，结果按64位重新排列为 0,2,1,3 才是顺序
+__attribute__((target("avx2")))
+inline __m256i pairSumsAvx2(__m256i a, __m256i b)
+{
+    return _mm256_permute4x64_epi64(_mm256_hadd_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+__attribute__((target("avx2")))
+void sumColumnsAvx2(const uint16_t* in, int factor, int shift, int count, int32_t* out)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i round = _mm256_set1_epi32((1 << shift) >> 1);
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+    const __m256i* src = reinterpret_cast<const __m256i*>(in);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i sum;
+        switch (factor) {
+        case 1:
+            sum = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+            break;
+        case 2:
+            sum = _mm256_madd_epi16(_mm256_loadu_si256(src + i / 8), ones);
+            break;
+        case 4:
+            sum = pairSumsAvx2(_mm256_madd_epi16(_mm256_loadu_si256(src + i / 4), ones),
+                               _mm256_madd_epi16(_mm256_loadu_si256(src + i / 4 + 1), ones));
+            break;
+        default: {
+            __m256i a = pairSumsAvx2(_mm256_madd_epi16(_mm256_loadu_si256(src + i / 2), ones),
+                                     _mm256_madd_epi16(_mm256_loadu_si256(src + i / 2 + 1), ones));
+            __m256i b = pairSumsAvx2(_mm256_madd_epi16(_mm256_loadu_si256(src + i / 2 + 2), ones),
+                                     _mm256_madd_epi16(_mm256_loadu_si256(src + i / 2 + 3), ones));
+            sum = pairSumsAvx2(a, b);
+            break;
+        }
+        }
+        sum = _mm256_sra_epi32(_mm256_add_epi32(sum, round), shiftCount);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sum);
+    }
+    sumColumnsScalar(in + i * factor, factor, shift, count - i, out + i);
+}
+
+__attribute__((target("avx2")))
+void yuvToRgbAvx2(const int32_t* y, const int32_t* u, const int32_t* v, int count,
+                  const Coeffs& c, uint32_t* out)
+{
+    const __m256i yOffset = _mm256_set1_epi32(c.yOffset);
+    const __m256i cy = _mm256_set1_epi32(c.y);
+    const __m256i rv = _mm256_set1_epi32(c.rv);
+    const __m256i gu = _mm256_set1_epi32(c.gu);
+    const __m256i gv = _mm256_set1_epi32(c.gv);
+    const __m256i bu = _mm256_set1_epi32(c.bu);
+    const __m256i half = _mm256_set1_epi32(128);
+    const __m256i round = _mm256_set1_epi32(kCoeffRound);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi32(255);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i yy = _mm256_mullo_epi32(_mm256_sub_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)), yOffset), cy);
+        yy = _mm256_add_epi32(yy, round);
+        __m256i uu = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + i)), half);
+        __m256i vv = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), half);
+        __m256i r = _mm256_srai_epi32(_mm256_add_epi32(yy, _mm256_mullo_epi32(vv, rv)), kCoeffBits);
+        __m256i g = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_sub_epi32(yy, _mm256_mullo_epi32(uu, gu)),
+                                                       _mm256_mullo_epi32(vv, gv)), kCoeffBits);
+        __m256i b = _mm256_srai_epi32(_mm256_add_epi32(yy, _mm256_mullo_epi32(uu, bu)), kCoeffBits);
+        r = _mm256_min_epi32(_mm256_max_epi32(r, zero), max);
+        g = _mm256_min_epi32(_mm256_max_epi32(g, zero), max);
+        b = _mm256_min_epi32(_mm256_max_epi32(b, zero), max);
+        __m256i pixel = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(r, 16), _mm256_slli_epi32(g, 8)),
+                                        _mm256_or_si256(b, alpha));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), pixel);
+    }
+    yuvToRgbScalar(y + i, u + i, v + i, count - i, c, out + i);
+}
+
+const Kernels kAvx2Kernels = { sumRowsAvx2, sumColumnsAvx2, yuvToRgbAvx2 };
+
+#endif // TILESCALER_X86
+
+const Kernels& kernelsFor(TileScaler::Isa isa)
+{
+#ifdef TILESCALER_X86
+    switch (isa) {
+    case TileScaler::Avx2:
+        return kAvx2Kernels;
+    case TileScaler::Sse41:
+        return kSse41Kernels;
+    default:
+        break;
+    }
+#else
+    Q_UNUSED(isa);
+#endif
+    return kScalarKernels;
+}
+
+int log2Of(int factor)
+{
+    int bits = 0;
+    while ((1 << bits) < factor) {
+        ++bits;
+    }
+    return bits;
+}
+
+} // namespace
+
+TileScaler::TileScaler()
+    : m_isa(detectIsa())
+{
+}
+
+int TileScaler::factorFor(int pixelFormat, const QSize& source, const QSize& target)
+{
+    if (pixelFormat != AV_PIX_FMT_YUV420P && pixelFormat != AV_PIX_FMT_YUVJ420P) {
+        return 0;
+    }
+    if (!target.isValid() || target.isEmpty()) {
+        return 0;
+    }
+    for (int factor = 8; factor >= 2; factor /= 2) {
+        if (source.width() / factor >= target.width() && source.height() / factor >= target.height()) {
+            return factor;
+        }
+    }
+    return 0;
+}
+
+bool TileScaler::isEnabled()
+{
+    static const bool enabled = qgetenv("RTSP_TILE_SCALER") != "0";
+    return enabled;
+}
+
+bool TileScaler::scale(const AVFrame* frame, int factor, uchar* dst, int dstStride)
+{
+    if (!frame || !dst || (factor != 2 && factor != 4 && factor != 8)) {
+        return false;
+    }
+    if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_YUVJ420P) {
+        return false;
+    }
+    const int outWidth = frame->width / factor;
+    const int outHeight = frame->height / factor;
+    if (outWidth <= 0 || outHeight <= 0) {
+        return false;
+    }
+
+    // 每个输出像素对应 factor x factor 个亮度样本、(factor/2) x (factor/2) 个色度样本；
+    // 宽高不能整除时丢掉最右/最下不足一块的像素
+    const int chroma = factor / 2;
+    const int shiftY = 2 * log2Of(factor);
+    const int shiftC = 2 * log2Of(chroma);
+    const Coeffs& coeffs = frame->format == AV_PIX_FMT_YUVJ420P ? kFullRange : kLimitedRange;
+    const Kernels& kernels = kernelsFor(m_isa);
+
+    m_rowY.resize(static_cast<size_t>(outWidth) * factor);
+    m_rowU.resize(static_cast<size_t>(outWidth) * chroma);
+    m_rowV.resize(static_cast<size_t>(outWidth) * chroma);
+    m_y.resize(outWidth);
+    m_u.resize(outWidth);
+    m_v.resize(outWidth);
+
+    for (int oy = 0; oy < outHeight; ++oy) {
+        kernels.sumRows(frame->data[0] + oy * factor * frame->linesize[0], frame->linesize[0],
+                        factor, outWidth * factor, m_rowY.data());
+        kernels.sumRows(frame->data[1] + oy * chroma * frame->linesize[1], frame->linesize[1],
+                        chroma, outWidth * chroma, m_rowU.data());
+        kernels.sumRows(frame->data[2] + oy * chroma * frame->linesize[2], frame->linesize[2],
+                        chroma, outWidth * chroma, m_rowV.data());
+        kernels.sumColumns(m_rowY.data(), factor, shiftY, outWidth, m_y.data());
+        kernels.sumColumns(m_rowU.data(), chroma, shiftC, outWidth, m_u.data());
+        kernels.sumColumns(m_rowV.data(), chroma, shiftC, outWidth, m_v.data());
+        kernels.yuvToRgb(m_y.data(), m_u.data(), m_v.data(), outWidth, coeffs,
+                         reinterpret_cast<uint32_t*>(dst + oy * dstStride));
+    }
+    return true;
+}
+
+bool TileScaler::setIsa(Isa isa)
+{
+    if (!isSupported(isa)) {
+        return false;
+    }
+    m_isa = isa;
+    return true;
+}
+
+TileScaler::Isa TileScaler::detectIsa()
+{
+    if (isSupported(Avx2)) {
+        return Avx2;
+    }
+    if (isSupported(Sse41)) {
+        return Sse41;
+    }
+    return Scalar;
+}
+
+bool TileScaler::isSupported(Isa isa)
+{
+    switch (isa) {
+    case Scalar:
+        return true;
+#ifdef TILESCALER_X86
+    case Sse41:
+        return __builtin_cpu_supports("sse4.1");
+    case Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* TileScaler::isaName(Isa isa)
+{
+    switch (isa) {
+    case Avx2:
+        return "avx2";
+    case Sse41:
+        return "sse4.1";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef TILESCALER_H
+#define TILESCALER_H
+
+#include <QSize>
+#include <vector>
+#include <cstdint>
+
+struct AVFrame;
+
+/**
+ * @brief 网格格子专用的 YUV420P -> RGB32 转换 + 整数倍缩小
+ *
+ * 网格中绝大多数画面是 H.264 的 YUV420P，缩小到格子大小时通常是 2/4/8 倍。
+ * 这里把缩小和颜色转换合在一次遍历里：先按 factor x factor 块求亮度/色度平均值（盒式滤波，
+ * 与 SWS_AREA 在整数倍时等价），再只对输出像素做 BT.601 转换，转换量比先转全分辨率少 factor² 倍。
+ *
+ * 三个逐行内核（纵向求和、横向求和、YUV->RGB）各有标量、SSE4.1、AVX2 版本，运行时按CPU选择；
+ * 各版本使用相同的定点运算，输出逐位一致。非 x86 平台只使用标量版本。
+ * 输出与 swscale（SWS_AREA）的差异在舍入误差范围内，可用 kernel_bench --verify 检查。
+ */
+class TileScaler
+{
+public:
+    enum Isa {
+        Scalar,
+        Sse41,
+        Avx2
+    };
+
+    TileScaler();
+
+    // 选择缩小倍数：source 按 2/4/8 倍缩小后仍不小于 target 时返回最大的倍数，不支持时返回0。
+    // 结果尺寸为 source / factor，与 target 不一致时由调用方在小图上完成剩余（不足2倍）的缩放
+    static int factorFor(int pixelFormat, const QSize& source, const QSize& target);
+    static bool isEnabled();                    // 环境变量 RTSP_TILE_SCALER=0 时关闭，统一走 swscale
+
+    // 将 frame 缩小 factor 倍并转换为 RGB32（0xffRRGGBB），写入 dst；尺寸为 frame 尺寸 / factor
+    bool scale(const AVFrame* frame, int factor, uchar* dst, int dstStride);
+
+    Isa isa() const { return m_isa; }
+    bool setIsa(Isa isa);                       // 指定内核版本（测试/基准用），CPU不支持时返回false
+    static Isa detectIsa();                     // 当前CPU支持的最快版本
+    static bool isSupported(Isa isa);
+    static const char* isaName(Isa isa);
+
+private:
+    Isa m_isa;
+    std::vector<uint16_t> m_rowY;               // 纵向求和后的一行（factor行之和）
+    std::vector<uint16_t> m_rowU;
+    std::vector<uint16_t> m_rowV;
+    std::vector<int32_t> m_y;                   // 每个输出像素的平均值
+    std::vector<int32_t> m_u;
+    std::vector<int32_t> m_v;
+};
+
+#endif // TILESCALER_H
@@ -1,4 +1,6 @@
 #include "VideoGridWidget.h"
+#include "FrameBufferPool.h"
+#include "FrameMemoryBudget.h"
 #include <QDebug>
 #include <QMutexLocker>
 #include <QApplication>
@@ -9,13 +11,22 @@ VideoGridWidget::VideoGridWidget(QWidget *parent)
     , m_currentPage(0)
     , m_totalStreamCount(0)
     , m_selectedIndex(-1)
+    , m_promotedIndex(-1)
+    , m_promotedExternal(false)
 {
     setupUI();
     setGridLayout(GridLayout::Grid_2x2);
+
+    // 内存紧张时丢弃不可见格子的缓存帧（回到该页时等下一帧到达再显示）
+    FrameMemoryBudget::instance()->addOwner(this, "grid", [this](int index) {
+        QMutexLocker locker(&m_mutex);
+        m_videoFrames.remove(index);
+    });
 }
 
 VideoGridWidget::~VideoGridWidget()
 {
+    FrameMemoryBudget::instance()->removeOwner(this);
 }
 
 void VideoGridWidget::setupUI()
@@ -60,8 +71,17 @@ void VideoGridWidget::setupUI()
     m_scrollArea->setWidget(m_gridWidget);
     m_scrollArea->setWidgetResizable(true);
     
+    // 放大画面，与网格区域互斥显示
+    m_promotedLabel = new VideoLabel();
+    m_promotedLabel->setMinimumSize(160, 120);
+    m_promotedLabel->setAlignment(Qt::AlignCenter);
+    m_promotedLabel->setStyleSheet("background-color: black; color: white;");
+    m_promotedLabel->installEventFilter(this);
+    m_promotedLabel->hide();
+    
     m_mainLayout->addLayout(m_controlLayout);
     m_mainLayout->addWidget(m_scrollArea);
+    m_mainLayout->addWidget(m_promotedLabel);
     
     // 连接信号
     connect(m_layoutCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -76,6 +96,8 @@ void VideoGridWidget::setupUI()
 
 void VideoGridWidget::setGridLayout(GridLayout layout)
 {
+    demoteVideo();
+    
     QMutexLocker locker(&m_mutex);
     
     m_currentLayout = layout;
@@ -134,25 +156,36 @@ void VideoGridWidget::setVideoFrame(int index, const QImage& frame)
 {
     QMutexLocker locker(&m_mutex);
     
-    // 缓存帧数据
-    m_videoFrames[index] = frame;
-    
-    // 计算本地索引
+    // 缓存帧数据：不在当前页的只保留格子大小的副本
     int localIndex = globalIndexToLocalIndex(index);
+    bool visible = (localIndex >= 0 && localIndex < m_videoLabels.size()) || index == m_promotedIndex;
+    QImage& cached = m_videoFrames[index];
+    cached = visible ? frame : shrinkToCell(frame);
+    budgetSlot(index)->track(cached, visible);
+    
+    // 当前页的格子立即刷新
     if (localIndex >= 0 && localIndex < m_videoLabels.size()) {
         VideoLabel* label = m_videoLabels[localIndex];
-        if (label && !frame.isNull()) {
-            label->setPixmap(QPixmap::fromImage(frame.scaled(
-                label->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation)));
+        if (label && !frame.isNull() && index != m_promotedIndex) {
+            label->setPixmap(fitPixmap(frame, label->size()));
         }
     }
+    
+    if (index == m_promotedIndex && !m_promotedExternal) {
+        showPromotedFrame(frame);
+    }
 }
 
 void VideoGridWidget::clearVideoFrame(int index)
 {
+    if (index == m_promotedIndex) {
+        demoteVideo();
+    }
+    
     QMutexLocker locker(&m_mutex);
     
     m_videoFrames.remove(index);
+    releaseBudgetSlot(index);
     
     int localIndex = globalIndexToLocalIndex(index);
     if (localIndex >= 0 && localIndex < m_videoLabels.size()) {
@@ -167,8 +200,14 @@ void VideoGridWidget::clearVideoFrame(int index)
 
 void VideoGridWidget::clearAllFrames()
 {
+    demoteVideo();
+    
     QMutexLocker locker(&m_mutex);
     
+    for (auto it = m_budgetSlots.constBegin(); it != m_budgetSlots.constEnd(); ++it) {
+        FrameMemoryBudget::instance()->untrack(this, it.key());
+    }
+    m_budgetSlots.clear();
     m_videoFrames.clear();
     
     for (int i = 0; i < m_videoLabels.size(); ++i) {
@@ -182,12 +221,41 @@ void VideoGridWidget::clearAllFrames()
     }
 }
 
+void VideoGridWidget::setVideoOverlay(int index, const QString& text)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (text.isEmpty()) {
+        m_overlayTexts.remove(index);
+    } else {
+        m_overlayTexts[index] = text;
+    }
+    
+    int localIndex = globalIndexToLocalIndex(index);
+    if (localIndex >= 0 && localIndex < m_videoLabels.size() && m_videoLabels[localIndex]) {
+        m_videoLabels[localIndex]->setOverlayText(text);
+    }
+}
+
+void VideoGridWidget::clearVideoOverlays()
+{
+    QMutexLocker locker(&m_mutex);
+    
+    m_overlayTexts.clear();
+    for (VideoLabel* label : m_videoLabels) {
+        if (label) {
+            label->setOverlayText(QString());
+        }
+    }
+}
+
 void VideoGridWidget::setCurrentPage(int page)
 {
     // 确保页码不小于0
     page = qMax(0, page);
     
     if (page != m_currentPage) {
+        demoteVideo();
         m_currentPage = page;
         m_pageSpinBox->setValue(page + 1); // SpinBox从1开始
         updateVideoLabels();
@@ -246,6 +314,136 @@ QString VideoGridWidget::getSelectedVideoInfo() const
     return "未选择视频";
 }
 
+void VideoGridWidget::promoteVideo(int globalIndex)
+{
+    if (globalIndex < 0 || globalIndex >= m_totalStreamCount) {
+        return;
+    }
+    if (globalIndex == m_promotedIndex) {
+        return;
+    }
+    
+    m_promotedIndex = globalIndex;
+    m_promotedExternal = false;
+    
+    // 先显示缓存的最后一帧（放大显示），高分辨率画面到达后再替换
+    m_promotedLabel->clear();
+    m_promotedLabel->setText(QString("视频 %1").arg(globalIndex));
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_videoFrames.constFind(globalIndex);
+        if (it != m_videoFrames.constEnd()) {
+            showPromotedFrame(it.value());
+        }
+    }
+    
+    m_scrollArea->hide();
+    m_promotedLabel->show();
+    
+    emit promotionChanged(globalIndex);
+}
+
+void VideoGridWidget::demoteVideo()
+{
+    if (m_promotedIndex < 0) {
+        return;
+    }
+    
+    m_promotedIndex = -1;
+    m_promotedExternal = false;
+    m_promotedLabel->hide();
+    m_promotedLabel->clear();
+    m_scrollArea->show();
+    updateVideoLabels(); // 放大期间格子没有刷新，用缓存帧补上
+    
+    emit promotionChanged(-1);
+}
+
+int VideoGridWidget::getPromotedIndex() const
+{
+    return m_promotedIndex;
+}
+
+void VideoGridWidget::setPromotedFrame(const QImage& frame)
+{
+    if (m_promotedIndex < 0 || frame.isNull()) {
+        return;
+    }
+    m_promotedExternal = true; // 之后忽略该格子自身的小画面
+    showPromotedFrame(frame);
+}
+
+void VideoGridWidget::showPromotedFrame(const QImage& frame)
+{
+    if (frame.isNull()) {
+        return;
+    }
+    m_promotedLabel->setPixmap(fitPixmap(frame, m_promotedLabel->size()));
+}
+
+QPixmap VideoGridWidget::fitPixmap(const QImage& frame, const QSize& size)
+{
+    return QPixmap::fromImage(fitImage(frame, size));
+}
+
+QImage VideoGridWidget::fitImage(const QImage& frame, const QSize& size)
+{
+    QSize target = frame.size().scaled(size, Qt::KeepAspectRatio);
+    if (target.isEmpty()) {
+        return QImage();
+    }
+    // 缩小超过2倍时双线性会有锯齿，仍用 QImage::scaled；
+    // 通常解码器已按格子大小输出，只差几个像素，缩放到帧缓冲池的图像，不再每帧新分配
+    if (target.width() * 2 < frame.width() || target.height() * 2 < frame.height()) {
+        return frame.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    return FrameBufferPool::instance()->scaledImage(frame, target);
+}
+
+QSize VideoGridWidget::cellSize() const
+{
+    return m_videoLabels.isEmpty() ? QSize() : m_videoLabels.first()->size();
+}
+
+void VideoGridWidget::trackCachedFrames()
+{
+    // 翻页、切换布局、取消放大后，移出当前页的缓存帧缩小到格子大小
+    for (auto it = m_videoFrames.begin(); it != m_videoFrames.end(); ++it) {
+        int localIndex = globalIndexToLocalIndex(it.key());
+        bool visible = (localIndex >= 0 && localIndex < m_videoLabels.size()) || it.key() == m_promotedIndex;
+        if (!visible) {
+            it.value() = shrinkToCell(it.value());
+        }
+        budgetSlot(it.key())->track(it.value(), visible);
+    }
+}
+
+FrameMemoryBudget::Slot* VideoGridWidget::budgetSlot(int index)
+{
+    // 每帧都会调用：只在第一次时向预算对象（全局锁）申请
+    FrameMemoryBudget::Slot*& slot = m_budgetSlots[index];
+    if (!slot) {
+        slot = FrameMemoryBudget::instance()->slot(this, index);
+    }
+    return slot;
+}
+
+void VideoGridWidget::releaseBudgetSlot(int index)
+{
+    if (m_budgetSlots.remove(index) > 0) {
+        FrameMemoryBudget::instance()->untrack(this, index);
+    }
+}
+
+QImage VideoGridWidget::shrinkToCell(const QImage& frame) const
+{
+    QSize cell = cellSize();
+    if (frame.isNull() || cell.isEmpty() || (frame.width() <= cell.width() && frame.height() <= cell.height())) {
+        return frame;
+    }
+    return fitImage(frame, cell);
+}
+
 VideoLabel* VideoGridWidget::getVideoLabel(int index)
 {
     int localIndex = globalIndexToLocalIndex(index);
@@ -313,8 +511,7 @@ void VideoGridWidget::updateVideoLabels()
         auto it = m_videoFrames.find(globalIndex);
         if (it != m_videoFrames.end() && !it.value().isNull()) {
             // 有视频帧，显示图像
-            label->setPixmap(QPixmap::fromImage(it.value().scaled(
-                label->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation)));
+            label->setPixmap(fitPixmap(it.value(), label->size()));
         } else {
             // 没有视频帧，显示默认文本（确保globalIndex从0开始）
             label->clear();
@@ -324,7 +521,9 @@ void VideoGridWidget::updateVideoLabels()
         
         // 设置视频标签样式
         updateVideoLabelStyle(label, globalIndex);
+        label->setOverlayText(m_overlayTexts.value(globalIndex));
     }
+    trackCachedFrames();
 }
 
 void VideoGridWidget::updateVideoLabelStyle(VideoLabel* label, int globalIndex)
@@ -392,6 +591,15 @@ int VideoGridWidget::localIndexToGlobalIndex(int localIndex) const
 
 bool VideoGridWidget::eventFilter(QObject* watched, QEvent* event)
 {
+    // 双击放大画面恢复网格
+    if (watched == m_promotedLabel) {
+        if (event->type() == QEvent::MouseButtonDblClick) {
+            demoteVideo();
+            return true;
+        }
+        return QWidget::eventFilter(watched, event);
+    }
+    
     VideoLabel* label = qobject_cast<VideoLabel*>(watched);
     if (!label) {
         return QWidget::eventFilter(watched, event);
@@ -410,6 +618,13 @@ bool VideoGridWidget::eventFilter(QObject* watched, QEvent* event)
         emit videoClicked(globalIndex);
         return true; // 已处理事件
     }
+    else if (event->type() == QEvent::MouseButtonDblClick) {
+        // 双击放大该画面
+        if (globalIndex < m_totalStreamCount) {
+            emit videoDoubleClicked(globalIndex);
+        }
+        return true;
+    }
     else if (event->type() == QEvent::Enter) {
         // 鼠标进入事件 - 添加悬停效果
         if (globalIndex != m_selectedIndex && globalIndex < m_totalStreamCount) {
@@ -6,6 +6,7 @@
 #include <QLabel>
 #include <QVector>
 #include <QMap>
+#include <QHash>
 #include <QMutex>
 #include <QScrollArea>
 #include <QSplitter>
@@ -17,6 +18,7 @@
 #include <QEvent>
 
 #include "VideoLabel.h"
+#include "FrameMemoryBudget.h"
 
 /**
  * @brief 网格布局模式
@@ -50,6 +52,8 @@ public:
     void setVideoFrame(int index, const QImage& frame);  // 设置指定位置的视频帧
     void clearVideoFrame(int index);                     // 清除指定位置的视频帧
     void clearAllFrames();                               // 清除所有视频帧
+    void setVideoOverlay(int index, const QString& text); // 设置指定位置的叠加文字（统计信息）
+    void clearVideoOverlays();                           // 清除所有叠加文字
 
     // 分页管理
     void setCurrentPage(int page);                       // 设置当前页
@@ -61,12 +65,21 @@ public:
     void setSelectedIndex(int index);                    // 设置选中的视频索引
     int getSelectedIndex() const;                        // 获取选中的视频索引
     void clearSelection();                               // 清除选择
+    QString getSelectedVideoInfo() const;                // 获取选中视频的描述
+
+    // 放大显示：选中的格子占满整个网格区域，先显示缓存的最后一帧
+    void promoteVideo(int globalIndex);                  // 放大指定视频
+    void demoteVideo();                                  // 恢复网格显示
+    int getPromotedIndex() const;                        // 放大的视频索引，-1表示未放大
+    void setPromotedFrame(const QImage& frame);          // 放大画面使用独立画面源（主码流）时写入帧
 
     // 获取VideoLabel
     VideoLabel* getVideoLabel(int index);               // 获取指定索引的VideoLabel
 
 signals:
     void videoClicked(int globalIndex);                 // 视频被点击，传递全局索引
+    void videoDoubleClicked(int globalIndex);           // 视频被双击
+    void promotionChanged(int globalIndex);             // 放大的视频改变，-1表示恢复网格
     void layoutChanged(GridLayout layout);              // 布局改变
     void pageChanged(int page);                         // 页面改变
     
@@ -84,6 +97,15 @@ private:
     void setupGrid();                                   // 设置网格
     void updatePageControls();                          // 更新分页控件
     void updateVideoLabels();                           // 更新视频标签显示
+    void updateVideoLabelStyle(VideoLabel* label, int globalIndex); // 更新视频标签样式
+    void showPromotedFrame(const QImage& frame);         // 在放大画面上显示一帧
+    static QPixmap fitPixmap(const QImage& frame, const QSize& size); // 等比缩放到标签大小
+    static QImage fitImage(const QImage& frame, const QSize& size);
+    QSize cellSize() const;                             // 格子（标签）大小
+    QImage shrinkToCell(const QImage& frame) const;     // 大于格子时缩小为格子大小的副本
+    void trackCachedFrames();                           // 缩小不可见的缓存帧并向内存预算报告
+    FrameMemoryBudget::Slot* budgetSlot(int index);     // 缓存帧在内存预算中的位置，调用方持有 m_mutex
+    void releaseBudgetSlot(int index);
     int getGridSize(GridLayout layout) const;           // 获取网格大小
     int globalIndexToLocalIndex(int globalIndex) const; // 全局索引转本地索引
     int localIndexToGlobalIndex(int localIndex) const;  // 本地索引转全局索引
@@ -94,6 +116,7 @@ private:
     QGridLayout* m_gridLayout;
     QWidget* m_gridWidget;
     QScrollArea* m_scrollArea;
+    VideoLabel* m_promotedLabel;               // 放大显示的画面
     
     // 控制组件
     QComboBox* m_layoutCombo;
@@ -107,9 +130,13 @@ private:
     int m_currentPage;
     int m_totalStreamCount;
     int m_selectedIndex;
+    int m_promotedIndex;                       // 放大的视频索引
+    bool m_promotedExternal;                   // 放大画面已由独立画面源接管
     
     QVector<VideoLabel*> m_videoLabels;        // 当前显示的VideoLabel
     QMap<int, QImage> m_videoFrames;           // 缓存的视频帧
+    QHash<int, FrameMemoryBudget::Slot*> m_budgetSlots; // 各缓存帧在内存预算中的位置
+    QMap<int, QString> m_overlayTexts;         // 各位置的叠加文字
     
     mutable QMutex m_mutex;
 };
@@ -47,11 +47,25 @@ void VideoLabel::setDrawingEnabled(bool enabled)
     update();
 }
 
+void VideoLabel::setOverlayText(const QString& text)
+{
+    if (m_overlayText != text) {
+        m_overlayText = text;
+        update();
+    }
+}
+
 void VideoLabel::paintEvent(QPaintEvent* event)
 {
     // 先调用父类的paintEvent绘制视频图像
     QLabel::paintEvent(event);
     
+    // 统计信息叠加在视频左上角
+    if (!m_overlayText.isEmpty()) {
+        QPainter painter(this);
+        drawOverlay(painter);
+    }
+    
     // 然后在视频上绘制矩形框
     if (m_isDrawing || m_hasRectangle) {
         QPainter painter(this);
@@ -332,3 +346,16 @@ bool VideoLabel::isPointInButton(const QPoint& pos, const QRect& buttonRect) con
     return buttonRect.contains(pos);
 } 
 
+// 绘制叠加文字（左上角，半透明底色）
+void VideoLabel::drawOverlay(QPainter& painter)
+{
+    QFont font = painter.font();
+    font.setPointSize(8);
+    painter.setFont(font);
+    
+    QRect textRect = painter.fontMetrics().boundingRect(QRect(4, 4, width() - 8, height() - 8),
+                                                        Qt::AlignLeft | Qt::AlignTop, m_overlayText);
+    painter.fillRect(textRect.adjusted(-3, -2, 3, 2), QColor(0, 0, 0, 150));
+    painter.setPen(QColor(0, 255, 128));
+    painter.drawText(textRect, Qt::AlignLeft | Qt::AlignTop, m_overlayText);
+}
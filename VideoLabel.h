@@ -30,6 +30,9 @@ public:
     // 获取当前的矩形框数据
     RectangleBox getRectangle() const { return m_rectangle; }
 
+    // 设置画面左上角叠加显示的文字（如流水线统计），空字符串表示不显示
+    void setOverlayText(const QString& text);
+
 protected:
     // 重写QLabel的绘图事件，用于自定义绘制（如绘制矩形框和按钮）
     void paintEvent(QPaintEvent* event) override;
@@ -58,6 +61,7 @@ private:
     bool m_showButtons;            // 是否显示确定取消按钮
     bool m_rectangleConfirmed;     // 矩形框是否已确认
     bool m_drawingEnabled;         // 绘制功能是否启用
+    QString m_overlayText;         // 叠加显示的文字
     
     // 按钮区域
     QRect m_confirmButtonRect;     // 确定按钮区域
@@ -67,6 +71,8 @@ private:
     void drawRectangle(QPainter& painter);
     // 绘制确认和取消按钮
     void drawButtons(QPainter& painter);
+    // 绘制叠加文字
+    void drawOverlay(QPainter& painter);
     // 更新按钮的位置
     void updateButtonPositions();
     // 判断点是否在按钮区域内
@@ -0,0 +1,193 @@
+#include "VideoPlayerDialog.h"
+#include "DecoderReaper.h"
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QFileInfo>
+#include <QDesktopServices>
+#include <QUrl>
+#include <QResizeEvent>
+
+VideoPlayerDialog::VideoPlayerDialog(const QString& filePath, QWidget *parent)
+    : QDialog(parent)
+    , m_filePath(filePath)
+    , m_decoder(nullptr)
+    , m_durationMs(0)
+    , m_playing(true)
+    , m_finished(false)
+{
+    this->setWindowTitle("视频回放 - " + QFileInfo(filePath).fileName());
+    this->resize(960, 620);
+
+    m_videoLabel = new QLabel(this);
+    m_videoLabel->setAlignment(Qt::AlignCenter);
+    m_videoLabel->setMinimumSize(480, 270);
+    m_videoLabel->setStyleSheet("QLabel { background-color: #000000; color: #ffffff; }");
+    m_videoLabel->setText("正在打开视频...");
+
+    m_playPauseBtn = new QPushButton("暂停", this);
+    m_externalBtn = new QPushButton("外部播放器", this);
+    m_positionSlider = new QSlider(Qt::Horizontal, this);
+    m_positionSlider->setRange(0, 0);
+    m_timeLabel = new QLabel("00:00 / 00:00", this);
+
+    m_playPauseBtn->setFixedSize(80, 30);
+    m_externalBtn->setFixedSize(100, 30);
+    m_playPauseBtn->setStyleSheet(
+        "QPushButton {"
+        "  background-color: #007bff;"
+        "  border: none;"
+        "  border-radius: 4px;"
+        "  font-size: 12px;"
+        "  color: white;"
+        "}"
+        "QPushButton:hover {"
+        "  background-color: #0056b3;"
+        "}"
+    );
+
+    QHBoxLayout* controlLayout = new QHBoxLayout();
+    controlLayout->addWidget(m_playPauseBtn);
+    controlLayout->addWidget(m_positionSlider, 1);
+    controlLayout->addWidget(m_timeLabel);
+    controlLayout->addWidget(m_externalBtn);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(m_videoLabel, 1);
+    mainLayout->addLayout(controlLayout);
+
+    // 拖动进度条时每80ms定位一次，避免每个像素都触发定位
+    m_seekTimer.setSingleShot(true);
+    m_seekTimer.setInterval(80);
+    connect(&m_seekTimer, &QTimer::timeout, this, &VideoPlayerDialog::onSeekTimeout);
+
+    connect(m_playPauseBtn, &QPushButton::clicked, this, &VideoPlayerDialog::onPlayPauseClicked);
+    connect(m_externalBtn, &QPushButton::clicked, this, &VideoPlayerDialog::onOpenExternalClicked);
+    connect(m_positionSlider, &QSlider::sliderMoved, this, &VideoPlayerDialog::onSliderMoved);
+    connect(m_positionSlider, &QSlider::sliderReleased, this, &VideoPlayerDialog::onSliderReleased);
+
+    // 创建文件回放解码器
+    m_decoder = new MultiStreamDecoder(filePath);
+    connect(m_decoder, &MultiStreamDecoder::frameReady, this, &VideoPlayerDialog::onFrameReady);
+    connect(m_decoder, &MultiStreamDecoder::durationChanged, this, &VideoPlayerDialog::onDurationChanged);
+    connect(m_decoder, &MultiStreamDecoder::positionChanged, this, &VideoPlayerDialog::onPositionChanged);
+    connect(m_decoder, &MultiStreamDecoder::playbackFinished, this, &VideoPlayerDialog::onPlaybackFinished);
+    connect(m_decoder, &MultiStreamDecoder::errorOccurred, this, [this](const QString&) {
+        m_videoLabel->setText("视频打开失败");
+    });
+    m_decoder->start();
+}
+
+VideoPlayerDialog::~VideoPlayerDialog()
+{
+    if (m_decoder) {
+        // 关闭对话框不等待解码线程退出
+        disconnect(m_decoder, nullptr, this, nullptr);
+        DecoderReaper::instance()->retire(m_decoder);
+        m_decoder = nullptr;
+    }
+}
+
+void VideoPlayerDialog::onFrameReady(const QImage& frame)
+{
+    m_lastFrame = frame;
+    m_videoLabel->setPixmap(QPixmap::fromImage(frame).scaled(m_videoLabel->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
+}
+
+void VideoPlayerDialog::onDurationChanged(qint64 durationMs)
+{
+    m_durationMs = durationMs;
+    m_positionSlider->setRange(0, static_cast<int>(durationMs));
+    updateTimeLabel(0);
+}
+
+void VideoPlayerDialog::onPositionChanged(qint64 positionMs)
+{
+    // 拖动中不让解码进度覆盖用户的操作
+    if (!m_positionSlider->isSliderDown()) {
+        m_positionSlider->setValue(static_cast<int>(positionMs));
+    }
+    updateTimeLabel(positionMs);
+}
+
+void VideoPlayerDialog::onPlaybackFinished()
+{
+    m_finished = true;
+    m_playing = false;
+    m_playPauseBtn->setText("重播");
+}
+
+void VideoPlayerDialog::onPlayPauseClicked()
+{
+    if (m_finished) {
+        // 播放结束后从头开始
+        m_finished = false;
+        m_playing = true;
+        m_decoder->resumeDecoding();
+        m_decoder->seekTo(0);
+        m_playPauseBtn->setText("暂停");
+        return;
+    }
+
+    m_playing = !m_playing;
+    if (m_playing) {
+        m_decoder->resumeDecoding();
+        m_playPauseBtn->setText("暂停");
+    } else {
+        m_decoder->pauseDecoding();
+        m_playPauseBtn->setText("播放");
+    }
+}
+
+void VideoPlayerDialog::onSliderMoved(int value)
+{
+    updateTimeLabel(value);
+    if (!m_seekTimer.isActive()) {
+        m_seekTimer.start();
+    }
+}
+
+void VideoPlayerDialog::onSliderReleased()
+{
+    m_seekTimer.stop();
+    onSeekTimeout();
+}
+
+void VideoPlayerDialog::onSeekTimeout()
+{
+    if (m_finished) {
+        // 结束后拖动进度条，保持暂停并显示目标帧
+        m_finished = false;
+        m_decoder->pauseDecoding();
+        m_playPauseBtn->setText("播放");
+    }
+    m_decoder->seekTo(m_positionSlider->value());
+}
+
+void VideoPlayerDialog::onOpenExternalClicked()
+{
+    m_decoder->pauseDecoding();
+    m_playing = false;
+    m_playPauseBtn->setText("播放");
+    QDesktopServices::openUrl(QUrl::fromLocalFile(m_filePath));
+}
+
+void VideoPlayerDialog::resizeEvent(QResizeEvent* event)
+{
+    QDialog::resizeEvent(event);
+    if (!m_lastFrame.isNull()) {
+        m_videoLabel->setPixmap(QPixmap::fromImage(m_lastFrame).scaled(m_videoLabel->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
+    }
+}
+
+void VideoPlayerDialog::updateTimeLabel(qint64 positionMs)
+{
+    m_timeLabel->setText(QString("%1 / %2").arg(formatTime(positionMs)).arg(formatTime(m_durationMs)));
+}
+
+QString VideoPlayerDialog::formatTime(qint64 ms)
+{
+    qint64 totalSeconds = ms / 1000;
+    return QString("%1:%2")
+        .arg(totalSeconds / 60, 2, 10, QChar('0'))
+        .arg(totalSeconds % 60, 2, 10, QChar('0'));
+}
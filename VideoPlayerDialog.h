@@ -0,0 +1,57 @@
+#ifndef VIDEOPLAYERDIALOG_H
+#define VIDEOPLAYERDIALOG_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QPushButton>
+#include <QSlider>
+#include <QTimer>
+#include <QImage>
+#include "MultiStreamDecoder.h"
+
+/**
+ * @brief 应用内视频播放窗口，用于快速回看录像和报警视频
+ *
+ * 复用MultiStreamDecoder的文件回放模式，进度条拖动时按关键帧定位。
+ */
+class VideoPlayerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit VideoPlayerDialog(const QString& filePath, QWidget *parent = nullptr);
+    ~VideoPlayerDialog();
+
+private slots:
+    void onFrameReady(const QImage& frame);         // 显示解码帧
+    void onDurationChanged(qint64 durationMs);      // 更新时长
+    void onPositionChanged(qint64 positionMs);      // 更新播放位置
+    void onPlaybackFinished();                      // 播放结束
+    void onPlayPauseClicked();                      // 播放/暂停
+    void onSliderMoved(int value);                  // 拖动进度条
+    void onSliderReleased();                        // 松开进度条
+    void onSeekTimeout();                           // 拖动过程中的节流定位
+    void onOpenExternalClicked();                   // 使用系统播放器打开
+
+protected:
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    void updateTimeLabel(qint64 positionMs);        // 更新时间显示
+    static QString formatTime(qint64 ms);           // 毫秒转为 mm:ss
+
+    QString m_filePath;                 // 视频文件路径
+    MultiStreamDecoder* m_decoder;      // 文件回放解码器
+    QLabel* m_videoLabel;               // 视频画面
+    QPushButton* m_playPauseBtn;        // 播放/暂停按钮
+    QPushButton* m_externalBtn;         // 外部播放器按钮
+    QSlider* m_positionSlider;          // 进度条
+    QLabel* m_timeLabel;                // 时间显示
+    QTimer m_seekTimer;                 // 拖动定位节流定时器
+    QImage m_lastFrame;                 // 最近一帧，窗口缩放时重绘
+    qint64 m_durationMs;                // 视频时长
+    bool m_playing;                     // 是否正在播放
+    bool m_finished;                    // 是否已播放到末尾
+};
+
+#endif // VIDEOPLAYERDIALOG_H
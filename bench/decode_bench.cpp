@@ -0,0 +1,575 @@
+// 多路解码/显示基准测试
+//
+// 用 FFmpeg lavfi testsrc 生成不同编码和分辨率的测试片段，以本地文件（或推流到本机RTSP服务器）
+// 作为视频源，用 MultiStreamManager 同时接入 1…64 路，统计每路帧率、每路CPU、内存和
+// 解码到显示的延迟，结果以JSON输出，便于在热点路径的性能退化进入生产环境之前发现。
+//
+// 显示部分不创建窗口：帧接收者按网格布局把画面绘制到一张画布上，耗时计入绘制统计。
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QThread>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <QtMath>
+#include <algorithm>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "MultiStreamManager.h"
+#include "StreamSessionCache.h"
+#include "DecoderReaper.h"
+#include "StreamMetrics.h"
+
+extern "C" {
+#include <libavutil/avutil.h>
+}
+
+namespace {
+
+struct BenchConfig {
+    QStringList codecs;         // h264 / hevc
+    QList<QSize> resolutions;
+    QList<int> streamCounts;
+    int fps = 25;
+    int clipSeconds = 20;       // 测试片段时长，播完从头循环
+    int warmupSeconds = 3;      // 接入后先运行一段时间再开始统计
+    int durationSeconds = 10;   // 统计时长
+    QSize canvas = QSize(1920, 1080); // 模拟的视频墙尺寸
+    int tileFps = 15;           // 网格格子帧率上限（与界面默认一致）
+    QString workDir;
+    QString ffmpeg = "ffmpeg";
+    QString rtspBase;           // 非空时推流到该RTSP服务器，否则直接读取本地文件
+    QString rtspServerCommand;  // 可选：先启动本机RTSP服务器
+};
+
+struct ProcessUsage {
+    qint64 cpuUs = 0;           // 用户态加内核态CPU时间
+    qint64 rssBytes = 0;
+    qint64 peakRssBytes = 0;
+};
+
+ProcessUsage processUsage()
+{
+    ProcessUsage usage;
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.cpuUs = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL
+            + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+        usage.peakRssBytes = ru.ru_maxrss * 1024LL;     // Linux下单位为KB
+    }
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            usage.rssBytes = fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+    return usage;
+}
+
+// 运行事件循环一段时间（帧接收者和会话回收都在事件循环中执行）
+void spin(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// 等待条件成立，超时返回false
+template <typename Predicate>
+bool spinUntil(Predicate done, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        spin(50);
+    }
+    return true;
+}
+
+QString sizeText(const QSize& size)
+{
+    return QString("%1x%2").arg(size.width()).arg(size.height());
+}
+
+QSize parseSize(const QString& text)
+{
+    QStringList parts = text.trimmed().split('x');
+    if (parts.size() != 2) {
+        return QSize();
+    }
+    return QSize(parts[0].toInt(), parts[1].toInt());
+}
+
+double median(QVector<double> values)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    int mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+} // namespace
+
+/**
+ * @brief 基准测试流程：生成片段 -> 准备视频源 -> 逐个配置接入N路并采样 -> 输出JSON
+ */
+class DecodeBench
+{
+public:
+    explicit DecodeBench(const BenchConfig& config) : m_config(config) {}
+    ~DecodeBench() { stopPublishers(); stopServer(); }
+
+    bool prepare();             // 生成测试片段，按需启动RTSP服务器
+    QJsonObject run();          // 运行全部配置
+
+private:
+    QString clipPath(const QString& codec, const QSize& size) const;
+    bool generateClip(const QString& codec, const QSize& size);
+    QStringList prepareSources(const QString& codec, const QSize& size, int count);
+    QJsonObject runOne(const QString& codec, const QSize& size, int count);
+    void teardown(MultiStreamManager& manager);
+    void stopPublishers();
+    void stopServer();
+
+    BenchConfig m_config;
+    QList<QProcess*> m_publishers;  // RTSP推流进程
+    QProcess* m_server = nullptr;   // 本机RTSP服务器进程
+};
+
+QString DecodeBench::clipPath(const QString& codec, const QSize& size) const
+{
+    return QDir(m_config.workDir).filePath(QString("clips/%1_%2_%3fps_%4s.mp4")
+        .arg(codec, sizeText(size)).arg(m_config.fps).arg(m_config.clipSeconds));
+}
+
+bool DecodeBench::generateClip(const QString& codec, const QSize& size)
+{
+    QString path = clipPath(codec, size);
+    if (QFileInfo(path).size() > 0) {
+        return true;    // 已生成过，保证多次运行使用同一份输入
+    }
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // 固定GOP、无B帧，与常见摄像头的输出接近
+    QStringList args;
+    args << "-hide_banner" << "-loglevel" << "error" << "-y"
+         << "-f" << "lavfi"
+         << "-i" << QString("testsrc=size=%1:rate=%2").arg(sizeText(size)).arg(m_config.fps)
+         << "-t" << QString::number(m_config.clipSeconds)
+         << "-pix_fmt" << "yuv420p" << "-g" << QString::number(m_config.fps * 2) << "-bf" << "0";
+    if (codec == "hevc") {
+        args << "-c:v" << "libx265" << "-preset" << "veryfast" << "-x265-params" << "log-level=error"
+             << "-tag:v" << "hvc1";
+    } else {
+        args << "-c:v" << "libx264" << "-preset" << "veryfast";
+    }
+    args << path;
+
+    qInfo().noquote() << "生成测试片段" << path;
+    QProcess ffmpeg;
+    ffmpeg.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    ffmpeg.start(m_config.ffmpeg, args);
+    if (!ffmpeg.waitForStarted() || !ffmpeg.waitForFinished(-1)
+        || ffmpeg.exitStatus() != QProcess::NormalExit || ffmpeg.exitCode() != 0) {
+        qCritical().noquote() << "测试片段生成失败:" << path << ffmpeg.errorString();
+        QFile::remove(path);
+        return false;
+    }
+    return true;
+}
+
+bool DecodeBench::prepare()
+{
+    for (const QString& codec : m_config.codecs) {
+        for (const QSize& size : m_config.resolutions) {
+            if (!generateClip(codec, size)) {
+                return false;
+            }
+        }
+    }
+
+    if (!m_config.rtspServerCommand.isEmpty()) {
+        QStringList parts = m_config.rtspServerCommand.split(' ', Qt::SkipEmptyParts);
+        m_server = new QProcess();
+        m_server->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        m_server->start(parts.takeFirst(), parts);
+        if (!m_server->waitForStarted()) {
+            qCritical().noquote() << "RTSP服务器启动失败:" << m_config.rtspServerCommand;
+            return false;
+        }
+        spin(1000);     // 等待服务器开始监听
+    }
+    return true;
+}
+
+QStringList DecodeBench::prepareSources(const QString& codec, const QSize& size, int count)
+{
+    // 会话按地址共享，每一路都需要不同的地址才会各自解码
+    QStringList urls;
+    QString clip = clipPath(codec, size);
+    QString name = QString("%1_%2").arg(codec, sizeText(size));
+
+    if (m_config.rtspBase.isEmpty()) {
+        QDir linkDir(QDir(m_config.workDir).filePath("streams"));
+        linkDir.mkpath(".");
+        for (int i = 0; i < count; ++i) {
+            QString link = linkDir.filePath(QString("%1_%2.mp4").arg(name).arg(i));
+            QFile::remove(link);
+            if (!QFile::link(QFileInfo(clip).absoluteFilePath(), link)) {
+                QFile::copy(clip, link);
+            }
+            urls << link;
+        }
+        return urls;
+    }
+
+    // 推流：按原始节奏循环推送，不重新编码
+    QString base = m_config.rtspBase.endsWith('/') ? m_config.rtspBase : m_config.rtspBase + "/";
+    for (int i = 0; i < count; ++i) {
+        QString url = base + QString("%1_%2").arg(name).arg(i);
+        QProcess* publisher = new QProcess();
+        publisher->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        publisher->start(m_config.ffmpeg, QStringList()
+            << "-hide_banner" << "-loglevel" << "error" << "-re" << "-stream_loop" << "-1"
+            << "-i" << clip << "-c" << "copy" << "-f" << "rtsp" << "-rtsp_transport" << "tcp" << url);
+        m_publishers << publisher;
+        urls << url;
+    }
+    spin(2000);         // 等待推流建立
+    return urls;
+}
+
+QJsonObject DecodeBench::runOne(const QString& codec, const QSize& size, int count)
+{
+    qInfo().noquote() << QString("运行 %1 %2 x%3").arg(codec, sizeText(size)).arg(count);
+
+    // 与视频墙相同的网格布局：格子尺寸决定非焦点会话的输出尺寸
+    int columns = qCeil(qSqrt(count));
+    int rows = (count + columns - 1) / columns;
+    QSize tile(m_config.canvas.width() / columns, m_config.canvas.height() / rows);
+    StreamSessionCache* cache = StreamSessionCache::instance();
+    cache->setTileSize(count > 1 ? tile : QSize());
+    cache->setTileFrameRate(count > 1 ? m_config.tileFps : 0);
+
+    QImage canvas(m_config.canvas, QImage::Format_RGB32);
+    canvas.fill(Qt::black);
+    QStringList urls = prepareSources(codec, size, count);
+
+    MultiStreamManager manager;
+    QVector<StreamHandle> handles;
+    for (int i = 0; i < urls.size(); ++i) {
+        QRect target((i % columns) * tile.width(), (i / columns) * tile.height(), tile.width(), tile.height());
+        StreamHandle handle = manager.addStream(urls[i], [&manager, &canvas, target](StreamHandle h, const QImage& frame, const FrameTiming& timing) {
+            // 模拟格子绘制：等比缩放到格子内
+            qint64 startUs = StreamMetrics::nowUs();
+            {
+                QPainter painter(&canvas);
+                QSize fitted = frame.size().scaled(target.size(), Qt::KeepAspectRatio);
+                QRect rect(QPoint(0, 0), fitted);
+                rect.moveCenter(target.center());
+                painter.drawImage(rect, frame);
+            }
+            if (StreamMetrics* metrics = manager.getStreamMetrics(h)) {
+                metrics->recordRendered(StreamMetrics::nowUs() - startUs, timing.arrivalUs);
+            }
+        });
+        handles << handle;
+    }
+
+    // 文件播完后从头循环，统计期间不会因为片段结束而停止
+    QHash<QString, MultiStreamDecoder*> sessions = cache->sessions();
+    for (const QString& url : urls) {
+        MultiStreamDecoder* decoder = sessions.value(url);
+        if (decoder) {
+            QObject::connect(decoder, &MultiStreamDecoder::playbackFinished, decoder,
+                             [decoder]() { decoder->seekTo(0); }, Qt::QueuedConnection);
+        }
+    }
+
+    bool connected = spinUntil([&]() {
+        for (StreamHandle h : handles) {
+            if (!manager.isStreamConnected(h)) {
+                return false;
+            }
+        }
+        return true;
+    }, 15000);
+    if (!connected) {
+        qWarning() << "部分视频流在15秒内没有连接成功";
+    }
+    spin(m_config.warmupSeconds * 1000);
+
+    // 统计区间：前后各采样一次
+    QVector<StreamMetrics::Snapshot> before;
+    for (StreamHandle h : handles) {
+        StreamMetrics* metrics = manager.getStreamMetrics(h);
+        before << (metrics ? metrics->snapshot() : StreamMetrics::Snapshot());
+    }
+    ProcessUsage usageBefore = processUsage();
+    QElapsedTimer wall;
+    wall.start();
+
+    spin(m_config.durationSeconds * 1000);
+
+    ProcessUsage usageAfter = processUsage();
+    double wallSeconds = wall.elapsed() / 1000.0;
+
+    QJsonArray streams;
+    LatencyHistogram::Snapshot latency;
+    QVector<double> renderFps;
+    double totalDecodeFps = 0.0;
+    double totalRenderFps = 0.0;
+    qint64 totalDropped = 0;
+    for (int i = 0; i < handles.size(); ++i) {
+        StreamMetrics* metrics = manager.getStreamMetrics(handles[i]);
+        if (!metrics) {
+            continue;
+        }
+        StreamMetrics::Snapshot after = metrics->snapshot();
+        StreamMetrics::Report report = StreamMetrics::report(after, before[i]);
+        latency += after.latency - before[i].latency;
+        renderFps << report.renderFps;
+        totalDecodeFps += report.decodeFps;
+        totalRenderFps += report.renderFps;
+        totalDropped += report.dropped;
+
+        QJsonObject stream;
+        stream["index"] = i;
+        stream["url"] = urls[i];
+        stream["connected"] = manager.isStreamConnected(handles[i]);
+        stream["receiveFps"] = report.receiveFps;
+        stream["decodeFps"] = report.decodeFps;
+        stream["renderFps"] = report.renderFps;
+        stream["skippedFps"] = report.skippedFps;
+        stream["dropped"] = report.dropped;
+        stream["bitrateKbps"] = report.bitrateKbps;
+        stream["demuxMs"] = report.demuxMs;
+        stream["decodeMs"] = report.decodeMs;
+        stream["convertMs"] = report.convertMs;
+        stream["paintMs"] = report.paintMs;
+        stream["latencyP50Ms"] = report.latencyP50Ms;
+        stream["latencyP95Ms"] = report.latencyP95Ms;
+        stream["reconnects"] = after.reconnects - before[i].reconnects;
+        streams.append(stream);
+    }
+
+    double cpuPercent = (usageAfter.cpuUs - usageBefore.cpuUs) / 1e4 / wallSeconds;
+    QJsonObject process;
+    process["cpuPercent"] = cpuPercent;
+    process["cpuPercentPerStream"] = count > 0 ? cpuPercent / count : 0.0;
+    process["rssBytes"] = usageAfter.rssBytes;
+    process["peakRssBytes"] = usageAfter.peakRssBytes;
+
+    QJsonObject aggregate;
+    aggregate["decodeFps"] = totalDecodeFps;
+    aggregate["renderFps"] = totalRenderFps;
+    aggregate["renderFpsMedian"] = median(renderFps);
+    aggregate["renderFpsMin"] = renderFps.isEmpty() ? 0.0 : *std::min_element(renderFps.begin(), renderFps.end());
+    aggregate["dropped"] = totalDropped;
+    aggregate["latencyP50Ms"] = latency.percentileMs(0.5);
+    aggregate["latencyP95Ms"] = latency.percentileMs(0.95);
+    aggregate["latencyP99Ms"] = latency.percentileMs(0.99);
+
+    QJsonObject result;
+    result["codec"] = codec;
+    result["resolution"] = sizeText(size);
+    result["streams"] = count;
+    result["source"] = m_config.rtspBase.isEmpty() ? "file" : "rtsp";
+    result["tileSize"] = sizeText(count > 1 ? tile : size);
+    result["seconds"] = wallSeconds;
+    result["process"] = process;
+    result["aggregate"] = aggregate;
+    result["perStream"] = streams;
+
+    teardown(manager);
+    return result;
+}
+
+void DecodeBench::teardown(MultiStreamManager& manager)
+{
+    // 立即关闭会话并等待解码线程回收，下一组配置从干净的状态开始
+    StreamSessionCache* cache = StreamSessionCache::instance();
+    manager.removeAllStreams();
+    if (!spinUntil([cache]() { return cache->sessionCount() == 0
+                                      && DecoderReaper::instance()->pendingCount() == 0; }, 15000)) {
+        qWarning() << "解码线程回收超时";
+    }
+    stopPublishers();
+}
+
+void DecodeBench::stopPublishers()
+{
+    for (QProcess* publisher : m_publishers) {
+        publisher->terminate();
+        if (!publisher->waitForFinished(3000)) {
+            publisher->kill();
+            publisher->waitForFinished();
+        }
+        delete publisher;
+    }
+    m_publishers.clear();
+}
+
+void DecodeBench::stopServer()
+{
+    if (m_server) {
+        m_server->terminate();
+        if (!m_server->waitForFinished(3000)) {
+            m_server->kill();
+            m_server->waitForFinished();
+        }
+        delete m_server;
+        m_server = nullptr;
+    }
+}
+
+QJsonObject DecodeBench::run()
+{
+    StreamSessionCache::instance()->setLingerInterval(0);  // 测试之间不保留会话
+
+    QJsonArray runs;
+    for (const QString& codec : m_config.codecs) {
+        for (const QSize& size : m_config.resolutions) {
+            for (int count : m_config.streamCounts) {
+                runs.append(runOne(codec, size, count));
+            }
+        }
+    }
+
+    QJsonObject host;
+    host["cpus"] = QThread::idealThreadCount();
+    host["os"] = QSysInfo::prettyProductName();
+    host["kernel"] = QSysInfo::kernelVersion();
+    host["qt"] = qVersion();
+    host["ffmpeg"] = av_version_info();
+
+    QJsonObject config;
+    config["fps"] = m_config.fps;
+    config["warmupSeconds"] = m_config.warmupSeconds;
+    config["durationSeconds"] = m_config.durationSeconds;
+    config["canvas"] = sizeText(m_config.canvas);
+    config["tileFps"] = m_config.tileFps;
+
+    QJsonObject report;
+    report["benchmark"] = "decode_bench";
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["host"] = host;
+    report["config"] = config;
+    report["runs"] = runs;
+    return report;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("decode_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("多路解码/显示基准测试，结果以JSON输出");
+    parser.addHelpOption();
+    QCommandLineOption codecsOption("codecs", "编码格式列表（h264,hevc）", "list", "h264,hevc");
+    QCommandLineOption resOption("resolutions", "分辨率列表", "list", "640x360,1280x720,1920x1080");
+    QCommandLineOption streamsOption("streams", "同时接入的路数列表", "list", "1,4,16,64");
+    QCommandLineOption fpsOption("fps", "测试片段帧率", "fps", "25");
+    QCommandLineOption clipOption("clip-seconds", "测试片段时长（秒）", "seconds", "20");
+    QCommandLineOption warmupOption("warmup", "每组配置的预热时间（秒）", "seconds", "3");
+    QCommandLineOption durationOption("duration", "每组配置的统计时间（秒）", "seconds", "10");
+    QCommandLineOption canvasOption("canvas", "模拟的视频墙尺寸", "WxH", "1920x1080");
+    QCommandLineOption tileFpsOption("tile-fps", "网格格子帧率上限（只对RTSP源生效）", "fps", "15");
+    QCommandLineOption workOption("work-dir", "测试片段目录", "dir", QDir::temp().filePath("rtsp-bench"));
+    QCommandLineOption ffmpegOption("ffmpeg", "ffmpeg可执行文件", "path", "ffmpeg");
+    QCommandLineOption rtspOption("rtsp-base", "推流到该RTSP服务器地址（如rtsp://127.0.0.1:8554/bench），默认直接读文件", "url");
+    QCommandLineOption serverOption("rtsp-server-cmd", "先启动本机RTSP服务器的命令（如mediamtx）", "command");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "JSON结果文件，默认输出到标准输出", "file");
+    parser.addOptions({ codecsOption, resOption, streamsOption, fpsOption, clipOption, warmupOption,
+                        durationOption, canvasOption, tileFpsOption, workOption, ffmpegOption,
+                        rtspOption, serverOption, outputOption });
+    parser.process(app);
+
+    BenchConfig config;
+    config.codecs = parser.value(codecsOption).split(',', Qt::SkipEmptyParts);
+    for (const QString& text : parser.value(resOption).split(',', Qt::SkipEmptyParts)) {
+        QSize size = parseSize(text);
+        if (size.isEmpty()) {
+            qCritical().noquote() << "无效的分辨率:" << text;
+            return 1;
+        }
+        config.resolutions << size;
+    }
+    for (const QString& text : parser.value(streamsOption).split(',', Qt::SkipEmptyParts)) {
+        int count = text.toInt();
+        if (count <= 0) {
+            qCritical().noquote() << "无效的路数:" << text;
+            return 1;
+        }
+        config.streamCounts << count;
+    }
+    for (const QString& codec : config.codecs) {
+        if (codec != "h264" && codec != "hevc") {
+            qCritical().noquote() << "不支持的编码格式:" << codec;
+            return 1;
+        }
+    }
+    config.fps = qMax(1, parser.value(fpsOption).toInt());
+    config.clipSeconds = qMax(1, parser.value(clipOption).toInt());
+    config.warmupSeconds = qMax(0, parser.value(warmupOption).toInt());
+    config.durationSeconds = qMax(1, parser.value(durationOption).toInt());
+    config.canvas = parseSize(parser.value(canvasOption));
+    config.tileFps = qMax(0, parser.value(tileFpsOption).toInt());
+    config.workDir = parser.value(workOption);
+    config.ffmpeg = parser.value(ffmpegOption);
+    config.rtspBase = parser.value(rtspOption);
+    config.rtspServerCommand = parser.value(serverOption);
+    if (config.canvas.isEmpty()) {
+        qCritical().noquote() << "无效的画布尺寸:" << parser.value(canvasOption);
+        return 1;
+    }
+
+    QJsonObject report;
+    {
+        DecodeBench bench(config);
+        if (!bench.prepare()) {
+            return 1;
+        }
+        report = bench.run();
+    }
+
+    StreamSessionCache::instance()->closeAll();
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    QString outputPath = parser.value(outputOption);
+    if (outputPath.isEmpty()) {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(json);
+    } else {
+        QFile out(outputPath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical().noquote() << "无法写入结果文件:" << outputPath;
+            return 1;
+        }
+        out.write(json);
+        qInfo().noquote() << "结果已写入" << outputPath;
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+# 多路解码/显示基准测试：只包含核心库，在 QCoreApplication 下运行
+QT       -= widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = decode_bench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../rtsp_core.pri)
+
+SOURCES += \
+    decode_bench.cpp
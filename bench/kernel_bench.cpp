@@ -0,0 +1,700 @@
+// 颜色转换和缩放内核的微基准测试
+//
+// 每帧的主要开销在几个内核上：解码器中 sws_scale 转 RGB24（convertFrameToImage）、
+// 视频墙中 QImage::scaled(Qt::SmoothTransformation)、录像中的 QImage -> BGR 转换。
+// 这里按分辨率、像素格式（RGB24 / RGB32 / ARGB32_Premultiplied）、缩放算法
+// （BILINEAR / FAST_BILINEAR / AREA / POINT）和实现（swscale / Qt / OpenCV）分别测量，
+// 默认参数的选择以数据为依据。
+//
+// 运行方式与 Google Benchmark 相同：每个用例先自动确定迭代次数（至少运行 --min-time 秒），
+// 再重复 --repetitions 次取平均值/中位数/标准差；--json 输出的字段与 Google Benchmark 一致，
+// 可以直接用它的 compare.py 对比两次结果。不引入额外依赖。
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QRegularExpression>
+#include <QImage>
+#include <QFile>
+#include <QDateTime>
+#include <QThread>
+#include <QSysInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+
+#include <opencv2/opencv.hpp>
+
+#include "TileScaler.h"
+#include "FrameBufferPool.h"
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+// 防止编译器把没有使用结果的计算优化掉
+inline void doNotOptimize(const void* p)
+{
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+qint64 nowNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct BenchCase {
+    QString name;
+    qint64 pixels;                  // 每次迭代处理的输出像素数，用于计算吞吐量
+    std::function<void()> body;
+};
+
+struct RunStats {
+    qint64 iterations = 0;
+    QVector<double> realNs;         // 每次重复的单次迭代耗时
+    QVector<double> cpuNs;
+};
+
+/**
+ * @brief 极简的基准测试运行器（接口和输出格式参照 Google Benchmark）
+ */
+class Runner
+{
+public:
+    Runner(double minTime, int repetitions) : m_minTime(minTime), m_repetitions(repetitions) {}
+
+    void add(const QString& name, qint64 pixels, std::function<void()> body)
+    {
+        m_cases.append({ name, pixels, body });
+    }
+
+    int run(const QRegularExpression& filter, QJsonArray* json);
+
+    QStringList names(const QRegularExpression& filter) const
+    {
+        QStringList result;
+        for (const BenchCase& c : m_cases) {
+            if (filter.match(c.name).hasMatch()) {
+                result << c.name;
+            }
+        }
+        return result;
+    }
+
+private:
+    RunStats measure(const BenchCase& c);
+
+    QList<BenchCase> m_cases;
+    double m_minTime;
+    int m_repetitions;
+};
+
+RunStats Runner::measure(const BenchCase& c)
+{
+    RunStats stats;
+
+    // 预热一次，并按耗时确定迭代次数（与 Google Benchmark 相同，每次最多放大10倍）
+    c.body();
+    qint64 iterations = 1;
+    while (true) {
+        qint64 start = nowNs(CLOCK_MONOTONIC);
+        for (qint64 i = 0; i < iterations; ++i) {
+            c.body();
+        }
+        double elapsed = (nowNs(CLOCK_MONOTONIC) - start) / 1e9;
+        if (elapsed >= m_minTime || iterations >= 1000000000LL) {
+            break;
+        }
+        double multiplier = elapsed > 0 ? m_minTime * 1.4 / elapsed : 10.0;
+        iterations = static_cast<qint64>(iterations * qBound(2.0, multiplier, 10.0));
+    }
+    stats.iterations = iterations;
+
+    for (int r = 0; r < m_repetitions; ++r) {
+        qint64 realStart = nowNs(CLOCK_MONOTONIC);
+        qint64 cpuStart = nowNs(CLOCK_THREAD_CPUTIME_ID);
+        for (qint64 i = 0; i < iterations; ++i) {
+            c.body();
+        }
+        stats.cpuNs.append(double(nowNs(CLOCK_THREAD_CPUTIME_ID) - cpuStart) / iterations);
+        stats.realNs.append(double(nowNs(CLOCK_MONOTONIC) - realStart) / iterations);
+    }
+    return stats;
+}
+
+double mean(const QVector<double>& v)
+{
+    double sum = 0;
+    for (double x : v) {
+        sum += x;
+    }
+    return v.isEmpty() ? 0.0 : sum / v.size();
+}
+
+double medianOf(QVector<double> v)
+{
+    if (v.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(v.begin(), v.end());
+    int mid = v.size() / 2;
+    return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2.0;
+}
+
+double stddev(const QVector<double>& v)
+{
+    if (v.size() < 2) {
+        return 0.0;
+    }
+    double m = mean(v);
+    double sum = 0;
+    for (double x : v) {
+        sum += (x - m) * (x - m);
+    }
+    return std::sqrt(sum / (v.size() - 1));
+}
+
+int Runner::run(const QRegularExpression& filter, QJsonArray* json)
+{
+    printf("%-72s %14s %14s %10s %12s\n", "Benchmark", "Time(ns)", "CPU(ns)", "CV", "Mpix/s");
+    printf("%s\n", QByteArray(126, '-').constData());
+
+    int count = 0;
+    for (const BenchCase& c : m_cases) {
+        if (!filter.match(c.name).hasMatch()) {
+            continue;
+        }
+        ++count;
+        RunStats stats = measure(c);
+
+        struct Aggregate { const char* name; double real; double cpu; };
+        Aggregate aggregates[] = {
+            { "mean", mean(stats.realNs), mean(stats.cpuNs) },
+            { "median", medianOf(stats.realNs), medianOf(stats.cpuNs) },
+            { "stddev", stddev(stats.realNs), stddev(stats.cpuNs) },
+        };
+        double cv = aggregates[0].real > 0 ? aggregates[2].real / aggregates[0].real : 0.0;
+        double mpix = aggregates[1].real > 0 ? c.pixels / aggregates[1].real * 1e3 : 0.0;
+        printf("%-72s %14.0f %14.0f %9.1f%% %12.1f\n", c.name.toUtf8().constData(),
+               aggregates[1].real, aggregates[1].cpu, cv * 100, mpix);
+        fflush(stdout);
+
+        if (!json) {
+            continue;
+        }
+        for (int r = 0; r < stats.realNs.size(); ++r) {
+            QJsonObject item;
+            item["name"] = c.name;
+            item["run_name"] = c.name;
+            item["run_type"] = "iteration";
+            item["repetitions"] = stats.realNs.size();
+            item["repetition_index"] = r;
+            item["iterations"] = stats.iterations;
+            item["real_time"] = stats.realNs[r];
+            item["cpu_time"] = stats.cpuNs[r];
+            item["time_unit"] = "ns";
+            item["items_per_second"] = stats.realNs[r] > 0 ? c.pixels / stats.realNs[r] * 1e9 : 0.0;
+            json->append(item);
+        }
+        for (const Aggregate& a : aggregates) {
+            QJsonObject item;
+            item["name"] = c.name + "_" + a.name;
+            item["run_name"] = c.name;
+            item["run_type"] = "aggregate";
+            item["repetitions"] = stats.realNs.size();
+            item["aggregate_name"] = a.name;
+            item["iterations"] = stats.realNs.size();
+            item["real_time"] = a.real;
+            item["cpu_time"] = a.cpu;
+            item["time_unit"] = "ns";
+            json->append(item);
+        }
+    }
+    return count;
+}
+
+// ---------------- 测试数据 ----------------
+
+QString sizeText(const QSize& size)
+{
+    return QString("%1x%2").arg(size.width()).arg(size.height());
+}
+
+QSize parseSize(const QString& text)
+{
+    QStringList parts = text.trimmed().split('x');
+    return parts.size() == 2 ? QSize(parts[0].toInt(), parts[1].toInt()) : QSize();
+}
+
+// 解码器输出的YUV帧：渐变加棋盘格，避免全同像素让缩放走捷径
+AVFrame* makeYuvFrame(const QSize& size, AVPixelFormat format)
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->width = size.width();
+    frame->height = size.height();
+    frame->format = format;
+    if (av_frame_get_buffer(frame, 32) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    for (int y = 0; y < size.height(); ++y) {
+        uint8_t* row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < size.width(); ++x) {
+            row[x] = static_cast<uint8_t>((x + y) ^ ((x >> 4) & (y >> 4) ? 0x40 : 0));
+        }
+    }
+    int chromaHeight = (size.height() + 1) / 2;
+    if (format == AV_PIX_FMT_NV12) {
+        for (int y = 0; y < chromaHeight; ++y) {
+            uint8_t* row = frame->data[1] + y * frame->linesize[1];
+            for (int x = 0; x < size.width(); ++x) {
+                row[x] = static_cast<uint8_t>(x * 3 + y);
+            }
+        }
+    } else {
+        int chromaWidth = (size.width() + 1) / 2;
+        for (int plane = 1; plane <= 2; ++plane) {
+            for (int y = 0; y < chromaHeight; ++y) {
+                uint8_t* row = frame->data[plane] + y * frame->linesize[plane];
+                for (int x = 0; x < chromaWidth; ++x) {
+                    row[x] = static_cast<uint8_t>(plane == 1 ? x * 2 + y : 255 - x - y);
+                }
+            }
+        }
+    }
+    return frame;
+}
+
+// 转换后的RGB画面（由YUV帧转换得到，内容与实际解码输出一致）
+QImage makeImage(AVFrame* frame, QImage::Format format)
+{
+    QImage image(frame->width, frame->height, QImage::Format_RGB888);
+    SwsContext* sws = sws_getContext(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                     frame->width, frame->height, AV_PIX_FMT_RGB24,
+                                     SWS_BILINEAR, nullptr, nullptr, nullptr);
+    uint8_t* dest[4] = { image.bits(), nullptr, nullptr, nullptr };
+    int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+    sws_scale(sws, frame->data, frame->linesize, 0, frame->height, dest, destLinesize);
+    sws_freeContext(sws);
+    return image.convertToFormat(format);
+}
+
+struct SwsTarget {
+    const char* name;
+    AVPixelFormat pixFmt;
+    QImage::Format imageFormat;     // 对应的QImage格式（AV_PIX_FMT_RGB32与QImage::Format_RGB32内存布局相同）
+    bool aligned;                   // 行宽按32字节对齐（与解码器的 allocateFrameImage 相同）
+};
+
+// 与 MultiStreamDecoder::allocateFrameImage 相同的分配方式（帧缓冲池，行宽32字节对齐）
+QImage allocateAligned(const QSize& size, QImage::Format format)
+{
+    return FrameBufferPool::instance()->acquireImage(size, format);
+}
+
+struct SwsFlag {
+    const char* name;
+    int flags;
+};
+
+// 帧数据在整个进程生命周期内有效，释放交给操作系统
+QList<AVFrame*> s_frames;
+
+QList<TileScaler::Isa> supportedIsas()
+{
+    QList<TileScaler::Isa> isas;
+    for (TileScaler::Isa isa : { TileScaler::Scalar, TileScaler::Sse41, TileScaler::Avx2 }) {
+        if (TileScaler::isSupported(isa)) {
+            isas << isa;
+        }
+    }
+    return isas;
+}
+
+// 检查 TileScaler：各SIMD版本与标量版本逐位一致，与 swscale（SWS_AREA）的差异在舍入误差范围内
+bool verifyTileScaler(const QList<QSize>& resolutions)
+{
+    const int maxDiffLimit = 10;        // 单个通道最大差值
+    const double psnrLimit = 38.0;      // 整幅画面的PSNR下限（dB）
+    bool allPassed = true;
+
+    printf("%-36s %-8s %6s %8s %10s %s\n", "Case", "Isa", "Exact", "MaxDiff", "PSNR(dB)", "Result");
+    for (const QSize& size : resolutions) {
+        for (AVPixelFormat format : { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUVJ420P }) {
+            AVFrame* frame = makeYuvFrame(size, format);
+            if (!frame) {
+                continue;
+            }
+            s_frames << frame;
+            for (int factor = 2; factor <= 8; factor *= 2) {
+                QSize outSize(size.width() / factor, size.height() / factor);
+                if (outSize.isEmpty()) {
+                    continue;
+                }
+                QImage reference = allocateAligned(outSize, QImage::Format_RGB32);
+                SwsContext* sws = sws_getContext(size.width(), size.height(), format,
+                                                 outSize.width(), outSize.height(), AV_PIX_FMT_RGB32,
+                                                 SWS_AREA, nullptr, nullptr, nullptr);
+                if (!sws) {
+                    continue;
+                }
+                uint8_t* dest[4] = { reference.bits(), nullptr, nullptr, nullptr };
+                int destLinesize[4] = { reference.bytesPerLine(), 0, 0, 0 };
+                sws_scale(sws, frame->data, frame->linesize, 0, frame->height, dest, destLinesize);
+                sws_freeContext(sws);
+
+                QImage scalar;
+                for (TileScaler::Isa isa : supportedIsas()) {
+                    TileScaler scaler;
+                    scaler.setIsa(isa);
+                    QImage image = allocateAligned(outSize, QImage::Format_RGB32);
+                    scaler.scale(frame, factor, image.bits(), image.bytesPerLine());
+                    if (isa == TileScaler::Scalar) {
+                        scalar = image;
+                    }
+
+                    bool exact = true;
+                    int maxDiff = 0;
+                    double squared = 0;
+                    for (int y = 0; y < outSize.height(); ++y) {
+                        const uchar* a = image.constScanLine(y);
+                        const uchar* b = reference.constScanLine(y);
+                        exact = exact && memcmp(a, scalar.constScanLine(y), outSize.width() * 4) == 0;
+                        for (int x = 0; x < outSize.width() * 4; ++x) {
+                            if (x % 4 == 3) {
+                                continue;   // Alpha
+                            }
+                            int diff = qAbs(int(a[x]) - int(b[x]));
+                            maxDiff = qMax(maxDiff, diff);
+                            squared += diff * diff;
+                        }
+                    }
+                    double mse = squared / (qint64(outSize.width()) * outSize.height() * 3);
+                    double psnr = mse > 0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+                    bool passed = exact && maxDiff <= maxDiffLimit && psnr >= psnrLimit;
+                    allPassed = allPassed && passed;
+
+                    QString name = QString("%1/%2->%3").arg(av_get_pix_fmt_name(format))
+                        .arg(sizeText(size), sizeText(outSize));
+                    printf("%-36s %-8s %6s %8d %10.1f %s\n", name.toUtf8().constData(),
+                           TileScaler::isaName(isa), exact ? "yes" : "no", maxDiff, psnr, passed ? "OK" : "FAIL");
+                }
+            }
+        }
+    }
+    return allPassed;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("kernel_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("颜色转换和缩放内核的微基准测试");
+    parser.addHelpOption();
+    QCommandLineOption filterOption("filter", "只运行名称匹配该正则表达式的用例", "regex", ".*");
+    QCommandLineOption resOption("resolutions", "源分辨率列表", "list", "1280x720,1920x1080,3840x2160");
+    QCommandLineOption tileOption("tile", "网格格子尺寸（缩放目标）", "WxH", "480x270");
+    QCommandLineOption minTimeOption("min-time", "每次重复的最短运行时间（秒）", "seconds", "0.2");
+    QCommandLineOption repOption("repetitions", "重复次数", "count", "5");
+    QCommandLineOption jsonOption("json", "结果以Google Benchmark的JSON格式写入文件", "file");
+    QCommandLineOption listOption("list", "只列出用例名称");
+    QCommandLineOption verifyOption("verify", "只检查 TileScaler 的输出（与标量版本和 swscale 对比）");
+    parser.addOptions({ filterOption, resOption, tileOption, minTimeOption, repOption, jsonOption, listOption,
+                        verifyOption });
+    parser.process(app);
+
+    QRegularExpression filter(parser.value(filterOption));
+    if (!filter.isValid()) {
+        qCritical().noquote() << "无效的正则表达式:" << parser.value(filterOption);
+        return 1;
+    }
+    QSize tile = parseSize(parser.value(tileOption));
+    QList<QSize> resolutions;
+    for (const QString& text : parser.value(resOption).split(',', Qt::SkipEmptyParts)) {
+        QSize size = parseSize(text);
+        if (size.isEmpty()) {
+            qCritical().noquote() << "无效的分辨率:" << text;
+            return 1;
+        }
+        resolutions << size;
+    }
+    if (tile.isEmpty()) {
+        qCritical().noquote() << "无效的格子尺寸:" << parser.value(tileOption);
+        return 1;
+    }
+
+    if (parser.isSet(verifyOption)) {
+        return verifyTileScaler(resolutions) ? 0 : 1;
+    }
+
+    Runner runner(qMax(0.01, parser.value(minTimeOption).toDouble()), qMax(1, parser.value(repOption).toInt()));
+
+    const SwsTarget swsTargets[] = {
+        { "rgb24", AV_PIX_FMT_RGB24, QImage::Format_RGB888, false },
+        { "rgb32", AV_PIX_FMT_RGB32, QImage::Format_RGB32, false },
+        { "rgb32_align32", AV_PIX_FMT_RGB32, QImage::Format_RGB32, true },
+        { "argb32pm", AV_PIX_FMT_RGB32, QImage::Format_ARGB32_Premultiplied, false },
+    };
+    const SwsFlag swsFlags[] = {
+        { "point", SWS_POINT },
+        { "fast_bilinear", SWS_FAST_BILINEAR },
+        { "bilinear", SWS_BILINEAR },
+        { "area", SWS_AREA },
+        { "bicubic", SWS_BICUBIC },
+    };
+    const AVPixelFormat sources[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12 };
+    const QImage::Format qtFormats[] = { QImage::Format_RGB888, QImage::Format_RGB32,
+                                         QImage::Format_ARGB32_Premultiplied };
+    auto qtFormatName = [](QImage::Format format) -> QString {
+        switch (format) {
+        case QImage::Format_RGB888: return "rgb24";
+        case QImage::Format_RGB32: return "rgb32";
+        case QImage::Format_ARGB32_Premultiplied: return "argb32pm";
+        default: return QString::number(format);
+        }
+    };
+
+    for (const QSize& size : resolutions) {
+        QSize tileFit = size.scaled(tile, Qt::KeepAspectRatio);
+
+        // 1. 解码器：YUV -> RGB（原尺寸 / 缩放到格子），与 convertFrameToImage 相同，每帧新建QImage
+        for (AVPixelFormat source : sources) {
+            AVFrame* frame = makeYuvFrame(size, source);
+            if (!frame) {
+                continue;
+            }
+            s_frames << frame;
+            for (const QSize& outSize : { size, tileFit }) {
+                for (const SwsTarget& target : swsTargets) {
+                    for (const SwsFlag& flag : swsFlags) {
+                        if (outSize == size && flag.flags != SWS_BILINEAR && flag.flags != SWS_FAST_BILINEAR) {
+                            continue;   // 不缩放时算法只影响色度插值，只保留两种
+                        }
+                        SwsContext* sws = sws_getContext(size.width(), size.height(), source,
+                                                         outSize.width(), outSize.height(), target.pixFmt,
+                                                         flag.flags, nullptr, nullptr, nullptr);
+                        if (!sws) {
+                            continue;
+                        }
+                        QString name = QString("sws/%1/%2->%3/%4/%5").arg(av_get_pix_fmt_name(source))
+                            .arg(sizeText(size), sizeText(outSize), target.name, flag.name);
+                        QImage::Format imageFormat = target.imageFormat;
+                        bool aligned = target.aligned;
+                        runner.add(name, qint64(outSize.width()) * outSize.height(),
+                                   [sws, frame, outSize, imageFormat, aligned]() {
+                            QImage image = aligned ? allocateAligned(outSize, imageFormat)
+                                                   : QImage(outSize, imageFormat);
+                            uint8_t* dest[4] = { image.bits(), nullptr, nullptr, nullptr };
+                            int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+                            sws_scale(sws, frame->data, frame->linesize, 0, frame->height, dest, destLinesize);
+                            doNotOptimize(image.constBits());
+                        });
+                    }
+                }
+            }
+        }
+
+        AVFrame* yuv = makeYuvFrame(size, AV_PIX_FMT_YUV420P);
+        if (!yuv) {
+            continue;
+        }
+        s_frames << yuv;
+
+        // 2. 格子画面：TileScaler（转换+整数倍缩小）对比 swscale 直接缩小、swscale 原尺寸转换 + QImage::scaled
+        for (int factor = 2; factor <= 8; factor *= 2) {
+            QSize boxSize(size.width() / factor, size.height() / factor);
+            QString prefix = QString("tile/yuv420p/%1->%2/").arg(sizeText(size), sizeText(boxSize));
+            qint64 pixels = qint64(boxSize.width()) * boxSize.height();
+            for (TileScaler::Isa isa : supportedIsas()) {
+                std::shared_ptr<TileScaler> scaler(new TileScaler());
+                scaler->setIsa(isa);
+                runner.add(prefix + "tilescaler_" + TileScaler::isaName(isa), pixels, [scaler, yuv, factor, boxSize]() {
+                    QImage image = allocateAligned(boxSize, QImage::Format_RGB32);
+                    scaler->scale(yuv, factor, image.bits(), image.bytesPerLine());
+                    doNotOptimize(image.constBits());
+                });
+            }
+            SwsContext* area = sws_getContext(size.width(), size.height(), AV_PIX_FMT_YUV420P,
+                                              boxSize.width(), boxSize.height(), AV_PIX_FMT_RGB32,
+                                              SWS_AREA, nullptr, nullptr, nullptr);
+            if (area) {
+                runner.add(prefix + "sws_area", pixels, [area, yuv, boxSize]() {
+                    QImage image = allocateAligned(boxSize, QImage::Format_RGB32);
+                    uint8_t* dest[4] = { image.bits(), nullptr, nullptr, nullptr };
+                    int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+                    sws_scale(area, yuv->data, yuv->linesize, 0, yuv->height, dest, destLinesize);
+                    doNotOptimize(image.constBits());
+                });
+            }
+            SwsContext* full = sws_getContext(size.width(), size.height(), AV_PIX_FMT_YUV420P,
+                                              size.width(), size.height(), AV_PIX_FMT_RGB32,
+                                              SWS_BILINEAR, nullptr, nullptr, nullptr);
+            if (full) {
+                QSize fullSize = size;
+                runner.add(prefix + "sws_rgb32+qt_smooth", pixels, [full, yuv, fullSize, boxSize]() {
+                    QImage image = allocateAligned(fullSize, QImage::Format_RGB32);
+                    uint8_t* dest[4] = { image.bits(), nullptr, nullptr, nullptr };
+                    int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+                    sws_scale(full, yuv->data, yuv->linesize, 0, yuv->height, dest, destLinesize);
+                    QImage scaled = image.scaled(boxSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                    doNotOptimize(scaled.constBits());
+                });
+            }
+        }
+
+        // 解码器实际走的格子路径：整数倍缩小后在小图上完成剩余缩放（对比上面的 sws/.../bilinear）
+        int tileFactor = TileScaler::factorFor(AV_PIX_FMT_YUV420P, size, tileFit);
+        if (tileFactor > 0) {
+            std::shared_ptr<TileScaler> scaler(new TileScaler());
+            QSize boxSize(size.width() / tileFactor, size.height() / tileFactor);
+            runner.add(QString("tile/yuv420p/%1->%2/tilescaler+qt_residual").arg(sizeText(size), sizeText(tileFit)),
+                       qint64(tileFit.width()) * tileFit.height(), [scaler, yuv, tileFactor, boxSize, tileFit]() {
+                QImage image = allocateAligned(boxSize, QImage::Format_RGB32);
+                scaler->scale(yuv, tileFactor, image.bits(), image.bytesPerLine());
+                QImage scaled = boxSize == tileFit
+                    ? image : image.scaled(tileFit, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                doNotOptimize(scaled.constBits());
+            });
+        }
+
+        for (QImage::Format format : qtFormats) {
+            QImage source = makeImage(yuv, format);
+            QString fmt = qtFormatName(format);
+
+            // 3. 视频墙：QImage::scaled 到格子大小
+            runner.add(QString("qt_scaled/%1/%2->%3/smooth").arg(fmt, sizeText(size), sizeText(tileFit)),
+                       qint64(tileFit.width()) * tileFit.height(), [source, tile]() {
+                QImage scaled = source.scaled(tile, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+                doNotOptimize(scaled.constBits());
+            });
+            runner.add(QString("qt_scaled/%1/%2->%3/fast").arg(fmt, sizeText(size), sizeText(tileFit)),
+                       qint64(tileFit.width()) * tileFit.height(), [source, tile]() {
+                QImage scaled = source.scaled(tile, Qt::KeepAspectRatio, Qt::FastTransformation);
+                doNotOptimize(scaled.constBits());
+            });
+
+            // 4. 显示：QPixmap::fromImage / 绘制前转换为预乘ARGB32（相同格式时无需转换）
+            if (format != QImage::Format_ARGB32_Premultiplied) {
+                runner.add(QString("qt_convert/%1->argb32pm/%2").arg(fmt, sizeText(size)),
+                           qint64(size.width()) * size.height(), [source]() {
+                    QImage converted = source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+                    doNotOptimize(converted.constBits());
+                });
+            }
+        }
+
+        // 5. 录像：画面 -> OpenCV BGR
+        QImage rgb888 = makeImage(yuv, QImage::Format_RGB888);
+        QImage rgb32 = makeImage(yuv, QImage::Format_RGB32);
+        qint64 pixels = qint64(size.width()) * size.height();
+        runner.add(QString("record/%1/rgbswapped+cvtcolor").arg(sizeText(size)), pixels, [rgb888]() {
+            // 原 Controller::writeVideoFrame 的做法
+            QImage swapped = rgb888.rgbSwapped();
+            cv::Mat mat(swapped.height(), swapped.width(), CV_8UC3,
+                        const_cast<uchar*>(swapped.constBits()), swapped.bytesPerLine());
+            cv::Mat bgr;
+            cv::cvtColor(mat, bgr, cv::COLOR_RGB2BGR);
+            doNotOptimize(bgr.data);
+        });
+        runner.add(QString("record/%1/rgb24+cvtcolor").arg(sizeText(size)), pixels, [rgb888]() {
+            cv::Mat mat(rgb888.height(), rgb888.width(), CV_8UC3,
+                        const_cast<uchar*>(rgb888.constBits()), rgb888.bytesPerLine());
+            cv::Mat bgr;
+            cv::cvtColor(mat, bgr, cv::COLOR_RGB2BGR);
+            doNotOptimize(bgr.data);
+        });
+        runner.add(QString("record/%1/rgb32+cvtcolor").arg(sizeText(size)), pixels, [rgb32]() {
+            cv::Mat mat(rgb32.height(), rgb32.width(), CV_8UC4,
+                        const_cast<uchar*>(rgb32.constBits()), rgb32.bytesPerLine());
+            cv::Mat bgr;
+            cv::cvtColor(mat, bgr, cv::COLOR_BGRA2BGR);
+            doNotOptimize(bgr.data);
+        });
+        SwsContext* toBgr = sws_getContext(size.width(), size.height(), AV_PIX_FMT_YUV420P,
+                                           size.width(), size.height(), AV_PIX_FMT_BGR24,
+                                           SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (toBgr) {
+            runner.add(QString("record/%1/sws_yuv->bgr24").arg(sizeText(size)), pixels, [toBgr, yuv]() {
+                cv::Mat bgr(yuv->height, yuv->width, CV_8UC3);
+                uint8_t* dest[4] = { bgr.data, nullptr, nullptr, nullptr };
+                int destLinesize[4] = { static_cast<int>(bgr.step), 0, 0, 0 };
+                sws_scale(toBgr, yuv->data, yuv->linesize, 0, yuv->height, dest, destLinesize);
+                doNotOptimize(bgr.data);
+            });
+        }
+        runner.add(QString("record/%1/cv_yuv420p->bgr").arg(sizeText(size)), pixels, [yuv]() {
+            // OpenCV 要求 I420 三个平面连续存放，先拷贝成一块
+            int w = yuv->width;
+            int h = yuv->height;
+            cv::Mat i420(h * 3 / 2, w, CV_8UC1);
+            for (int y = 0; y < h; ++y) {
+                memcpy(i420.ptr(y), yuv->data[0] + y * yuv->linesize[0], w);
+            }
+            uchar* u = i420.ptr(h);
+            uchar* v = u + (w / 2) * (h / 2);
+            for (int y = 0; y < h / 2; ++y) {
+                memcpy(u + y * (w / 2), yuv->data[1] + y * yuv->linesize[1], w / 2);
+                memcpy(v + y * (w / 2), yuv->data[2] + y * yuv->linesize[2], w / 2);
+            }
+            cv::Mat bgr;
+            cv::cvtColor(i420, bgr, cv::COLOR_YUV2BGR_I420);
+            doNotOptimize(bgr.data);
+        });
+    }
+
+    if (parser.isSet(listOption)) {
+        for (const QString& name : runner.names(filter)) {
+            printf("%s\n", name.toUtf8().constData());
+        }
+        return 0;
+    }
+
+    QJsonArray benchmarks;
+    bool wantJson = parser.isSet(jsonOption);
+    int count = runner.run(filter, wantJson ? &benchmarks : nullptr);
+    if (count == 0) {
+        qWarning() << "没有匹配的用例";
+    }
+
+    if (wantJson) {
+        QJsonObject context;
+        context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        context["host_name"] = QSysInfo::machineHostName();
+        context["executable"] = QCoreApplication::applicationFilePath();
+        context["num_cpus"] = QThread::idealThreadCount();
+        context["library_build_type"] = "release";
+        context["ffmpeg"] = av_version_info();
+        context["swscale"] = LIBSWSCALE_IDENT;
+        context["opencv"] = CV_VERSION;
+        context["qt"] = qVersion();
+
+        QJsonObject root;
+        root["context"] = context;
+        root["benchmarks"] = benchmarks;
+        QFile out(parser.value(jsonOption));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical().noquote() << "无法写入结果文件:" << parser.value(jsonOption);
+            return 1;
+        }
+        out.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+# 颜色转换/缩放内核微基准测试：只包含核心库，在 QCoreApplication 下运行
+QT       -= widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = kernel_bench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../rtsp_core.pri)
+
+SOURCES += \
+    kernel_bench.cpp
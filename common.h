@@ -1,5 +1,6 @@
 #pragma once
 #include <QRect>
+#include <QString>
 
 // 通用数据结构定义
 struct RectangleBox {
@@ -31,3 +32,15 @@ struct NormalizedRectangleBox {
     NormalizedRectangleBox() : x(0), y(0), width(0), height(0) {}
     NormalizedRectangleBox(float x, float y, float w, float h) : x(x), y(y), width(w), height(h) {}
 }; 
+
+// 检测目标结构体（对应DETECTIONS消息中的单个对象）
+struct DetectionObject {
+    int classId;        // 类别ID
+    QString className;  // 类别名称
+    int x;              // 左上角x坐标
+    int y;              // 左上角y坐标
+    int width;          // 宽度
+    int height;         // 高度
+    float confidence;   // 置信度 (0~1)
+    DetectionObject() : classId(-1), x(0), y(0), width(0), height(0), confidence(0) {}
+};
@@ -6,10 +6,15 @@
 #include <QDir>
 #include <QDateTime>
 #include <QCoreApplication>
+#include <QUrl>
+#include <QMap>
+#include <QtMath>
 #include "Picture.h"
 #include "Tcpserver.h" // Added for Tcpserver
 #include "plan.h"      // Added for Plan and PlanData
 #include "common.h"
+#include "StreamSessionCache.h"
+#include "FrameMemoryBudget.h"
 Controller::Controller(Model* model, View* view, QObject* parent)
     : QObject(parent), m_model(model), m_view(view)
 {
@@ -41,21 +46,58 @@ Controller::Controller(Model* model, View* view, QObject* parent)
     if (tcpWin) {
         connect(tcpWin, &Tcpserver::tcpClientConnected, this, &Controller::onTcpClientConnected);
         connect(tcpWin, &Tcpserver::detectionDataReceived, this, &Controller::onDetectionDataReceived);
+        connect(tcpWin, &Tcpserver::detectionObjectsReceived, this, &Controller::onDetectionObjectsReceived);
     }
     
+    // 打开事件数据库，报警和检测事件在后台线程中批量写入
+    m_eventStore = new EventStore(this);
+    connect(m_eventStore, &EventStore::storeError, this, [this](const QString& error) {
+        m_view->addEventMessage("error", error);
+    });
+    if (!m_eventStore->open()) {
+        m_view->addEventMessage("error", "事件数据库打开失败，报警记录将不会保存");
+    }
+    
+    // 打开方案数据库，方案在内存中建立索引，方案窗口每次打开时不再重新加载
+    m_planStore = new PlanStore(this);
+    if (!m_planStore->open()) {
+        m_view->addEventMessage("error", m_planStore->lastError());
+    }
+    
+    // 报警图片保存和报警/检测事件入库
+    QString sourcePath = QString(__FILE__).section('/', 0, -2); // 获取源码目录路径
+    m_alarms = new AlarmEngine(sourcePath + "/picture/alarm-picture", m_eventStore, this);
+    
+    // 启动指标服务，供监控系统抓取运行状态（默认只监听本机）
+    m_metricsServer = new MetricsHttpServer(this);
+    m_metricsServer->addCollector([this](MetricsText& out) { collectMetrics(out); });
+    if (!m_metricsServer->start()) {
+        m_view->addEventMessage("warning", m_metricsServer->lastError());
+    }
+    
+    // 最后一帧用于抓拍和报警图片，只计入内存预算，不回收
+    FrameMemoryBudget::instance()->addOwner(this, "controller");
+    m_lastImageSlot = FrameMemoryBudget::instance()->slot(this, 0);
+    
     // 初始化多路流连接
     initMultiStreamConnections();
 }
 
 Controller::~Controller()
 {
+    FrameMemoryBudget::instance()->removeOwner(this);
+
     // 如果正在录制，先停止录制
-    if (m_isRecording) {
+    if (m_recorder.isRecording()) {
         stopRecording();
     }
     
-    m_model->stopStream();
-    m_model->wait();
+    m_model->stopStream(); // 只取消订阅，解码线程由会话缓存统一回收
+    
+    // 写完队列中剩余的事件再退出
+    if (m_eventStore) {
+        m_eventStore->close();
+    }
 }
 
 void Controller::setTcpServer(Tcpserver* tcpServer)
@@ -64,6 +106,7 @@ void Controller::setTcpServer(Tcpserver* tcpServer)
     if (tcpWin) {
         connect(tcpWin, &Tcpserver::tcpClientConnected, this, &Controller::onTcpClientConnected);
         connect(tcpWin, &Tcpserver::detectionDataReceived, this, &Controller::onDetectionDataReceived);
+        connect(tcpWin, &Tcpserver::detectionObjectsReceived, this, &Controller::onDetectionObjectsReceived);
     }
 }
 
@@ -95,19 +138,22 @@ void Controller::onAddCameraClicked()
     }
 
     // 启动视频流
+    m_currentUrl = url;
     m_model->startStream(url);
 }
 
-void Controller::onFrameReady(const QImage& img)
+void Controller::onFrameReady(const QImage& img, const FrameTiming& timing)
 {
     if (!img.isNull())
     {
         m_lastImage = img; // 保存最近一帧图像
+        m_lastTiming = timing;
+        m_lastImageSlot->track(m_lastImage, true);
         m_view->getVideoLabel()->setPixmap(QPixmap::fromImage(img).scaled(m_view->getVideoLabel()->size(), Qt::KeepAspectRatio));
         
-        // 如果正在录制，写入视频帧
-        if (m_isRecording) {
-            writeVideoFrame(img);
+        // 如果正在录制，写入视频帧（按时间戳补帧/丢帧）
+        if (m_recorder.isRecording()) {
+            m_recorder.writeFrame(img, timing);
         }
     }
 }
@@ -134,27 +180,18 @@ void Controller::saveImage()
     }
 }
 
-void Controller::saveAlarmImage(const QString& detectionInfo)
+void Controller::saveAlarmImage(const QString& stream, const QImage& image, const FrameTiming& timing,
+                                const QString& detectionInfo)
 {
-    if (m_lastImage.isNull()) {
+    if (image.isNull()) {
         qDebug() << "警告：当前没有可保存的图像！";
         m_view->addEventMessage("warning", "检测到目标但当前没有可保存的图像！");
         return;
     }
     
-    // 确保报警图片目录存在（使用源码路径）
-    QString sourcePath = QString(__FILE__).section('/', 0, -2); // 获取源码目录路径
-    QDir dir(sourcePath + "/picture/alarm-picture");
-    if (!dir.exists()) {
-        dir.mkpath("."); // 创建目录
-    }
-    
-    // 生成报警图片文件名，包含时间戳和检测信息
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz");
-    QString fileName = dir.filePath(QString("ALARM_%1.jpg").arg(timestamp));
-    
-    // 保存图像
-    if (m_lastImage.save(fileName)) {
+    // 保存报警图片并记录报警事件
+    QString fileName = m_alarms->saveAlarm(image, stream, detectionInfo, timing.captureMs);
+    if (!fileName.isEmpty()) {
         QString successMsg = QString("检测到目标，报警图片已保存: %1").arg(fileName);
         qDebug() << successMsg;
         m_view->addEventMessage("alarm", successMsg);
@@ -207,7 +244,7 @@ void Controller::ButtonClickedHandler()
     case 2:
         qDebug() << "录制";
         // 切换录制状态
-        if (!m_isRecording) {
+        if (!m_recorder.isRecording()) {
             startRecording();
         } else {
             stopRecording();
@@ -458,7 +495,7 @@ void Controller::FunButtonClickedHandler()
         {
             // 创建或显示方案预选窗口
             if (!m_plan) {
-                m_plan = new Plan();
+                m_plan = new Plan(m_planStore);
                 m_plan->setAttribute(Qt::WA_DeleteOnClose); // 关闭时自动释放
                 // 连接方案应用信号到Controller的槽函数
                 connect(m_plan, &Plan::planApplied,
@@ -652,10 +689,27 @@ void Controller::onPlanApplied(const PlanData& plan)
 {
     qDebug() << "Controller接收到方案应用信号:" << plan.name;
     
+    // 多路方案整体应用，不走单路流程
+    if (plan.isMultiStream()) {
+        applyWallPlan(plan);
+        return;
+    }
+    
+    // 单路方案在多路模式下先切回单路显示
+    if (m_isMultiStreamMode) {
+        m_view->setGridNumber(1);
+    }
+    
     // 应用RTSP地址 - 自动启动视频流
     if (!plan.rtspUrl.isEmpty()) {
-        m_model->startStream(plan.rtspUrl);
-        m_view->addEventMessage("info", QString("已设置RTSP地址: %1").arg(plan.rtspUrl));
+        if (plan.rtspUrl == m_currentUrl && m_model->isStreaming()) {
+            // 地址未变化时保留现有连接，只下发功能配置
+            m_view->addEventMessage("info", QString("RTSP地址未变化，继续使用当前连接: %1").arg(plan.rtspUrl));
+        } else {
+            m_currentUrl = plan.rtspUrl;
+            m_model->startStream(plan.rtspUrl);
+            m_view->addEventMessage("info", QString("已设置RTSP地址: %1").arg(plan.rtspUrl));
+        }
     }
     
     // 获取功能按钮列表
@@ -759,13 +813,49 @@ void Controller::onDetectionDataReceived(const QString& detectionData)
     // 记录检测事件到消息系统（直接显示处理后的数据）
     m_view->addEventMessage("info", QString("🎯 检测到目标: %1").arg(detectionData));
     
-    // 调用报警图像保存函数
-    saveAlarmImage(detectionData);
+    // 报警图片在随后的检测明细到达时，按上报设备对应的视频流保存
+    m_lastDetectionSummary = detectionData;
+}
+
+void Controller::onDetectionObjectsReceived(const QString& sourceHost, const QVector<DetectionObject>& objects)
+{
+    // 检测数据不带通道号：按上报设备的IP在单路画面和多路网格中查找视频流（与无界面服务相同），
+    // 没有匹配时以设备IP作为视频流标识，不归到当前单路画面
+    QString stream = sourceHost;
+    QImage image;
+    FrameTiming timing;
+    bool matched = false;
+    MultiStreamController* streamController = m_view->getStreamController();
+    if (m_model->isStreaming() && AlarmEngine::matchStreamHost(sourceHost, QStringList() << m_currentUrl) >= 0) {
+        matched = true;
+        stream = m_currentUrl;
+        image = m_lastImage;
+        timing = m_lastTiming;
+    } else if (streamController) {
+        const QList<MultiStreamController::StreamInfo> infos = streamController->getAllStreamInfo();
+        QStringList urls;
+        for (const MultiStreamController::StreamInfo& info : infos) {
+            urls.append(info.url);
+        }
+        int index = AlarmEngine::matchStreamHost(sourceHost, urls);
+        if (index >= 0) {
+            matched = true;
+            stream = infos[index].profile.recordUrl();   // 与放大到单路画面时的标识一致
+            image = streamController->getCurrentFrame(infos[index].handle, &timing);
+        }
+    }
+
+    m_alarms->recordDetections(stream, objects);
+    if (!matched) {
+        m_view->addEventMessage("warning", QString("没有与设备%1对应的视频流，报警图片未保存").arg(sourceHost));
+        return;
+    }
+    saveAlarmImage(stream, image, timing, m_lastDetectionSummary);
 }
 
 void Controller::startRecording()
 {
-    if (m_isRecording) {
+    if (m_recorder.isRecording()) {
         qDebug() << "已经在录制中";
         return;
     }
@@ -776,71 +866,46 @@ void Controller::startRecording()
         return;
     }
 
-    // 确保picture/save-video文件夹存在（参考截图功能的实现）
+    // 录像保存在picture/save-video文件夹（参考截图功能的实现）
     QString sourcePath = QString(__FILE__).section('/', 0, -2); // 获取源码目录路径
-    QDir dir(sourcePath + "/picture/save-video");
-    if (!dir.exists()) {
-        dir.mkpath("."); // 创建目录
-    }
-
-    // 生成录制文件名
-    m_recordFileName = dir.filePath(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz") + ".mp4");
-
-    // 初始化视频写入器
-    cv::Size videoSize(m_lastImage.width(), m_lastImage.height());
-    m_videoWriter = new cv::VideoWriter(m_recordFileName.toStdString(), 
-                                       cv::VideoWriter::fourcc('X','2','6','4'), 
-                                       25.0, // 25 FPS
-                                       videoSize);
-
-    if (!m_videoWriter->isOpened()) {
-        QMessageBox::critical(m_view, "录制失败", "无法创建视频文件！");
-        m_view->addEventMessage("error", "无法创建视频文件！");
-        delete m_videoWriter;
-        m_videoWriter = nullptr;
+    QString fileName = StreamRecorder::makeFileName(sourcePath + "/picture/save-video");
+
+    // 按视频流的实际帧率录制（未知时为25fps）
+    if (!m_recorder.start(fileName, m_lastImage.size(), m_model->frameRate())) {
+        QMessageBox::critical(m_view, "录制失败", m_recorder.lastError());
+        m_view->addEventMessage("error", m_recorder.lastError());
         return;
     }
 
-    m_isRecording = true;
-    QMessageBox::information(m_view, "录制开始", "视频录制已开始！\n保存路径: " + m_recordFileName);
-    m_view->addEventMessage("success", "视频录制已开始！保存路径: " + m_recordFileName);
-    qDebug() << "开始录制视频到:" << m_recordFileName;
+    QMessageBox::information(m_view, "录制开始", "视频录制已开始！\n保存路径: " + fileName);
+    m_view->addEventMessage("success", "视频录制已开始！保存路径: " + fileName);
 }
 
 void Controller::stopRecording()
 {
-    if (!m_isRecording) {
+    if (!m_recorder.isRecording()) {
         qDebug() << "当前没有在录制";
         return;
     }
 
-    m_isRecording = false;
-    
-    if (m_videoWriter) {
-        m_videoWriter->release();
-        delete m_videoWriter;
-        m_videoWriter = nullptr;
-    }
+    m_recorder.stop();
 
-    QMessageBox::information(m_view, "录制完成", "视频录制已完成！\n保存路径: " + m_recordFileName);
-    m_view->addEventMessage("success", "视频录制已完成！保存路径: " + m_recordFileName);
-    qDebug() << "录制完成，文件保存到:" << m_recordFileName;
+    QString fileName = m_recorder.fileName();
+    QMessageBox::information(m_view, "录制完成", "视频录制已完成！\n保存路径: " + fileName);
+    m_view->addEventMessage("success", "视频录制已完成！保存路径: " + fileName);
 }
 
-void Controller::writeVideoFrame(const QImage& frame)
+void Controller::collectMetrics(MetricsText& out)
 {
-    if (!m_isRecording || !m_videoWriter || frame.isNull()) {
-        return;
+    m_alarms->collectMetrics(out);
+    if (tcpWin) {
+        tcpWin->core()->collectMetrics(out);
     }
+    m_recorder.collectMetrics(out);
 
-    // 将QImage转换为cv::Mat
-    QImage rgbImage = frame.rgbSwapped(); // Qt默认为BGRA，OpenCV为RGBA
-    cv::Mat mat(rgbImage.height(), rgbImage.width(), CV_8UC3, (void*)rgbImage.constBits(), rgbImage.bytesPerLine());
-    cv::Mat bgrMat;
-    cv::cvtColor(mat, bgrMat, cv::COLOR_RGB2BGR);
-
-    // 写入视频帧
-    m_videoWriter->write(bgrMat);
+    // 截图、报警图片和录像所在磁盘的剩余空间
+    QString sourcePath = QString(__FILE__).section('/', 0, -2); // 获取源码目录路径
+    MetricsHttpServer::collectStorageMetrics(out, sourcePath + "/picture");
 }
 
 // 初始化多路流连接
@@ -851,6 +916,12 @@ void Controller::initMultiStreamConnections()
     connect(m_view, &View::gridLayoutChanged, this, &Controller::onGridLayoutChanged);
     connect(m_view, &View::streamAdded, this, &Controller::onStreamAdded);
     connect(m_view, &View::streamRemoved, this, &Controller::onStreamRemoved);
+    
+    // 选中网格中的画面：单路画面订阅同一个解码会话，切回单路模式时立即显示
+    MultiStreamController* streamController = m_view->getStreamController();
+    if (streamController) {
+        connect(streamController, &MultiStreamController::videoSelected, this, &Controller::onGridVideoSelected);
+    }
 }
 
 // 视频显示模式改变槽函数
@@ -874,10 +945,44 @@ void Controller::onVideoDisplayModeChanged(bool multiMode)
 // 网格布局改变槽函数
 void Controller::onGridLayoutChanged(int gridNum)
 {
+    // 网格中的会话按格子大小输出，单路画面订阅的会话仍为原始分辨率
+    QSize tileSize;
+    VideoGridWidget* videoGrid = m_view->getVideoGrid();
+    if (videoGrid && gridNum > 1) {
+        int columns = qCeil(qSqrt(gridNum));
+        tileSize = QSize(videoGrid->width() / columns, videoGrid->height() / columns);
+    }
+    StreamSessionCache::instance()->setTileSize(tileSize);
+    
     m_view->addEventMessage("info", QString("网格布局改变为: %1路").arg(gridNum));
     qDebug() << "网格布局改变为:" << gridNum << "路";
 }
 
+// 网格画面选中槽函数
+void Controller::onGridVideoSelected(int globalIndex, StreamHandle handle)
+{
+    Q_UNUSED(globalIndex);
+    MultiStreamController* streamController = m_view->getStreamController();
+    if (!streamController) {
+        return;
+    }
+    // 单路画面和录像使用主码流；大布局下网格已在解码主码流，切换时直接共享该会话
+    QString url = streamController->getStreamInfo(handle).profile.recordUrl();
+    if (url.isEmpty()) {
+        return;
+    }
+    
+    m_currentUrl = url;
+    m_selectedGridHandle = handle;
+    if (!m_isMultiStreamMode) {
+        m_model->startStream(url);
+        if (m_paused) {
+            m_model->pauseStream();
+        }
+    }
+    // 多路模式下只记录选择，切回单路模式时再订阅，避免在后台多开一路主码流
+}
+
 // 视频流添加槽函数
 void Controller::onStreamAdded(const QString& url)
 {
@@ -886,7 +991,7 @@ void Controller::onStreamAdded(const QString& url)
 }
 
 // 视频流移除槽函数
-void Controller::onStreamRemoved(int handle)
+void Controller::onStreamRemoved(StreamHandle handle)
 {
     m_view->addEventMessage("info", QString("移除视频流，句柄: %1").arg(handle));
     qDebug() << "移除视频流，句柄:" << handle;
@@ -895,9 +1000,27 @@ void Controller::onStreamRemoved(int handle)
 // 处理单路模式逻辑
 void Controller::handleSingleStreamMode()
 {
-    // 在单路模式下，继续使用现有的Model进行RTSP流处理
-    // 暂停多路流管理器（如果有的话）
     MultiStreamManager* streamManager = m_view->getStreamManager();
+    
+    // 先恢复单路订阅再暂停网格，共享的会话不会中途停止解码
+    if (m_model && !m_currentUrl.isEmpty() && m_model->currentUrl() != m_currentUrl) {
+        // 网格中选中了另一路：先显示该格子的最后一帧，主码流的帧到达后替换
+        QImage gridFrame = streamManager ? streamManager->getCurrentFrame(m_selectedGridHandle) : QImage();
+        if (!gridFrame.isNull()) {
+            m_lastImage = gridFrame;
+            m_lastTiming = streamManager->getCurrentFrameTiming(m_selectedGridHandle);
+            m_lastImageSlot->track(m_lastImage, true);
+            m_view->getVideoLabel()->setPixmap(QPixmap::fromImage(gridFrame).scaled(m_view->getVideoLabel()->size(), Qt::KeepAspectRatio));
+        }
+        m_model->startStream(m_currentUrl);
+        if (m_paused) {
+            m_model->pauseStream();
+        }
+    } else if (m_model && !m_paused) {
+        m_model->resumeStream();
+    }
+    
+    // 暂停多路流管理器（如果有的话）
     if (streamManager) {
         streamManager->pauseAllStreams();
     }
@@ -908,17 +1031,101 @@ void Controller::handleSingleStreamMode()
 // 处理多路模式逻辑
 void Controller::handleMultiStreamMode()
 {
-    // 在多路模式下，暂停单路模式的流
-    if (m_model) {
-        m_model->stopStream(); // 停止单路RTSP连接
-    }
-    
-    // 恢复多路流管理器
+    // 先恢复网格再暂停单路订阅；单路画面保留会话引用，切回单路模式时不需要重新连接
     MultiStreamManager* streamManager = m_view->getStreamManager();
     if (streamManager) {
         streamManager->resumeAllStreams();
     }
     
+    if (m_model) {
+        m_model->pauseStream();
+    }
+    
     qDebug() << "切换到多路模式";
 }
 
+// 应用多路方案：一次切换网格、并行打开全部视频流、按设备批量下发配置
+void Controller::applyWallPlan(const PlanData& plan)
+{
+    MultiStreamController* streamController = m_view->getStreamController();
+    if (!streamController) {
+        m_view->addEventMessage("error", "多路流组件未初始化，无法应用多路方案");
+        return;
+    }
+    
+    // 未指定网格时选择能放下全部视频流的最小网格
+    int gridNum = plan.gridLayout;
+    if (gridNum <= 0) {
+        const int grids[] = {4, 9, 16, 25, 36};
+        gridNum = 36;
+        for (int grid : grids) {
+            if (grid >= plan.streams.size()) {
+                gridNum = grid;
+                break;
+            }
+        }
+    }
+    m_view->setGridNumber(gridNum); // 切换到多路模式，单路流随之停止
+    
+    // 已打开的相同摄像头直接复用，其余视频流由各自的解码线程同时建立连接；按网格大小选择主/子码流
+    QList<CameraProfile> profiles;
+    for (const PlanStream& stream : plan.streams) {
+        profiles.append(stream.profile());
+    }
+    QList<StreamHandle> handles = streamController->applyStreams(profiles);
+    int openedCount = 0;
+    for (StreamHandle handle : handles) {
+        if (handle >= 0) {
+            ++openedCount;
+        }
+    }
+    m_view->addEventMessage("info", QString("多路方案已打开%1/%2路视频流").arg(openedCount).arg(profiles.size()));
+    
+    // 方案级对象列表同步到对象检测窗口
+    m_selectedObjectIds = plan.objectList;
+    if (m_detectList) {
+        m_detectList->setSelectedObjects(m_selectedObjectIds);
+    }
+    
+    if (!(tcpWin && tcpWin->hasConnectedClients())) {
+        m_view->addEventMessage("warning", "应用方案时检测到没有TCP连接，设备配置未下发");
+        return;
+    }
+    
+    // 按设备IP汇总配置指令，每台设备只发送一次。指令不带通道号，方案编辑时已要求同一设备各路配置一致；
+    // 旧方案中仍不一致的以第一路为准，并提示哪些设备的其余通道配置未生效
+    QStringList conflictingHosts = plan.conflictingHosts();
+    if (!conflictingHosts.isEmpty()) {
+        m_view->addEventMessage("warning", QString("以下设备的多路视频流配置不一致，只下发了第一路的配置: %1")
+            .arg(conflictingHosts.join(", ")));
+    }
+    QMap<QString, QStringList> messagesByHost;
+    for (const PlanStream& stream : plan.streams) {
+        QString host = QUrl(stream.rtspUrl).host();
+        if (host.isEmpty() || messagesByHost.contains(host)) {
+            continue;
+        }
+        const QSet<int> objectList = plan.effectiveObjectList(stream);
+        messagesByHost[host] << Tcpserver::formatInfoMessage(DEVICE_CAMERA, CAMERA_AI_ENABLE, stream.aiEnabled ? 1 : 0)
+                             << Tcpserver::formatInfoMessage(DEVICE_CAMERA, CAMERA_REGION_ENABLE, stream.regionEnabled ? 1 : 0)
+                             << Tcpserver::formatInfoMessage(DEVICE_CAMERA, CAMERA_OBJECT_ENABLE, stream.objectEnabled ? 1 : 0)
+                             << Tcpserver::formatListMessage(objectList);
+    }
+    
+    QStringList offlineHosts;
+    int configuredCount = 0;
+    for (auto it = messagesByHost.constBegin(); it != messagesByHost.constEnd(); ++it) {
+        if (tcpWin->hasClient(it.key())) {
+            tcpWin->Tcp_sent_batch(it.key(), it.value());
+            ++configuredCount;
+        } else {
+            offlineHosts.append(it.key());
+        }
+    }
+    
+    if (!offlineHosts.isEmpty()) {
+        m_view->addEventMessage("warning", QString("以下设备未连接TCP，配置未下发: %1").arg(offlineHosts.join(", ")));
+    }
+    m_view->addEventMessage("success", QString("多路方案 \"%1\" 应用成功，已配置%2台设备")
+        .arg(plan.name).arg(configuredCount));
+}
@@ -5,7 +5,6 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QMessageBox>
-#include <opencv2/opencv.hpp>
 #include "model.h"
 #include "view.h"
 #include "Picture.h"
@@ -14,12 +13,15 @@
 #include "detectlist.h"  // 包含DetectList类
 #include "MultiStreamManager.h"
 #include "MultiStreamController.h"
+#include "EventStore.h"
+#include "PlanStore.h"
+#include "MetricsHttpServer.h"
+#include "AlarmEngine.h"
+#include "StreamRecorder.h"
+#include "FrameMemoryBudget.h"
 
 class Plan; // 前向声明
 
-// 方案数据结构前向声明
-struct PlanData;
-
 class Controller : public QObject {
     Q_OBJECT
 public:
@@ -39,45 +41,58 @@ public slots:
     void onVideoDisplayModeChanged(bool multiMode); // 视频显示模式改变
     void onGridLayoutChanged(int gridNum);           // 网格布局改变
     void onStreamAdded(const QString& url);          // 视频流添加
-    void onStreamRemoved(int handle);                // 视频流移除
+    void onStreamRemoved(StreamHandle handle);       // 视频流移除
+    void onGridVideoSelected(int globalIndex, StreamHandle handle); // 网格中选中画面
 
         
 private slots:
     void onAddCameraClicked();      //添加摄像头槽
-    void onFrameReady(const QImage& img); //视频帧槽
+    void onFrameReady(const QImage& img, const FrameTiming& timing); //视频帧槽
     void onDetectListSelectionChanged(const QSet<int>& selectedIds); //对象列表选择变化槽 
     void onRectangleConfirmed(const RectangleBox& rect);// 处理用户确认的矩形框（绝对坐标），用于目标选定等功能
     // 处理用户确认的矩形框（归一化坐标和绝对坐标），便于后续处理如检测、标注等
     void onNormalizedRectangleConfirmed(const NormalizedRectangleBox& normRect, const RectangleBox& absRect);
     void onPlanApplied(const PlanData& plan); // 处理方案应用槽
     void onDetectionDataReceived(const QString& detectionData); // 新增：处理检测数据接收槽
+    void onDetectionObjectsReceived(const QString& sourceHost, const QVector<DetectionObject>& objects); // 检测对象入库槽
 
 private:
     Model* m_model; //模型指针  
     View* m_view;   //视图指针
     bool m_paused = false; //暂停标志
     QImage m_lastImage; // 保存最近一帧图像
+    FrameTiming m_lastTiming; // 最近一帧的时间（报警图片按采集时刻命名）
+    FrameMemoryBudget::Slot* m_lastImageSlot = nullptr; // 最近一帧在内存预算中的位置
     void saveImage();   // 截图保存函数
-    void saveAlarmImage(const QString& detectionInfo); // 新增：报警图像保存函数
+    void saveAlarmImage(const QString& stream, const QImage& image, const FrameTiming& timing,
+                        const QString& detectionInfo); // 报警图像保存函数
     
     // 录制相关
-    bool m_isRecording = false; // 录制状态标志
-    cv::VideoWriter* m_videoWriter = nullptr; // 视频写入器
-    QString m_recordFileName; // 当前录制文件名
+    StreamRecorder m_recorder; // 视频录制器
     void startRecording(); // 开始录制
     void stopRecording();  // 停止录制
-    void writeVideoFrame(const QImage& frame); // 写入视频帧
     Tcpserver* tcpWin = nullptr; // TCP服务器窗口指针
     DetectList* m_detectList = nullptr; // 对象检测列表窗口指针
     Plan* m_plan = nullptr; // 方案预选窗口指针
     QSet<int> m_selectedObjectIds; // 当前选中的对象ID集合
+    QString m_currentUrl; // 当前播放的RTSP地址（单路画面的视频流标识）
+    QString m_lastDetectionSummary; // 最近一次检测数据的摘要（随后的检测明细信号保存报警图片时使用）
+    EventStore* m_eventStore = nullptr; // 报警/检测事件数据库
+    PlanStore* m_planStore = nullptr; // 方案数据仓库
+    AlarmEngine* m_alarms = nullptr; // 报警图片保存和事件入库
+    
+    // 监控指标（HTTP /metrics 抓取）
+    MetricsHttpServer* m_metricsServer = nullptr; // 指标服务
+    void collectMetrics(MetricsText& out); // 导出报警、录像、TCP等指标
     
     // 功能按钮状态管理
     void updateButtonDependencies(int clickedButtonId, bool isChecked);
     
     // 多路模式支持
     bool m_isMultiStreamMode = false;         // 当前是否为多路模式
+    StreamHandle m_selectedGridHandle = -1;   // 网格中最近选中的视频流句柄
     void initMultiStreamConnections();        // 初始化多路流信号连接
     void handleSingleStreamMode();            // 处理单路模式逻辑
     void handleMultiStreamMode();             // 处理多路模式逻辑
+    void applyWallPlan(const PlanData& plan); // 应用多路方案（整面监控墙）
 };
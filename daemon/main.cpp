@@ -0,0 +1,110 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStandardPaths>
+#include <QDebug>
+#include "RtspEngine.h"
+
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// SIGINT/SIGTERM 通过 socketpair 转到事件循环中退出（信号处理函数里只能做 write）
+static int s_signalFd[2] = { -1, -1 };
+
+static void onQuitSignal(int)
+{
+    char c = 1;
+    ssize_t ret = ::write(s_signalFd[0], &c, sizeof(c));
+    Q_UNUSED(ret);
+}
+
+static void installQuitHandler(QCoreApplication* app)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, s_signalFd) != 0) {
+        qWarning() << "socketpair failed, SIGINT/SIGTERM will not shut down cleanly";
+        return;
+    }
+    QSocketNotifier* notifier = new QSocketNotifier(s_signalFd[1], QSocketNotifier::Read, app);
+    QObject::connect(notifier, &QSocketNotifier::activated, app, [notifier]() {
+        notifier->setEnabled(false);
+        char c;
+        ssize_t ret = ::read(s_signalFd[1], &c, sizeof(c));
+        Q_UNUSED(ret);
+        qInfo() << "收到退出信号，正在停止服务";
+        QCoreApplication::quit();
+    });
+
+    struct sigaction action;
+    action.sa_handler = onQuitSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("rtspd");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("RTSP 无界面服务：解码、录像、设备TCP服务、报警和指标");
+    parser.addHelpOption();
+    QCommandLineOption urlOption(QStringList() << "u" << "url", "接入的视频流地址，可重复指定", "url");
+    QCommandLineOption dataOption(QStringList() << "d" << "data-dir", "报警图片、录像和事件数据库目录", "dir",
+                                  QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    QCommandLineOption tcpAddrOption("tcp-addr", "设备TCP服务监听地址", "address", "0.0.0.0");
+    QCommandLineOption tcpPortOption("tcp-port", "设备TCP服务监听端口，0表示不启动", "port", "8890");
+    QCommandLineOption recordOption(QStringList() << "r" << "record", "录制所有视频流");
+    QCommandLineOption fpsOption("record-fps", "录像帧率，0表示按视频流的实际帧率", "fps", "0");
+    QCommandLineOption segmentOption("segment-minutes", "录像分段时长（分钟），0表示不分段", "minutes", "30");
+    parser.addOptions({ urlOption, dataOption, tcpAddrOption, tcpPortOption, recordOption, fpsOption, segmentOption });
+    parser.addPositionalArgument("urls", "接入的视频流地址（同 --url）", "[url...]");
+    parser.process(app);
+
+    RtspEngineConfig config;
+    config.urls = parser.values(urlOption) + parser.positionalArguments();
+    config.dataDir = parser.value(dataOption);
+    config.record = parser.isSet(recordOption);
+    config.recordFps = parser.value(fpsOption).toDouble();
+    config.recordSegmentMinutes = parser.value(segmentOption).toInt();
+
+    bool ok = false;
+    int port = parser.value(tcpPortOption).toInt(&ok);
+    if (!ok || port < 0 || port > 65535 || !config.tcpAddress.setAddress(parser.value(tcpAddrOption))) {
+        qCritical() << "TCP监听地址或端口无效:" << parser.value(tcpAddrOption) << parser.value(tcpPortOption);
+        return 1;
+    }
+    config.tcpPort = static_cast<quint16>(port);
+    if (config.recordFps < 0) {
+        config.recordFps = 0.0;
+    }
+    if (config.urls.isEmpty()) {
+        qWarning() << "没有指定视频流，只运行设备TCP服务和指标服务";
+    }
+
+    RtspEngine engine;
+    QObject::connect(&engine, &RtspEngine::message, [](const QString& type, const QString& text) {
+        if (type == "error") {
+            qCritical().noquote() << "[error]" << text;
+        } else if (type == "warning") {
+            qWarning().noquote() << "[warning]" << text;
+        } else {
+            qInfo().noquote() << QString("[%1]").arg(type) << text;
+        }
+    });
+    if (!engine.start(config)) {
+        qCritical().noquote() << engine.lastError();
+        return 1;
+    }
+
+#ifdef Q_OS_UNIX
+    installQuitHandler(&app);
+#endif
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &engine, &RtspEngine::stop);
+
+    return app.exec();
+}
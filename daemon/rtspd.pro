@@ -0,0 +1,19 @@
+# RTSP 无界面服务：只包含核心库，在 QCoreApplication 下运行，不链接 QtWidgets
+QT       -= widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = rtspd
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../rtsp_core.pri)
+
+SOURCES += \
+    main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
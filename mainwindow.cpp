@@ -3,6 +3,7 @@
 #include "view.h"
 #include "controller.h"
 #include "Tcpserver.h"
+#include "StreamSessionCache.h"
 #include <QDebug>
 #include <QApplication>
 #include <QIcon>
@@ -47,6 +48,15 @@ MainWindow::~MainWindow()
         delete m_tcpServer;
         m_tcpServer = nullptr;
     }
+
+    // 先释放所有会话的使用者（控制器用到视图和模型，最先释放），再关闭全部会话、等待解码线程退出
+    delete m_controller;
+    m_controller = nullptr;
+    delete m_singleView;
+    m_singleView = nullptr;
+    delete m_model;
+    m_model = nullptr;
+    StreamSessionCache::instance()->closeAll();
 }
 
 void MainWindow::setupUI()
@@ -1,46 +1,40 @@
 #pragma once
 #include <QObject>
 #include <QImage>
-#include <QThread>
-#include <QMutex>
-#include <QWaitCondition>
+#include <QString>
+#include "FramePacer.h"
 
-extern "C" {
-#include <libavformat/avformat.h>
-#include <libswscale/swscale.h>
-}
+class MultiStreamDecoder;
 
-class Model : public QThread {
+// 单路画面的视频源：不再单独解码，而是订阅StreamSessionCache中按URL共享的解码会话，
+// 与多路网格使用同一个解码线程。播放中的单路画面是"焦点"订阅者，会话按全分辨率输出。
+// 解码帧先经过抖动缓冲，按帧时间戳均匀地输出。
+class Model : public QObject {
     Q_OBJECT
 
 public:
     explicit Model(QObject* parent = nullptr); // 构造函数，初始化Model对象
-    ~Model();                                  // 析构函数，释放资源
-    void startStream(const QString& url);      // 启动视频流线程，传入RTSP地址
-    void stopStream();                         // 停止视频流线程
-    void pauseStream();                        // 暂停视频流
+    ~Model();                                  // 析构函数，释放订阅
+    void startStream(const QString& url);      // 订阅指定RTSP地址的解码会话（地址未变时不重新连接）
+    void stopStream();                         // 取消订阅
+    void pauseStream();                        // 暂停视频流（不再输出帧，会话交给其他订阅者或暂停）
     void resumeStream();                       // 恢复视频流
+    QString currentUrl() const;                // 当前RTSP地址
+    bool isStreaming() const;                  // 是否正在播放
+    double frameRate() const;                  // 视频流的实际帧率（按帧时间戳估计），未知时返回0
 
 signals:
-    void frameReady(const QImage& img);        // 视频帧准备好时发出信号，传递QImage
+    void frameReady(const QImage& img, const FrameTiming& timing); // 视频帧准备好时发出信号，附带帧时间
 
-protected:
-    void run() override;                       // 线程主函数，处理视频流解码
+private slots:
+    void onDecoderFrame(const QImage& frame, const FrameTiming& timing); // 转发共享会话的解码帧
+    void onDecoderError(const QString& error); // 会话打开失败
 
 private:
-    // 打开RTSP流，获取AVFormatContext
-    bool openStream(const QString& url, AVFormatContext*& fmt_ctx);
-    // 查找视频流索引
-    int findVideoStream(AVFormatContext* fmt_ctx);
-    // 打开解码器，获取AVCodecContext
-    bool openDecoder(AVFormatContext* fmt_ctx, int videoStream, AVCodecContext*& codec_ctx);
-    // 读取并解码视频帧，转换为QImage并发送信号
-    void readAndDecodeFrames(AVFormatContext* fmt_ctx, AVCodecContext* codec_ctx, int videoStream);
-    // 释放所有相关资源
-    void cleanup(AVFormatContext* fmt_ctx, AVCodecContext* codec_ctx, AVFrame* frame, AVFrame* rgbFrame, uint8_t* buffer, SwsContext* sws_ctx);
+    void setActive(bool active);               // 切换焦点订阅状态
+
+    MultiStreamDecoder* m_decoder = nullptr;   // 共享解码会话
+    FramePacer m_pacer;                        // 抖动缓冲
     QString m_url;             // RTSP流地址
-    bool m_stop;               // 停止标志
     bool m_pause = false;      // 暂停标志
-    QMutex m_mutex;            // 互斥锁，保证多线程安全
-    QWaitCondition m_wait;     // 条件变量，用于线程等待和唤醒
-}; 
+};
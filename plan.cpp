@@ -2,43 +2,43 @@
 #include "detectlist.h"
 #include <QApplication>
 #include <QHeaderView>
-#include <QDir>
-#include <QStandardPaths>
+#include <QRegularExpression>
+#include <algorithm>
+#include <functional>
 #include <QDebug>
 
-Plan::Plan(QWidget *parent)
+Plan::Plan(PlanStore* store, QWidget *parent)
     : QDialog(parent)
+    , m_store(store)
     , m_currentPlanIndex(-1)
     , m_formModified(false)
 {
     setWindowTitle("方案预选");
     setWindowIcon(QIcon(":icon/list.png"));
-    resize(800, 600);
+    resize(900, 720);
     
     // 初始化界面
     initUI();
     
-    // 初始化数据库
-    initDatabase();
-    
-    // 加载数据
-    loadPlansFromDatabase();
+    // 数据库打开失败时提示错误，界面仍可编辑但无法保存
+    if (!m_store->isOpen()) {
+        QMessageBox::critical(this, "数据库错误", m_store->lastError());
+    }
     
     // 如果没有方案，创建默认方案
-    if (m_plans.isEmpty()) {
+    if (m_store->isOpen() && m_store->count() == 0) {
         createDefaultPlans();
     }
     
+    // 从内存索引复制一份方案列表，不再访问数据库
+    m_plans = m_store->plans();
+    
     // 更新界面
     updatePlanList();
 }
 
 Plan::~Plan()
 {
-    // 关闭数据库连接
-    if (m_database.isOpen()) {
-        m_database.close();
-    }
 }
 
 void Plan::initUI()
@@ -223,6 +223,60 @@ void Plan::initUI()
     objectWidget->setLayout(objectLayout);
     configLayout->addWidget(objectWidget, 3, 1);
     
+    // 多路方案：画面布局
+    configLayout->addWidget(new QLabel("画面布局:"), 4, 0);
+    m_gridCombo = new QComboBox();
+    m_gridCombo->addItem("按视频流数量自动选择", 0);
+    m_gridCombo->addItem("4路 (2x2)", 4);
+    m_gridCombo->addItem("9路 (3x3)", 9);
+    m_gridCombo->addItem("16路 (4x4)", 16);
+    m_gridCombo->addItem("25路 (5x5)", 25);
+    m_gridCombo->addItem("36路 (6x6)", 36);
+    configLayout->addWidget(m_gridCombo, 4, 1);
+    
+    // 多路方案：视频流列表，为空时按上方RTSP地址作为单路方案应用
+    configLayout->addWidget(new QLabel("多路视频流:"), 5, 0, Qt::AlignTop);
+    QVBoxLayout* streamLayout = new QVBoxLayout();
+    
+    m_streamTable = new QTableWidget(0, 6);
+    m_streamTable->setHorizontalHeaderLabels(QStringList() << "RTSP地址(子码流)" << "主码流地址(可空)" << "AI" << "区域" << "对象" << "对象ID(空=沿用方案)");
+    m_streamTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_streamTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    for (int column = 2; column < 6; ++column) {
+        m_streamTable->horizontalHeader()->setSectionResizeMode(column, QHeaderView::ResizeToContents);
+    }
+    m_streamTable->verticalHeader()->setVisible(true);
+    m_streamTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_streamTable->setMinimumHeight(160);
+    
+    QHBoxLayout* streamButtonLayout = new QHBoxLayout();
+    m_addStreamButton = new QPushButton("添加视频流");
+    m_removeStreamButton = new QPushButton("移除选中");
+    QString streamButtonStyle =
+        "QPushButton {"
+        "  font-family: 'Microsoft YaHei';"
+        "  font-size: 12px;"
+        "  background: #2196F3;"
+        "  color: white;"
+        "  border: none;"
+        "  border-radius: 4px;"
+        "  padding: 6px 12px;"
+        "}"
+        "QPushButton:hover { background: #1976D2; }"
+        "QPushButton:pressed { background: #1565C0; }";
+    m_addStreamButton->setStyleSheet(streamButtonStyle);
+    m_removeStreamButton->setStyleSheet(streamButtonStyle);
+    streamButtonLayout->addWidget(m_addStreamButton);
+    streamButtonLayout->addWidget(m_removeStreamButton);
+    streamButtonLayout->addStretch();
+    
+    streamLayout->addWidget(m_streamTable);
+    streamLayout->addLayout(streamButtonLayout);
+    
+    QWidget* streamWidget = new QWidget();
+    streamWidget->setLayout(streamLayout);
+    configLayout->addWidget(streamWidget, 5, 1);
+    
     rightLayout->addWidget(configGroup);
     
     // 底部操作按钮
@@ -321,6 +375,10 @@ void Plan::initUI()
     connect(m_aiCheckBox, &QCheckBox::toggled, this, &Plan::onFormDataChanged);
     connect(m_regionCheckBox, &QCheckBox::toggled, this, &Plan::onFormDataChanged);
     connect(m_objectCheckBox, &QCheckBox::toggled, this, &Plan::onFormDataChanged);
+    connect(m_gridCombo, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &Plan::onFormDataChanged);
+    connect(m_streamTable, &QTableWidget::itemChanged, this, &Plan::onFormDataChanged);
+    connect(m_addStreamButton, &QPushButton::clicked, this, &Plan::onAddStream);
+    connect(m_removeStreamButton, &QPushButton::clicked, this, &Plan::onRemoveStream);
     
     // 设置统一的输入框样式
     QString lineEditStyle = 
@@ -381,177 +439,6 @@ void Plan::initUI()
     enableFormControls(false);
 }
 
-void Plan::initDatabase()
-{
-    // 获取应用程序数据目录 - 使用Qt标准路径获取应用专用数据存储位置
-    // 在Linux下通常是 ~/.local/share/<AppName>/
-    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(dataDir);  // 创建目录路径（如果不存在）
-    
-    // 数据库文件路径 - 在应用数据目录下创建plans.db文件
-    QString dbPath = dataDir + "/plans.db";
-    
-    // 创建SQLite数据库连接
-    // 使用命名连接"PlanDB"避免与其他数据库连接冲突
-    m_database = QSqlDatabase::addDatabase("QSQLITE", "PlanDB");
-    m_database.setDatabaseName(dbPath);  // 设置数据库文件路径
-    
-    // 尝试打开数据库连接
-    if (!m_database.open()) {
-        // 如果打开失败，显示错误信息并返回
-        QMessageBox::critical(this, "数据库错误", 
-            QString("无法打开数据库：%1").arg(m_database.lastError().text()));
-        return;
-    }
-    
-    // 数据库连接成功后，创建数据表
-    createPlanTable();
-}
-
-bool Plan::createPlanTable()
-{
-    // 创建SQL查询对象，绑定到已打开的数据库连接
-    QSqlQuery query(m_database);
-    
-    // 定义创建表的SQL语句 - 使用原始字符串字面量(R"(...)")避免转义字符问题
-    QString createTableSql = R"(
-        CREATE TABLE IF NOT EXISTS plans (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,  -- 主键，自动递增
-            name TEXT NOT NULL UNIQUE,             -- 方案名称，非空且唯一
-            rtsp_url TEXT NOT NULL,                -- RTSP地址，非空
-            ai_enabled INTEGER DEFAULT 0,          -- AI功能开关，0=关闭，1=开启
-            region_enabled INTEGER DEFAULT 0,      -- 区域识别开关，0=关闭，1=开启
-            object_enabled INTEGER DEFAULT 0,      -- 对象识别开关，0=关闭，1=开启
-            object_list TEXT DEFAULT '',           -- 检测对象列表，JSON格式存储
-            created_time DATETIME DEFAULT CURRENT_TIMESTAMP,  -- 创建时间，自动设置
-            updated_time DATETIME DEFAULT CURRENT_TIMESTAMP   -- 更新时间，自动设置
-        )
-    )";
-    
-    // 执行SQL语句创建表
-    if (!query.exec(createTableSql)) {
-        // 如果创建失败，显示错误信息
-        QMessageBox::critical(this, "数据库错误", 
-            QString("创建表失败：%1").arg(query.lastError().text()));
-        return false;
-    }
-    
-    return true;  // 创建成功
-}
-
-bool Plan::loadPlansFromDatabase()
-{
-    // 清空内存中的方案列表，准备重新加载
-    m_plans.clear();
-    
-    // 创建SQL查询对象
-    QSqlQuery query(m_database);
-    
-    // 执行SELECT语句从数据库查询所有方案数据，按ID排序
-    if (!query.exec("SELECT id, name, rtsp_url, ai_enabled, region_enabled, object_enabled, object_list FROM plans ORDER BY id")) {
-        // 查询失败时显示警告
-        QMessageBox::warning(this, "数据库错误", 
-            QString("加载方案失败：%1").arg(query.lastError().text()));
-        return false;
-    }
-    
-    // 遍历查询结果，将每行数据转换为PlanData对象
-    while (query.next()) {
-        PlanData plan;
-        // 按字段索引读取数据并转换为对应类型
-        plan.id = query.value(0).toInt();              // 第0列：id
-        plan.name = query.value(1).toString();         // 第1列：name
-        plan.rtspUrl = query.value(2).toString();      // 第2列：rtsp_url
-        plan.aiEnabled = query.value(3).toBool();      // 第3列：ai_enabled (转为bool)
-        plan.regionEnabled = query.value(4).toBool();  // 第4列：region_enabled (转为bool)
-        plan.objectEnabled = query.value(5).toBool();  // 第5列：object_enabled (转为bool)
-        // 第6列：object_list (JSON字符串转为QSet<int>)
-        plan.objectList = objectListFromJson(query.value(6).toString());
-        
-        // 将转换后的方案对象添加到内存列表
-        m_plans.append(plan);
-    }
-    
-    return true;  // 加载成功
-}
-
-bool Plan::savePlanToDatabase(const PlanData& plan)
-{
-    // 创建SQL查询对象，绑定到数据库连接
-    QSqlQuery query(m_database);
-    
-    // 根据方案ID判断是新增还是更新操作
-    if (plan.id == -1) {
-        // 新增方案 - 当ID为-1时表示是新方案，需要插入到数据库
-        // 使用预处理语句防止SQL注入攻击
-        query.prepare(R"(
-            INSERT INTO plans (name, rtsp_url, ai_enabled, region_enabled, object_enabled, object_list) 
-            VALUES (?, ?, ?, ?, ?, ?)
-        )");
-        // 按顺序绑定参数值
-        query.addBindValue(plan.name);                                    // 方案名称
-        query.addBindValue(plan.rtspUrl);                                 // RTSP地址
-        query.addBindValue(plan.aiEnabled ? 1 : 0);                      // AI开关（布尔转整数）
-        query.addBindValue(plan.regionEnabled ? 1 : 0);                  // 区域识别开关（布尔转整数）
-        query.addBindValue(plan.objectEnabled ? 1 : 0);                  // 对象识别开关（布尔转整数）
-        query.addBindValue(objectListToJson(plan.objectList));           // 对象列表（转换为JSON字符串）
-    } else {
-        // 更新现有方案 - 当ID大于0时表示是已存在的方案，需要更新数据库记录
-        query.prepare(R"(
-            UPDATE plans 
-            SET name=?, rtsp_url=?, ai_enabled=?, region_enabled=?, object_enabled=?, object_list=?, updated_time=CURRENT_TIMESTAMP 
-            WHERE id=?
-        )");
-        // 按顺序绑定更新的参数值
-        query.addBindValue(plan.name);                                    // 方案名称
-        query.addBindValue(plan.rtspUrl);                                 // RTSP地址
-        query.addBindValue(plan.aiEnabled ? 1 : 0);                      // AI开关（布尔转整数）
-        query.addBindValue(plan.regionEnabled ? 1 : 0);                  // 区域识别开关（布尔转整数）
-        query.addBindValue(plan.objectEnabled ? 1 : 0);                  // 对象识别开关（布尔转整数）
-        query.addBindValue(objectListToJson(plan.objectList));           // 对象列表（转换为JSON字符串）
-        query.addBindValue(plan.id);                                     // WHERE条件：方案ID
-    }
-    
-    // 执行预处理的SQL语句
-    if (!query.exec()) {
-        // 如果执行失败，显示错误信息并返回false
-        QMessageBox::warning(this, "保存错误", 
-            QString("保存方案失败：%1").arg(query.lastError().text()));
-        return false;
-    }
-    
-    return true;  // 保存成功
-}
-
-bool Plan::deletePlanFromDatabase(int planId)
-{
-    // 创建SQL查询对象，绑定到数据库连接
-    QSqlQuery query(m_database);
-    
-    // 使用预处理语句删除指定ID的方案记录
-    // 预处理语句可以防止SQL注入攻击，并提高性能
-    query.prepare("DELETE FROM plans WHERE id = ?");
-    query.addBindValue(planId);  // 绑定要删除的方案ID
-    
-    // 执行删除操作
-    if (!query.exec()) {
-        // 如果删除失败，显示错误信息并返回false
-        QMessageBox::warning(this, "删除错误", 
-            QString("删除方案失败：%1").arg(query.lastError().text()));
-        return false;
-    }
-    
-    return true;  // 删除成功
-}
-
-bool Plan::updatePlanInDatabase(const PlanData& plan)
-{
-    // 更新方案到数据库 - 这是savePlanToDatabase的别名方法
-    // 实际上调用savePlanToDatabase来处理更新操作
-    // savePlanToDatabase会根据plan.id判断是插入还是更新
-    return savePlanToDatabase(plan);
-}
-
 void Plan::updatePlanList()
 {
     // 清空列表控件中的所有项目，准备重新加载
@@ -586,6 +473,8 @@ void Plan::updateFormFromPlan(const PlanData& plan)
     m_aiCheckBox->blockSignals(true);
     m_regionCheckBox->blockSignals(true);
     m_objectCheckBox->blockSignals(true);
+    m_gridCombo->blockSignals(true);
+    m_streamTable->blockSignals(true);
     
     // 从PlanData对象更新表单控件的显示内容
     m_nameEdit->setText(plan.name);                     // 设置方案名称
@@ -593,6 +482,8 @@ void Plan::updateFormFromPlan(const PlanData& plan)
     m_aiCheckBox->setChecked(plan.aiEnabled);           // 设置AI功能开关状态
     m_regionCheckBox->setChecked(plan.regionEnabled);   // 设置区域识别开关状态
     m_objectCheckBox->setChecked(plan.objectEnabled);   // 设置对象识别开关状态
+    m_gridCombo->setCurrentIndex(qMax(0, m_gridCombo->findData(plan.gridLayout))); // 设置画面布局
+    updateStreamTable(plan);                            // 设置多路视频流列表
     
     // 更新对象列表显示 - 将对象ID转换为可读的对象名称
     QStringList objectNames = DetectList::getObjectNames();  // 获取所有可检测对象的名称列表
@@ -615,6 +506,8 @@ void Plan::updateFormFromPlan(const PlanData& plan)
     m_aiCheckBox->blockSignals(false);
     m_regionCheckBox->blockSignals(false);
     m_objectCheckBox->blockSignals(false);
+    m_gridCombo->blockSignals(false);
+    m_streamTable->blockSignals(false);
     
     // 重置表单修改标志，表示当前表单内容与数据库一致
     m_formModified = false;
@@ -629,6 +522,8 @@ void Plan::updatePlanFromForm(PlanData& plan)
     plan.aiEnabled = m_aiCheckBox->isChecked();            // 获取AI功能开关状态
     plan.regionEnabled = m_regionCheckBox->isChecked();    // 获取区域识别开关状态
     plan.objectEnabled = m_objectCheckBox->isChecked();    // 获取对象识别开关状态
+    plan.gridLayout = m_gridCombo->currentData().toInt();  // 获取画面布局
+    plan.streams = streamsFromTable();                     // 获取多路视频流列表
     
     // 注意：objectList字段在用户选择对象时已经通过onSelectObjects函数更新
     // 这里不需要再次处理，因为对象列表的更新是通过专门的对象选择对话框完成的
@@ -642,6 +537,8 @@ void Plan::clearForm()
     m_regionCheckBox->setChecked(false);
     m_objectCheckBox->setChecked(false);
     m_objectListEdit->clear();
+    m_gridCombo->setCurrentIndex(0);
+    m_streamTable->setRowCount(0);
     
     m_formModified = false;
     m_saveButton->setEnabled(false);
@@ -655,57 +552,75 @@ void Plan::enableFormControls(bool enabled)
     m_regionCheckBox->setEnabled(enabled);
     m_objectCheckBox->setEnabled(enabled);
     m_selectObjectButton->setEnabled(enabled);
+    m_gridCombo->setEnabled(enabled);
+    m_streamTable->setEnabled(enabled);
+    m_addStreamButton->setEnabled(enabled);
+    m_removeStreamButton->setEnabled(enabled);
     m_applyButton->setEnabled(enabled);
 }
 
-QString Plan::objectListToJson(const QSet<int>& objectList)
+void Plan::updateStreamTable(const PlanData& plan)
 {
-    // 将QSet<int>类型的对象ID集合转换为JSON字符串格式
-    // 这样可以在SQLite数据库中以TEXT字段存储对象列表
-    
-    QJsonArray jsonArray;  // 创建JSON数组对象
-    
-    // 遍历对象ID集合，将每个ID添加到JSON数组中
-    for (int id : objectList) {
-        jsonArray.append(id);  // 将整数ID添加到JSON数组
+    m_streamTable->setRowCount(0);
+    for (const PlanStream& stream : plan.streams) {
+        appendStreamRow(stream);
     }
-    
-    // 将JSON数组转换为JSON文档，然后转换为紧凑格式的字符串
-    // Compact格式去除了不必要的空格，减少存储空间
-    QJsonDocument doc(jsonArray);
-    return doc.toJson(QJsonDocument::Compact);
 }
 
-QSet<int> Plan::objectListFromJson(const QString& jsonString)
+void Plan::appendStreamRow(const PlanStream& stream)
 {
-    // 将JSON字符串格式的对象列表转换回QSet<int>类型
-    // 用于从SQLite数据库中读取对象列表数据
-    
-    QSet<int> objectList;  // 创建空的对象ID集合
-    
-    // 如果JSON字符串为空，直接返回空集合
-    if (jsonString.isEmpty()) {
-        return objectList;
+    int row = m_streamTable->rowCount();
+    m_streamTable->insertRow(row);
+    
+    m_streamTable->setItem(row, 0, new QTableWidgetItem(stream.rtspUrl));
+    m_streamTable->setItem(row, 1, new QTableWidgetItem(stream.mainUrl));
+    
+    // 三个功能开关使用可勾选的单元格
+    const bool flags[3] = { stream.aiEnabled, stream.regionEnabled, stream.objectEnabled };
+    for (int i = 0; i < 3; ++i) {
+        QTableWidgetItem* item = new QTableWidgetItem();
+        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+        item->setCheckState(flags[i] ? Qt::Checked : Qt::Unchecked);
+        m_streamTable->setItem(row, i + 2, item);
     }
     
-    // 尝试解析JSON字符串
-    QJsonDocument doc = QJsonDocument::fromJson(jsonString.toUtf8());
-    
-    // 检查解析后的JSON文档是否为数组格式
-    if (doc.isArray()) {
-        QJsonArray jsonArray = doc.array();  // 获取JSON数组
+    QStringList ids;
+    QList<int> sortedIds = stream.objectList.toList();
+    std::sort(sortedIds.begin(), sortedIds.end());
+    for (int id : sortedIds) {
+        ids.append(QString::number(id));
+    }
+    m_streamTable->setItem(row, 5, new QTableWidgetItem(ids.join(",")));
+}
+
+QList<PlanStream> Plan::streamsFromTable() const
+{
+    QList<PlanStream> streams;
+    for (int row = 0; row < m_streamTable->rowCount(); ++row) {
+        PlanStream stream;
+        QTableWidgetItem* urlItem = m_streamTable->item(row, 0);
+        stream.rtspUrl = urlItem ? urlItem->text().trimmed() : QString();
+        QTableWidgetItem* mainUrlItem = m_streamTable->item(row, 1);
+        stream.mainUrl = mainUrlItem ? mainUrlItem->text().trimmed() : QString();
+        stream.aiEnabled = m_streamTable->item(row, 2)->checkState() == Qt::Checked;
+        stream.regionEnabled = m_streamTable->item(row, 3)->checkState() == Qt::Checked;
+        stream.objectEnabled = m_streamTable->item(row, 4)->checkState() == Qt::Checked;
         
-        // 遍历JSON数组中的每个值
-        for (const QJsonValue& value : jsonArray) {
-            // 检查值是否为数字类型（JSON中的数字都是double类型）
-            if (value.isDouble()) {
-                // 将数字值转换为整数并添加到集合中
-                objectList.insert(value.toInt());
+        // 对象ID以逗号或空格分隔，非法内容忽略
+        QTableWidgetItem* idItem = m_streamTable->item(row, 5);
+        if (idItem) {
+            const QStringList parts = idItem->text().split(QRegularExpression("[,，\\s]+"), Qt::SkipEmptyParts);
+            for (const QString& part : parts) {
+                bool ok = false;
+                int id = part.toInt(&ok);
+                if (ok) {
+                    stream.objectList.insert(id);
+                }
             }
         }
+        streams.append(stream);
     }
-    
-    return objectList;  // 返回转换后的对象ID集合
+    return streams;
 }
 
 void Plan::createDefaultPlans()
@@ -740,14 +655,26 @@ void Plan::createDefaultPlans()
     plan3.objectEnabled = true;
     plan3.objectList = {0, 1, 2, 3, 5, 7}; // 多种对象
     
-    defaultPlans << plan1 << plan2 << plan3;
+    // 方案4：多路监控墙，四个设备同时显示
+    PlanData plan4;
+    plan4.name = "多路监控墙方案";
+    plan4.aiEnabled = true;
+    plan4.objectEnabled = true;
+    plan4.objectList = {0};
+    plan4.gridLayout = 4;
+    for (int i = 0; i < 4; ++i) {
+        PlanStream stream;
+        stream.rtspUrl = QString("rtsp://192.168.1.%1/live/0").arg(130 + i);
+        stream.aiEnabled = true;
+        stream.objectEnabled = true;
+        plan4.streams.append(stream);
+    }
     
-    // 保存到数据库
-    for (const PlanData& plan : defaultPlans) {
-        if (savePlanToDatabase(plan)) {
-            // 重新加载以获取数据库生成的ID
-            loadPlansFromDatabase();
-        }
+    defaultPlans << plan1 << plan2 << plan3 << plan4;
+    
+    // 在一个事务中批量保存，数据库生成的ID直接回填到内存索引
+    if (!m_store->savePlans(defaultPlans)) {
+        QMessageBox::warning(this, "保存错误", m_store->lastError());
     }
 }
 
@@ -829,42 +756,51 @@ void Plan::onSavePlan()
         return;
     }
     
-    // 验证RTSP地址是否为空
-    if (rtspUrl.isEmpty()) {
+    // 验证RTSP地址是否为空（多路方案可以只填写视频流列表）
+    QList<PlanStream> streams = streamsFromTable();
+    if (rtspUrl.isEmpty() && streams.isEmpty()) {
         QMessageBox::warning(this, "保存错误", "RTSP地址不能为空！");
         m_rtspEdit->setFocus();  // 将焦点设置到RTSP地址编辑框
         return;
     }
-    
-    // 检查方案名称是否与其他方案重复（排除当前正在编辑的方案）
-    for (int i = 0; i < m_plans.size(); ++i) {
-        if (i != m_currentPlanIndex && m_plans[i].name == name) {
-            QMessageBox::warning(this, "保存错误", "方案名称已存在，请使用其他名称！");
-            m_nameEdit->setFocus();     // 将焦点设置到名称编辑框
-            m_nameEdit->selectAll();    // 选中所有文本，方便用户重新输入
+    for (int i = 0; i < streams.size(); ++i) {
+        if (streams[i].rtspUrl.isEmpty()) {
+            QMessageBox::warning(this, "保存错误", QString("第%1路视频流的RTSP地址不能为空！").arg(i + 1));
+            m_streamTable->setCurrentCell(i, 0);
             return;
         }
     }
     
+    // 设备配置指令不带通道号：同一设备的多路视频流必须使用相同的AI/区域/对象配置
+    PlanData edited = m_plans[m_currentPlanIndex];
+    updatePlanFromForm(edited);
+    QStringList conflictingHosts = edited.conflictingHosts();
+    if (!conflictingHosts.isEmpty()) {
+        QMessageBox::warning(this, "保存错误",
+            QString("同一设备的多路视频流只能使用相同的AI/区域/对象配置，请统一以下设备的配置：\n%1")
+                .arg(conflictingHosts.join("\n")));
+        return;
+    }
+    
+    // 检查方案名称是否与其他方案重复（排除当前正在编辑的方案），通过名称索引直接查找
+    const PlanData existing = m_store->planByName(name);
+    if (existing.id != -1 && existing.id != m_plans[m_currentPlanIndex].id) {
+        QMessageBox::warning(this, "保存错误", "方案名称已存在，请使用其他名称！");
+        m_nameEdit->setFocus();     // 将焦点设置到名称编辑框
+        m_nameEdit->selectAll();    // 选中所有文本，方便用户重新输入
+        return;
+    }
+    
     // 数据验证通过，将表单数据更新到方案对象中
     updatePlanFromForm(m_plans[m_currentPlanIndex]);
     
-    // 尝试将方案保存到数据库
-    if (savePlanToDatabase(m_plans[m_currentPlanIndex])) {
-        // 保存成功后的处理
-        
-        // 如果是新方案（ID为-1），需要重新从数据库加载以获取自动生成的ID
-        if (m_plans[m_currentPlanIndex].id == -1) {
-            int currentPlanIndex = m_currentPlanIndex;   // 保存当前选中的索引
-            loadPlansFromDatabase();                     // 重新从数据库加载所有方案
-            updatePlanList();                            // 更新方案列表显示
-            m_planListWidget->setCurrentRow(currentPlanIndex);  // 恢复选中状态
-        } else {
-            // 如果是更新现有方案，只需要更新列表项的显示名称
-            QListWidgetItem* item = m_planListWidget->item(m_currentPlanIndex);
-            if (item) {
-                item->setText(m_plans[m_currentPlanIndex].name);  // 更新显示的方案名称
-            }
+    // 尝试将方案保存到数据库，新方案的ID由仓库回填，无需重新加载
+    if (m_store->savePlan(m_plans[m_currentPlanIndex])) {
+        // 保存成功后只需要更新列表项的显示名称和ID
+        QListWidgetItem* item = m_planListWidget->item(m_currentPlanIndex);
+        if (item) {
+            item->setText(m_plans[m_currentPlanIndex].name);
+            item->setData(Qt::UserRole, m_plans[m_currentPlanIndex].id);
         }
         
         // 显示保存成功的提示信息
@@ -873,8 +809,9 @@ void Plan::onSavePlan()
         // 重置表单修改标志和保存按钮状态
         m_formModified = false;
         m_saveButton->setEnabled(false);
+    } else {
+        QMessageBox::warning(this, "保存错误", m_store->lastError());
     }
-    // 如果保存失败，savePlanToDatabase函数内部已经显示了错误信息
 }
 
 void Plan::onDeletePlan()
@@ -895,8 +832,9 @@ void Plan::onDeletePlan()
     // 用户确认删除操作
     if (ret == QMessageBox::Yes) {
         // 如果方案已经保存到数据库（ID不为-1），需要从数据库中删除
-        if (plan.id != -1) {
-            deletePlanFromDatabase(plan.id);  // 从数据库删除记录
+        if (plan.id != -1 && !m_store->removePlan(plan.id)) {
+            QMessageBox::warning(this, "删除错误", m_store->lastError());
+            return;
         }
         
         // 从内存中的方案列表中移除该方案
@@ -931,18 +869,29 @@ void Plan::onApplyPlan()
     const PlanData& plan = m_plans[m_currentPlanIndex];
     
     // 显示应用方案的确认对话框，详细列出将要执行的配置
-    int ret = QMessageBox::question(this, "应用方案", 
-        QString("确定要应用方案 \"%1\" 吗？\n这将会：\n"
-               "• 设置RTSP地址：%2\n"
-               "• 配置AI功能：%3\n"
-               "• 配置区域识别：%4\n"
-               "• 配置对象识别：%5\n"
-               "• 设置检测对象列表")
-        .arg(plan.name)                                        // 方案名称
-        .arg(plan.rtspUrl)                                     // RTSP地址
-        .arg(plan.aiEnabled ? "启用" : "禁用")                  // AI功能状态
-        .arg(plan.regionEnabled ? "启用" : "禁用")              // 区域识别状态
-        .arg(plan.objectEnabled ? "启用" : "禁用"),             // 对象识别状态
+    QString detail;
+    if (plan.isMultiStream()) {
+        detail = QString("确定要应用多路方案 \"%1\" 吗？\n这将会：\n"
+                         "• 切换到%2路画面布局\n"
+                         "• 同时打开%3路视频流（已打开的相同地址直接复用）\n"
+                         "• 向各路设备批量下发AI/区域/对象识别配置")
+            .arg(plan.name)
+            .arg(plan.gridLayout > 0 ? QString::number(plan.gridLayout) : QString("自动"))
+            .arg(plan.streams.size());
+    } else {
+        detail = QString("确定要应用方案 \"%1\" 吗？\n这将会：\n"
+                         "• 设置RTSP地址：%2\n"
+                         "• 配置AI功能：%3\n"
+                         "• 配置区域识别：%4\n"
+                         "• 配置对象识别：%5\n"
+                         "• 设置检测对象列表")
+            .arg(plan.name)                                        // 方案名称
+            .arg(plan.rtspUrl)                                     // RTSP地址
+            .arg(plan.aiEnabled ? "启用" : "禁用")                  // AI功能状态
+            .arg(plan.regionEnabled ? "启用" : "禁用")              // 区域识别状态
+            .arg(plan.objectEnabled ? "启用" : "禁用");             // 对象识别状态
+    }
+    int ret = QMessageBox::question(this, "应用方案", detail,
         QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);  // 默认选择"是"
     
     // 用户确认应用方案
@@ -968,3 +917,42 @@ void Plan::onFormDataChanged()
     m_formModified = true;          // 设置表单修改标志为true
     m_saveButton->setEnabled(true); // 启用保存按钮，提示用户有未保存的修改
 }
+
+void Plan::onAddStream()
+{
+    // 新行默认沿用表单中的RTSP地址和功能开关，方便批量修改通道号
+    PlanStream stream;
+    stream.rtspUrl = m_rtspEdit->text().trimmed();
+    stream.aiEnabled = m_aiCheckBox->isChecked();
+    stream.regionEnabled = m_regionCheckBox->isChecked();
+    stream.objectEnabled = m_objectCheckBox->isChecked();
+    
+    m_streamTable->blockSignals(true);
+    appendStreamRow(stream);
+    m_streamTable->blockSignals(false);
+    
+    m_streamTable->setCurrentCell(m_streamTable->rowCount() - 1, 0);
+    m_streamTable->editItem(m_streamTable->item(m_streamTable->rowCount() - 1, 0));
+    onFormDataChanged();
+}
+
+void Plan::onRemoveStream()
+{
+    // 从下往上删除，避免行号变化
+    QList<int> rows;
+    for (const QModelIndex& index : m_streamTable->selectionModel()->selectedRows()) {
+        rows.append(index.row());
+    }
+    if (rows.isEmpty() && m_streamTable->currentRow() >= 0) {
+        rows.append(m_streamTable->currentRow());
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+    
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    for (int row : rows) {
+        m_streamTable->removeRow(row);
+    }
+    onFormDataChanged();
+}
@@ -0,0 +1,64 @@
+# 核心库：解码、录像、设备TCP服务、报警和指标，不依赖 QtWidgets
+# 界面程序 rtsp.pro 和无界面服务 daemon/rtspd.pro 都包含本文件
+
+QT += core gui network sql
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# 解决FFmpeg与标准库冲突的关键宏定义
+DEFINES += __STDC_CONSTANT_MACROS __STDC_FORMAT_MACROS
+
+SOURCES += \
+    $$PWD/model.cpp \
+    $$PWD/MultiStreamDecoder.cpp \
+    $$PWD/TileScaler.cpp \
+    $$PWD/FrameBufferPool.cpp \
+    $$PWD/FrameMemoryBudget.cpp \
+    $$PWD/FramePacer.cpp \
+    $$PWD/MultiStreamManager.cpp \
+    $$PWD/StreamSessionCache.cpp \
+    $$PWD/DecoderReaper.cpp \
+    $$PWD/StreamMetrics.cpp \
+    $$PWD/MetricsHttpServer.cpp \
+    $$PWD/EventStore.cpp \
+    $$PWD/TcpCommandServer.cpp \
+    $$PWD/StreamRecorder.cpp \
+    $$PWD/AlarmEngine.cpp \
+    $$PWD/RtspEngine.cpp
+
+HEADERS += \
+    $$PWD/common.h \
+    $$PWD/model.h \
+    $$PWD/HandleManager.h \
+    $$PWD/MultiStreamDecoder.h \
+    $$PWD/TileScaler.h \
+    $$PWD/FrameBufferPool.h \
+    $$PWD/FrameMemoryBudget.h \
+    $$PWD/FrameTiming.h \
+    $$PWD/FramePacer.h \
+    $$PWD/MultiStreamManager.h \
+    $$PWD/StreamSessionCache.h \
+    $$PWD/DecoderReaper.h \
+    $$PWD/StreamMetrics.h \
+    $$PWD/MetricsHttpServer.h \
+    $$PWD/EventStore.h \
+    $$PWD/TcpCommandServer.h \
+    $$PWD/StreamRecorder.h \
+    $$PWD/AlarmEngine.h \
+    $$PWD/RtspEngine.h
+
+# FFmpeg 头文件路径 - 使用更合适的上级目录
+INCLUDEPATH += /usr/include/x86_64-linux-gnu
+
+# FFmpeg 库文件路径
+LIBS += -L/usr/lib/x86_64-linux-gnu
+
+# 链接 FFmpeg 的库
+LIBS += -lavcodec -lavformat -lavutil -lswscale
+
+# OpenCV 头文件路径（录像）
+INCLUDEPATH += /usr/include/opencv4
+
+# 链接 OpenCV 的常用库
+LIBS += -lopencv_core -lopencv_imgproc -lopencv_videoio
@@ -15,12 +15,14 @@
 #include <QPoint>
 #include <QDebug>
 #include <QToolTip>
-#include <QTextBrowser>
+#include <QListView>
+#include <QStandardPaths>
 #include <QDateTime>
 #include <QScrollBar>
+#include "StreamStatsTable.h"
 
 View::View(QWidget* parent)
-    : QWidget(parent), m_hasRectangle(false), m_isMultiStreamMode(false)
+    : QWidget(parent), eventView(nullptr), m_eventLog(nullptr), m_hasRectangle(false), m_isMultiStreamMode(false)
 {
     // 初始化多路流组件
     initMultiStreamComponents();
@@ -100,10 +102,20 @@ void View::initleft()
     );
     eventLabel->setAlignment(Qt::AlignCenter);
 
-    // 创建事件消息文本浏览器
-    eventBrowser = new QTextBrowser(leftPanel);
-    eventBrowser->setStyleSheet(
-        "QTextBrowser {"
+    // 创建事件消息模型：界面只保留最近的消息，完整历史写入日志文件
+    m_eventLog = new EventLogModel(2000, this);
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    m_eventLog->setSpillFile(dataDir + "/events.log");
+
+    // 创建事件消息列表视图
+    eventView = new QListView(leftPanel);
+    eventView->setModel(m_eventLog);
+    eventView->setUniformItemSizes(true);                      // 统一行高，避免逐行测量
+    eventView->setWordWrap(false);
+    eventView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    eventView->setSelectionMode(QAbstractItemView::SingleSelection);
+    eventView->setStyleSheet(
+        "QListView {"
         "  font-family: 'Consolas', 'Monaco', monospace;"
         "  font-size: 12px;"
         "  background-color: #ffffff;"
@@ -113,13 +125,13 @@ void View::initleft()
         "  selection-background-color: #3399ff;"
         "}"
     );
-    eventBrowser->setMinimumHeight(200);
-    eventBrowser->setMinimumWidth(160); // 设置文本浏览器最小宽度
+    eventView->setMinimumHeight(200);
+    eventView->setMinimumWidth(160); // 设置消息列表最小宽度
 
 
     // 将控件添加到左侧布局
     leftLayout->addWidget(eventLabel);
-    leftLayout->addWidget(eventBrowser);
+    leftLayout->addWidget(eventView);
     //leftLayout->addStretch(); // 添加弹性空间
 }
 
@@ -516,46 +528,20 @@ bool View::isDrawingEnabled() const
     return false;
 }
 
-// 添加事件消息到文本浏览器
+// 添加事件消息到消息列表
 void View::addEventMessage(const QString& type, const QString& message)
 {
-    if (!eventBrowser) return;
-
-    QString color;
-    QString prefix;
-
-    // 根据消息类型设置颜色和前缀
-    if (type == "error") {
-        color = "#cc0000";
-        prefix = "[错误]";
-    } else if (type == "warning") {
-        color = "#ff8800";
-        prefix = "[警告]";
-    } else if (type == "success") {
-        color = "#008000";
-        prefix = "[成功]";
-    } else if (type == "info") {
-        color = "#0066cc";
-        prefix = "[信息]";
-    } else {
-        color = "#333333";
-        prefix = "[消息]";
-    }
+    if (!m_eventLog) return;
 
-    QString timeStamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-    QString formattedMessage = QString("<span style='color: #666; font-size: 13px;'>[%1]</span> "
-                                      "<span style='color: %2; font-weight: bold;'>%3</span> "
-                                      "<span style='color: %4;'>%5</span>")
-                               .arg(timeStamp)
-                               .arg(color)
-                               .arg(prefix)
-                               .arg(color)
-                               .arg(message);
+    // 仅当用户停留在底部时才自动滚动，避免打断翻看历史消息
+    QScrollBar* scrollBar = eventView->verticalScrollBar();
+    bool atBottom = scrollBar->value() >= scrollBar->maximum();
 
-    eventBrowser->append(formattedMessage);
+    m_eventLog->append(type, message);
 
-    // 自动滚动到底部显示最新消息
-    eventBrowser->verticalScrollBar()->setValue(eventBrowser->verticalScrollBar()->maximum());
+    if (atBottom) {
+        eventView->scrollToBottom();
+    }
 }
 
 // 初始化多路流组件
@@ -654,6 +640,10 @@ void View::initGridControls()
     // 多路流控制按钮
     m_addStreamBtn = new QPushButton("添加流", m_gridControlPanel);
     m_removeStreamBtn = new QPushButton("移除流", m_gridControlPanel);
+    m_statsOverlayCheck = new QCheckBox("统计", m_gridControlPanel);
+    m_statsOverlayCheck->setToolTip("在各画面上显示帧率、码率、解码耗时和延迟");
+    m_statsTableBtn = new QPushButton("统计表", m_gridControlPanel);
+    m_statsTableBtn->setToolTip("以表格查看各路最近一秒的帧率、码率、各阶段耗时和延迟");
     
     // 添加所有组件到布局
     gridLayout->addWidget(m_gridLabel);
@@ -668,6 +658,8 @@ void View::initGridControls()
     gridLayout->addStretch();
     gridLayout->addWidget(m_addStreamBtn);
     gridLayout->addWidget(m_removeStreamBtn);
+    gridLayout->addWidget(m_statsOverlayCheck);
+    gridLayout->addWidget(m_statsTableBtn);
     
     // 连接信号和槽
     connect(m_gridRadio1, &QRadioButton::clicked, this, &View::onGridModeChanged);
@@ -683,6 +675,11 @@ void View::initGridControls()
     
     connect(m_addStreamBtn, &QPushButton::clicked, this, &View::onAddMultiStreamClicked);
     connect(m_removeStreamBtn, &QPushButton::clicked, this, &View::onRemoveMultiStreamClicked);
+    connect(m_statsTableBtn, &QPushButton::clicked, this, &View::onStatsTableClicked);
+    if (m_streamController) {
+        connect(m_statsOverlayCheck, &QCheckBox::toggled,
+                m_streamController, &MultiStreamController::setStatsOverlayEnabled);
+    }
 }
 
 // 更新网格控件可见性
@@ -695,12 +692,16 @@ void View::updateGridControlsVisibility()
             m_pageControlPanel->setVisible(false);
             m_addStreamBtn->setVisible(false);
             m_removeStreamBtn->setVisible(false);
+            m_statsOverlayCheck->setVisible(false);
+            m_statsTableBtn->setVisible(false);
             m_gridControlPanel->setVisible(true); // 保持网格选择可见
         } else {
             // 多路模式：显示所有控件
             m_pageControlPanel->setVisible(true);
             m_addStreamBtn->setVisible(true);
             m_removeStreamBtn->setVisible(true);
+            m_statsOverlayCheck->setVisible(true);
+            m_statsTableBtn->setVisible(true);
             m_gridControlPanel->setVisible(true);
         }
     }
@@ -769,6 +770,22 @@ void View::setVideoDisplayMode(bool multiMode)
     updateGridControlsVisibility();
 }
 
+// 按路数切换网格
+void View::setGridNumber(int gridNum)
+{
+    QRadioButton* radio = m_gridRadio1;
+    switch (gridNum) {
+        case 4: radio = m_gridRadio4; break;
+        case 9: radio = m_gridRadio9; break;
+        case 16: radio = m_gridRadio16; break;
+        case 25: radio = m_gridRadio25; break;
+        case 36: radio = m_gridRadio36; break;
+        default: break;
+    }
+    radio->setChecked(true);
+    onGridModeChanged();
+}
+
 // 添加多路流槽函数
 void View::onAddMultiStreamClicked()
 {
@@ -782,7 +799,7 @@ void View::onAddMultiStreamClicked()
     
     if (ok && !url.isEmpty()) {
         if (m_streamController) {
-            int handle = m_streamController->addStream(url);
+            StreamHandle handle = m_streamController->addStream(url);
             if (handle >= 0) {
                 emit streamAdded(url);
                 addEventMessage("success", "成功添加视频流: " + url);
@@ -799,15 +816,35 @@ void View::onRemoveMultiStreamClicked()
     if (m_streamController) {
         // 获取当前选中的视频索引对应的句柄
         // 这里简化处理，实际应该获取用户选中的流
-        QList<int> handles = m_streamController->getAllStreamHandles();
+        QList<StreamHandle> handles = m_streamController->getAllStreamHandles();
         if (!handles.isEmpty()) {
-            int handle = handles.last(); // 移除最后一个流
+            StreamHandle handle = handles.last(); // 移除最后一个流
             m_streamController->removeStream(handle);
             emit streamRemoved(handle);
         }
     }
 }
 
+// 统计表槽函数
+void View::onStatsTableClicked()
+{
+    if (!m_streamController) {
+        return;
+    }
+    if (!m_statsDialog) {
+        m_statsDialog = new QDialog(this);
+        m_statsDialog->setWindowTitle("流水线统计");
+        m_statsDialog->resize(900, 400);
+        QVBoxLayout* layout = new QVBoxLayout(m_statsDialog);
+        StreamStatsTable* table = new StreamStatsTable(m_statsDialog);
+        table->setStreamController(m_streamController);   // 随控制器每秒一次的统计刷新
+        layout->addWidget(table);
+    }
+    m_statsDialog->show();
+    m_statsDialog->raise();
+    m_statsDialog->activateWindow();
+}
+
 // 分页控制槽函数
 void View::onPrevPageClicked()
 {
@@ -8,7 +8,7 @@
 #include <QPainter>
 #include <QMouseEvent>
 #include <QRect>
-#include <QTextBrowser>
+#include <QListView>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QGridLayout>
@@ -16,11 +16,14 @@
 #include <QSpinBox>
 #include <QStackedWidget>
 #include <QInputDialog>
+#include <QCheckBox>
+#include <QDialog>
 #include "VideoLabel.h"
 #include "VideoGridWidget.h"
 #include "MultiStreamManager.h"
 #include "MultiStreamController.h"
 #include "common.h"
+#include "EventLogModel.h"
 
 class View : public QWidget {
     Q_OBJECT
@@ -40,6 +43,7 @@ public:
     MultiStreamController* getStreamController() const; // 获取流控制器
     bool isMultiStreamMode() const;              // 是否为多路模式
     void setVideoDisplayMode(bool multiMode);    // 设置视频显示模式
+    void setGridNumber(int gridNum);             // 按路数切换网格（1/4/9/16/25/36），与点击单选按钮效果相同
     
     void drawRectangle(const RectangleBox& rect); // 绘制矩形框
     void clearRectangle();                        // 清除矩形框
@@ -59,7 +63,7 @@ signals:
     // 多路模式信号
     void gridLayoutChanged(int gridNum);         // 网格布局改变
     void streamAdded(const QString& url);        // 添加视频流
-    void streamRemoved(int handle);              // 移除视频流
+    void streamRemoved(StreamHandle handle);     // 移除视频流
     void videoDisplayModeChanged(bool multiMode); // 视频显示模式改变
 
 private slots:
@@ -74,6 +78,7 @@ private slots:
     void onPrevPageClicked();                    // 上一页
     void onNextPageClicked();                    // 下一页
     void onPageJumpClicked();                    // 页面跳转
+    void onStatsTableClicked();                  // 打开各路流水线统计表
 
 private:
     void initleft();       // 初始化左边面板
@@ -98,7 +103,8 @@ private:
     QSlider* stepSlider;       //步进滑块
     QComboBox* stepCombox;     //步进下拉框
     QLabel* eventLabel;        //事件消息框标签
-    QTextBrowser* eventBrowser; //事件消息显示框
+    QListView* eventView;      //事件消息显示框
+    EventLogModel* m_eventLog; //事件消息模型（环形缓冲区）
 
     QWidget* leftPanel;    //左边整体面板
     QWidget* funPanel;     //中上方功能面板
@@ -142,4 +148,7 @@ private:
     // 多路流控制组件
     QPushButton* m_addStreamBtn;          // 添加流按钮
     QPushButton* m_removeStreamBtn;       // 移除流按钮
+    QCheckBox* m_statsOverlayCheck;       // 画面叠加流水线统计
+    QPushButton* m_statsTableBtn;         // 打开统计表
+    QDialog* m_statsDialog = nullptr;     // 各路流水线统计表（非模态，首次打开时创建）
 }; 